@@ -17,6 +17,8 @@ SET(APP_HDRS
     source/general/geometry_app.h
     source/general/enumerator_private_app.h
     source/general/enumerator_app.h
+    source/general/parallel_app.hpp
+    source/general/video_stream_app.hpp
     source/computed_field/computed_field_private_app.hpp
     source/three_d_drawing/graphics_buffer_app.h
     source/image_processing/computed_field_sigmoid_image_filter_app.h
@@ -36,6 +38,7 @@ SET(APP_HDRS
     source/image_processing/computed_field_binary_threshold_image_filter_app.h
     source/image_processing/computed_field_threshold_image_filter_app.h
     source/image_processing/computed_field_image_resample_app.h
+    source/image_processing/image_filter_cache_app.hpp
     source/computed_field/computed_field_string_constant_app.h
     source/computed_field/computed_field_deformation_app.h
     source/computed_field/computed_field_finite_element_app.h
@@ -52,24 +55,32 @@ SET(APP_HDRS
     source/computed_field/computed_field_composite_app.h
     source/computed_field/computed_field_compose_app.h
     source/computed_field/computed_field_format_output_app.h
+    source/computed_field/computed_field_graph_app.h
     source/computed_field/computed_field_trigonometry_app.h
     source/computed_field/computed_field_arithmetic_operators_app.h
     source/minimise/minimise_app.h
+    source/finite_element/change_identifiers_app.hpp
+    source/finite_element/export_field_values_app.h
     source/finite_element/export_finite_element_app.h
     source/graphics/element_point_ranges_app.h
     source/graphics/environment_map_app.h
     source/finite_element/finite_element_region_app.h
+    source/finite_element/generate_mesh_netgen_job_app.hpp
+    source/finite_element/mesh_location_index_app.h
     source/graphics/font_app.h
     source/graphics/scene_viewer_app.h
     source/graphics/glyph_app.h
     source/graphics/tessellation_app.hpp
     source/graphics/tessellation_app.hpp
     source/computed_field/computed_field_app.h
+    source/graphics/render_node_cloud_app.hpp
     source/graphics/render_to_finite_elements_app.h
     source/graphics/render_to_finite_elements_app.h
     source/graphics/auxiliary_graphics_types_app.h
     source/finite_element/finite_element_conversion_app.h
     source/graphics/texture_app.h
+    source/graphics/texture_evaluate_app.h
+    source/graphics/texture_raw_volume_app.hpp
     source/graphics/colour_app.h
     source/graphics/scene_app.h
     source/graphics/scenefilter_app.hpp
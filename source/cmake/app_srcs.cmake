@@ -22,6 +22,7 @@ SET(APP_SRCS
     source/image_processing/computed_field_threshold_image_filter_app.cpp
     source/computed_field/computed_field_time_app.cpp
     source/image_processing/computed_field_image_resample_app.cpp
+    source/image_processing/image_filter_cache_app.cpp
     source/computed_field/computed_field_string_constant_app.cpp
     source/computed_field/computed_field_deformation_app.cpp
     source/computed_field/computed_field_finite_element_app.cpp
@@ -40,6 +41,7 @@ SET(APP_SRCS
     source/mesh/cmiss_element_private_app.cpp
     source/computed_field/computed_field_compose_app.cpp
     source/computed_field/computed_field_format_output_app.cpp
+    source/computed_field/computed_field_graph_app.cpp
     source/computed_field/computed_field_trigonometry_app.cpp
     source/computed_field/computed_field_arithmetic_operators_app.cpp
     source/graphics/environment_map_app.cpp
@@ -47,23 +49,31 @@ SET(APP_SRCS
     source/computed_field/computed_field_apply_app.cpp
     source/computed_field/computed_field_coordinate_app.cpp
     source/graphics/element_point_ranges_app.cpp
+    source/finite_element/change_identifiers_app.cpp
+    source/finite_element/export_field_values_app.cpp
     source/finite_element/export_finite_element_app.cpp
+    source/graphics/render_node_cloud_app.cpp
     source/graphics/render_to_finite_elements_app.cpp
     source/finite_element/finite_element_conversion_app.cpp
     source/finite_element/finite_element_app.cpp
     source/finite_element/finite_element_region_app.cpp
+    source/finite_element/generate_mesh_netgen_job_app.cpp
+    source/finite_element/mesh_location_index_app.cpp
     source/graphics/glyph_app.cpp
     source/graphics/graphics_app.cpp
     source/graphics/font_app.cpp
     source/computed_field/computed_field_conditional_app.cpp
     source/graphics/tessellation_app.cpp
     source/graphics/texture_app.cpp
+    source/graphics/texture_evaluate_app.cpp
+    source/graphics/texture_raw_volume_app.cpp
     source/three_d_drawing/graphics_buffer_app.cpp
     source/general/geometry_app.cpp
     source/computed_field/computed_field_app.cpp
     source/computed_field/computed_field_set_app.cpp
     source/general/multi_range_app.cpp
     source/general/cmgui_time.cpp
+    source/general/video_stream_app.cpp
     source/graphics/auxiliary_graphics_types_app.cpp
     source/graphics/light_app.cpp
     source/graphics/scene_app.cpp
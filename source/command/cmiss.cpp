@@ -22,8 +22,12 @@
 #else /* !defined (WIN32_SYSTEM) */
 #  include <unistd.h>
 #endif /* !defined (WIN32_SYSTEM) */
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <ctime>
+#include <limits>
+#include <vector>
 #include "opencmiss/zinc/context.h"
 #include "opencmiss/zinc/element.h"
 #include "opencmiss/zinc/elementbasis.h"
@@ -70,6 +74,7 @@
 #include "finite_element/export_cm_files.h"
 #if defined (ZINC_USE_NETGEN)
 #include "finite_element/generate_mesh_netgen.h"
+#include "finite_element/generate_mesh_netgen_job_app.hpp"
 #endif /* defined (ZINC_USE_NETGEN) */
 #include "finite_element/export_finite_element.h"
 #include "finite_element/finite_element.h"
@@ -141,6 +146,7 @@
 #include "perl_interpreter.h"
 #endif /* defined (USE_PERL_INTERPRETER) */
 #include "user_interface/fd_io.h"
+#include "user_interface/event_dispatcher.h"
 #include "user_interface/idle.h"
 #include "command/cmiss.h"
 #include "mesh/cmiss_element_private.hpp"
@@ -180,12 +186,14 @@
 #include "image_processing/computed_field_binary_threshold_image_filter_app.h"
 #include "image_processing/computed_field_threshold_image_filter_app.h"
 #include "image_processing/computed_field_image_resample_app.h"
+#include "image_processing/image_filter_cache_app.hpp"
 #include "computed_field/computed_field_string_constant_app.h"
 #include "computed_field/computed_field_deformation_app.h"
 #include "computed_field/computed_field_finite_element_app.h"
 #include "computed_field/computed_field_format_output_app.h"
 #include "computed_field/computed_field_vector_operators_app.hpp"
 #include "computed_field/computed_field_matrix_operators_app.hpp"
+#include "computed_field/computed_field_graph_app.h"
 #include "computed_field/computed_field_mesh_operators_app.hpp"
 #include "computed_field/computed_field_nodeset_operators_app.hpp"
 #include "computed_field/computed_field_lookup_app.h"
@@ -200,6 +208,8 @@
 #include "computed_field/computed_field_trigonometry_app.h"
 #include "computed_field/computed_field_scene_viewer_projection_app.h"
 #include "minimise/minimise_app.h"
+#include "finite_element/export_field_values_app.h"
+#include "finite_element/mesh_location_index_app.h"
 #include "finite_element/export_finite_element_app.h"
 #include "graphics/element_point_ranges_app.h"
 #include "graphics/environment_map_app.h"
@@ -212,10 +222,14 @@
 #include "graphics/tessellation_app.hpp"
 #include "computed_field/computed_field_app.h"
 #include "general/enumerator_app.h"
+#include "graphics/render_node_cloud_app.hpp"
 #include "graphics/render_to_finite_elements_app.h"
 #include "graphics/auxiliary_graphics_types_app.h"
+#include "finite_element/change_identifiers_app.hpp"
 #include "finite_element/finite_element_conversion_app.h"
 #include "graphics/texture_app.h"
+#include "graphics/texture_evaluate_app.h"
+#include "graphics/texture_raw_volume_app.hpp"
 #include "graphics/colour_app.h"
 #include "graphics/scene_app.h"
 #include "graphics/spectrum_component_app.h"
@@ -223,6 +237,7 @@
 #include "graphics/material_app.h"
 #include "graphics/spectrum_app.h"
 #include "general/multi_range_app.h"
+#include "general/parallel_app.hpp"
 #include "computed_field/computed_field_set_app.h"
 #include "context/context_app.h"
 #include "three_d_drawing/graphics_buffer_app.h"
@@ -258,6 +273,11 @@ DESCRIPTION :
 	struct Cad_tool *cad_tool;
 #endif /* defined (USE_OPENCASCADE) */
 	struct Event_dispatcher *event_dispatcher;
+#if defined (ZINC_USE_NETGEN)
+	/* tetrahedral meshing running in the background, polled by timeout callback */
+	Generate_netgen_job *generate_netgen_job;
+	struct Event_dispatcher_timeout_callback *generate_netgen_timeout_callback;
+#endif /* defined (ZINC_USE_NETGEN) */
 	struct Node_tool *data_tool,*node_tool;
 	struct Interactive_tool *transform_tool;
 #if defined (USE_PERL_INTERPRETER)
@@ -272,7 +292,11 @@ DESCRIPTION :
 	struct MANAGER(Comfile_window) *comfile_window_manager;
 #endif /* defined (WX_USER_INTERFACE)*/
 	struct cmzn_region *root_region;
+	struct Mesh_location_index_cache *mesh_location_index_cache;
 	struct Computed_field_package *computed_field_package;
+#if defined (ZINC_USE_ITK)
+	Image_filter_package *image_filter_package;
+#endif /* defined (ZINC_USE_ITK) */
 	struct MANAGER(Environment_map) *environment_map_manager;
 	struct MANAGER(FE_basis) *basis_manager;
 	struct LIST(FE_element_shape) *element_shape_list;
@@ -451,7 +475,7 @@ DESCRIPTION :
 	char data_flag, element_flag, face_flag, line_flag, node_flag, *sort_by_field_name;
 	FE_value time;
 	int data_offset, element_offset, face_offset, line_offset, node_offset,
-		return_code;
+		number_of_threads, return_code;
 	struct cmzn_command_data *command_data;
 	struct Computed_field *sort_by_field;
 	struct FE_region *fe_region;
@@ -473,6 +497,7 @@ DESCRIPTION :
 		line_offset = 0;
 		node_flag = 0;
 		node_offset = 0;
+		number_of_threads = -1;
 		sort_by_field_name = NULL;
 		sort_by_field = (struct Computed_field *)NULL;
 		if (command_data->default_time_keeper_app)
@@ -485,6 +510,17 @@ DESCRIPTION :
 		}
 
 		option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Adds offsets to the identifiers of elements, faces, lines, nodes or "
+			"data points in the region or group. With sort_by, the objects are "
+			"first ordered by the field's values, with the existing identifiers "
+			"reassigned in that order. Giving threads N (0 = number of hardware "
+			"threads) with sort_by sorts on N threads, evaluating the field on N "
+			"threads only at nodes and only if it depends on nothing but node "
+			"parameters, otherwise serially, including at element centres. The "
+			"complete renumbering is checked before changing any identifiers, and "
+			"if setting any identifier fails the old identifiers are restored. The "
+			"result is the same for any N.");
 		/* data_offset */
 		Option_table_add_entry(option_table, "data_offset", &data_offset,
 			&data_flag, set_int_and_char_flag);
@@ -505,6 +541,8 @@ DESCRIPTION :
 		/* sort_by */
 		Option_table_add_string_entry(option_table, "sort_by", &sort_by_field_name,
 			" FIELD_NAME");
+		/* threads */
+		Option_table_add_int_non_negative_entry(option_table, "threads", &number_of_threads);
 		/* time */
 		Option_table_add_entry(option_table, "time", &time, NULL, set_FE_value);
 
@@ -548,7 +586,18 @@ DESCRIPTION :
 								fieldmodule, highest_dimension);
 							cmzn_field_element_group_id element_group =
 								cmzn_field_group_get_field_element_group(group, mesh);
-							if (CMZN_OK != FE_region_change_element_identifiers(fe_region,
+							if (sort_by_field && (0 <= number_of_threads))
+							{
+								cmzn_mesh_id sort_mesh = (element_group) ? cmzn_mesh_group_base_cast(
+									cmzn_field_element_group_get_mesh_group(element_group)) : cmzn_mesh_access(mesh);
+								if (!Mesh_change_identifiers_sorted(sort_mesh, element_offset, sort_by_field,
+									time, number_of_threads))
+								{
+									return_code = 0;
+								}
+								cmzn_mesh_destroy(&sort_mesh);
+							}
+							else if (CMZN_OK != FE_region_change_element_identifiers(fe_region,
 								highest_dimension, element_offset, sort_by_field, time,
 								element_group))
 							{
@@ -569,7 +618,18 @@ DESCRIPTION :
 							fieldmodule, 2);
 						cmzn_field_element_group_id element_group =
 							cmzn_field_group_get_field_element_group(group, mesh);
-						if (CMZN_OK != FE_region_change_element_identifiers(fe_region,
+						if (sort_by_field && (0 <= number_of_threads))
+						{
+							cmzn_mesh_id sort_mesh = (element_group) ? cmzn_mesh_group_base_cast(
+								cmzn_field_element_group_get_mesh_group(element_group)) : cmzn_mesh_access(mesh);
+							if (!Mesh_change_identifiers_sorted(sort_mesh, face_offset, sort_by_field,
+								time, number_of_threads))
+							{
+								return_code = 0;
+							}
+							cmzn_mesh_destroy(&sort_mesh);
+						}
+						else if (CMZN_OK != FE_region_change_element_identifiers(fe_region,
 							/*dimension*/2,	face_offset, sort_by_field, time,
 							element_group))
 						{
@@ -584,7 +644,18 @@ DESCRIPTION :
 							fieldmodule, 1);
 						cmzn_field_element_group_id element_group =
 							cmzn_field_group_get_field_element_group(group, mesh);
-						if (CMZN_OK != FE_region_change_element_identifiers(fe_region,
+						if (sort_by_field && (0 <= number_of_threads))
+						{
+							cmzn_mesh_id sort_mesh = (element_group) ? cmzn_mesh_group_base_cast(
+								cmzn_field_element_group_get_mesh_group(element_group)) : cmzn_mesh_access(mesh);
+							if (!Mesh_change_identifiers_sorted(sort_mesh, line_offset, sort_by_field,
+								time, number_of_threads))
+							{
+								return_code = 0;
+							}
+							cmzn_mesh_destroy(&sort_mesh);
+						}
+						else if (CMZN_OK != FE_region_change_element_identifiers(fe_region,
 							/*dimension*/1, line_offset, sort_by_field, time,
 							element_group))
 						{
@@ -606,7 +677,15 @@ DESCRIPTION :
 						}
 						if (nodeset)
 						{
-							if (!cmzn_nodeset_change_node_identifiers(nodeset, node_offset, sort_by_field, time))
+							if (sort_by_field && (0 <= number_of_threads))
+							{
+								if (!Nodeset_change_identifiers_sorted(nodeset, node_offset, sort_by_field,
+									time, number_of_threads))
+								{
+									return_code = 0;
+								}
+							}
+							else if (!cmzn_nodeset_change_node_identifiers(nodeset, node_offset, sort_by_field, time))
 								return_code = 0;
 							cmzn_nodeset_destroy(&nodeset);
 						}
@@ -624,7 +703,15 @@ DESCRIPTION :
 						}
 						if (nodeset)
 						{
-							if (!cmzn_nodeset_change_node_identifiers(nodeset, data_offset, sort_by_field, time))
+							if (sort_by_field && (0 <= number_of_threads))
+							{
+								if (!Nodeset_change_identifiers_sorted(nodeset, data_offset, sort_by_field,
+									time, number_of_threads))
+								{
+									return_code = 0;
+								}
+							}
+							else if (!cmzn_nodeset_change_node_identifiers(nodeset, data_offset, sort_by_field, time))
 								return_code = 0;
 							cmzn_nodeset_destroy(&nodeset);
 						}
@@ -1328,8 +1415,21 @@ static int gfx_create_gauss_points(struct Parse_state *state,
 			}
 			if (return_code)
 			{
+				/* cache changes so group and graphics updates happen once for all points */
+				const int initial_size = cmzn_nodeset_get_size(gauss_points_nodeset);
+				std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+				cmzn_fieldmodule_begin_change(field_module);
 				return_code = cmzn_mesh_create_gauss_points(mesh, order, gauss_points_nodeset,
 					first_identifier, gauss_location_field, gauss_weight_field);
+				cmzn_fieldmodule_end_change(field_module);
+				const double seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start_time).count();
+				if (CMZN_OK == return_code)
+				{
+					const int number_created = cmzn_nodeset_get_size(gauss_points_nodeset) - initial_size;
+					display_message(INFORMATION_MESSAGE,
+						"gfx create gauss_points:  Created %d points in %g s\n", number_created, seconds);
+				}
 			}
 			cmzn_field_finite_element_destroy(&gauss_weight_field);
 			cmzn_field_stored_mesh_location_destroy(&gauss_location_field);
@@ -2494,7 +2594,7 @@ static int set_Texture_image_from_field(struct Texture *texture,
 	int image_width, int image_height, int image_depth,
 	int number_of_bytes_per_component,
 	struct Graphics_buffer_app_package *graphics_buffer_package,
-	cmzn_material *fail_material)
+	cmzn_material *fail_material, int number_of_threads, int compare_serial)
 /*******************************************************************************
 LAST MODIFIED : 30 June 2006
 
@@ -2504,6 +2604,10 @@ reverse mapping of the <texture_coordinate_field>.  The values returned by
 field are converted to "colours" by applying the <spectrum>.
 Currently limited to 1 byte per component.
 @param search_mesh  The mesh to find locations with matching texture coordinates.
+@param number_of_threads  Number of threads to evaluate with, 0 for hardware
+threads, or negative to evaluate serially in Zinc.
+@param compare_serial  If set and evaluating with threads, the image is also
+evaluated serially in Zinc and any difference reported.
 ==============================================================================*/
 {
 	char *field_name;
@@ -2597,10 +2701,48 @@ Currently limited to 1 byte per component.
 			bytes_per_pixel = number_of_components*number_of_bytes_per_component;
 			double texture_width, texture_height, texture_depth;
 			Texture_get_physical_size(texture, &texture_width, &texture_height, &texture_depth);
-			Set_cmiss_field_value_to_texture(field, texture_coordinate_field,
-				texture, spectrum,	fail_material, image_width, image_height, image_depth,
-				bytes_per_pixel, number_of_bytes_per_component, use_pixel_location, texture_width, texture_height, texture_depth,
-				storage, Graphics_buffer_package_get_core_package(graphics_buffer_package), search_mesh);
+			if (0 <= number_of_threads)
+			{
+				std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+				return_code = Texture_evaluate_image_from_field_threaded(texture,
+					field, texture_coordinate_field, use_pixel_location, spectrum,
+					fail_material, search_mesh, storage, image_width,
+					image_height, image_depth, number_of_bytes_per_component,
+					texture_width, texture_height, texture_depth, number_of_threads);
+				const double threaded_seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start_time).count();
+				if (return_code && compare_serial)
+				{
+					struct Texture *serial_texture = CREATE(Texture)("serial_comparison");
+					if (serial_texture && Texture_allocate_image(serial_texture, image_width,
+						image_height, image_depth, storage, number_of_bytes_per_component, field_name))
+					{
+						start_time = std::chrono::steady_clock::now();
+						Set_cmiss_field_value_to_texture(field, texture_coordinate_field,
+							serial_texture, spectrum, fail_material, image_width, image_height, image_depth,
+							bytes_per_pixel, number_of_bytes_per_component, use_pixel_location, texture_width, texture_height, texture_depth,
+							storage, Graphics_buffer_package_get_core_package(graphics_buffer_package), search_mesh);
+						display_message(INFORMATION_MESSAGE,
+							"Evaluated texture image in %g s with threads, %g s serially\n", threaded_seconds,
+							std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+						Texture_evaluate_compare_images(texture, serial_texture);
+					}
+					else
+					{
+						display_message(ERROR_MESSAGE,
+							"set_Texture_image_from_field.  Could not allocate serial comparison image");
+					}
+					if (serial_texture)
+						DESTROY(Texture)(&serial_texture);
+				}
+			}
+			else
+			{
+				Set_cmiss_field_value_to_texture(field, texture_coordinate_field,
+					texture, spectrum,	fail_material, image_width, image_height, image_depth,
+					bytes_per_pixel, number_of_bytes_per_component, use_pixel_location, texture_width, texture_height, texture_depth,
+					storage, Graphics_buffer_package_get_core_package(graphics_buffer_package), search_mesh);
+			}
 		}
 		else
 		{
@@ -2705,6 +2847,8 @@ struct Texture_evaluate_image_data
 	cmzn_field_group_id group;
 	char *field_name, *texture_coordinates_field_name;
 	int element_dimension; /* where 0 is any dimension */
+	int number_of_threads; /* negative to evaluate serially in Zinc */
+	char compare_serial_flag;
 	int propagate_field;
 	struct Computed_field *field, *texture_coordinates_field;
 	cmzn_material *fail_material;
@@ -2735,6 +2879,9 @@ Modifies the properties of a texture.
 			/* element_dimension */
 			Option_table_add_entry(option_table, "element_dimension",
 				&data->element_dimension, NULL, set_element_dimension_or_all);
+			/* compare_serial */
+			Option_table_add_char_flag_entry(option_table, "compare_serial",
+				&data->compare_serial_flag);
 			/* element_group */
 			Option_table_add_region_or_group_entry(option_table, "element_group",
 				&data->region, &data->group);
@@ -2753,6 +2900,9 @@ Modifies the properties of a texture.
 			/* texture_coordinates */
 			Option_table_add_entry(option_table, "texture_coordinates",
 				&data->texture_coordinates_field_name, (void *)1, set_name);
+			/* threads */
+			Option_table_add_int_non_negative_entry(option_table, "threads",
+				&data->number_of_threads);
 
 			return_code = Option_table_multi_parse(option_table, state);
 			DESTROY(Option_table)(&option_table);
@@ -2948,6 +3098,175 @@ Modifies the properties of a texture.
 	return (return_code);
 } /* gfx_modify_Texture_file_number_series */
 
+struct Texture_raw_volume_data
+{
+	char *file_name;
+	struct Raw_volume_format format;
+	struct Raw_volume_subvolume subvolume;
+	double memory_budget_megabytes;
+};
+
+/**
+ * Parses the raw_volume options of gfx modify texture into the
+ * Texture_raw_volume_data at <data_void>.
+ */
+static int gfx_modify_Texture_raw_volume(struct Parse_state *state,
+	void *data_void, void *command_data_void)
+{
+	int return_code;
+	struct cmzn_command_data *command_data;
+	struct Texture_raw_volume_data *data;
+
+	ENTER(gfx_modify_Texture_raw_volume);
+	if (state && (command_data = (struct cmzn_command_data *)command_data_void)
+		&& (data = (struct Texture_raw_volume_data *)data_void))
+	{
+		if (state->current_token)
+		{
+			const char *component_type_strings[] = {
+				Raw_volume_component_type_string(RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR),
+				Raw_volume_component_type_string(RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_SHORT),
+				Raw_volume_component_type_string(RAW_VOLUME_COMPONENT_TYPE_SHORT),
+				Raw_volume_component_type_string(RAW_VOLUME_COMPONENT_TYPE_FLOAT)
+			};
+			const char *component_type_string =
+				Raw_volume_component_type_string(data->format.component_type);
+			int big_endian = data->format.big_endian ? 1 : 0;
+			/* double so offsets into files over 2 GB can be given */
+			double header_offset = static_cast<double>(data->format.header_offset);
+			double range[2] = { data->format.minimum, data->format.maximum };
+			int number_of_range_components = 2;
+			int number_of_brick_components = 3;
+			struct Option_table *option_table = CREATE(Option_table)();
+			Option_table_add_help(option_table,
+				"Memory-map a headerless binary volume FILE of WIDTH x HEIGHT x DEPTH "
+				"voxels, x fastest, with <components> interleaved values of the given "
+				"type per voxel after <header_offset> bytes, and copy it into the "
+				"texture a slice at a time. Unsigned_char gives 1 byte per component, "
+				"other types 2 bytes, unless <bytes_per_component> is 1 or 2. Short and "
+				"float values, and unsigned short values quantised to 1 byte, are scaled "
+				"from <range>, or from the range of the data if its limits are equal; "
+				"gfx list texture reports the memory saved and the offset and scale "
+				"giving data values from texels. To view volumes "
+				"too large for memory, <brick_origin> and <brick_size> (0 for the rest "
+				"of the volume) select part of it, and <level> loads it at reduced "
+				"resolution, each level averaging 2x2x2 voxels; level -1 chooses the "
+				"finest level whose texture fits <memory_budget> megabytes.");
+			/* big_endian/little_endian */
+			Option_table_add_switch(option_table, "big_endian", "little_endian",
+				&big_endian);
+			/* brick_origin */
+			Option_table_add_int_vector_entry(option_table, "brick_origin",
+				data->subvolume.origin, &number_of_brick_components);
+			/* brick_size */
+			Option_table_add_int_vector_entry(option_table, "brick_size",
+				data->subvolume.size, &number_of_brick_components);
+			/* components */
+			Option_table_add_int_positive_entry(option_table, "components",
+				&data->format.number_of_components);
+			/* depth */
+			Option_table_add_int_positive_entry(option_table, "depth",
+				&data->format.depth);
+			/* file */
+			Option_table_add_entry(option_table, "file", &data->file_name,
+				NULL, set_file_name);
+			/* bytes_per_component */
+			Option_table_add_int_non_negative_entry(option_table, "bytes_per_component",
+				&data->format.texture_bytes_per_component);
+			/* header_offset */
+			Option_table_add_non_negative_double_entry(option_table, "header_offset",
+				&header_offset);
+			/* height */
+			Option_table_add_int_positive_entry(option_table, "height",
+				&data->format.height);
+			/* level */
+			Option_table_add_entry(option_table, "level",
+				&data->subvolume.level, NULL, set_int);
+			/* memory_budget */
+			Option_table_add_positive_double_entry(option_table, "memory_budget",
+				&data->memory_budget_megabytes);
+			/* range */
+			Option_table_add_double_vector_entry(option_table, "range",
+				range, &number_of_range_components);
+			/* short|float|unsigned_char|unsigned_short */
+			Option_table_add_enumerator(option_table, 4, component_type_strings,
+				&component_type_string);
+			/* width */
+			Option_table_add_int_positive_entry(option_table, "width",
+				&data->format.width);
+			return_code = Option_table_multi_parse(option_table, state);
+			DESTROY(Option_table)(&option_table);
+			if (return_code)
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					if (0 == strcmp(component_type_string, component_type_strings[i]))
+						data->format.component_type = static_cast<enum Raw_volume_component_type>(i + 1);
+				}
+				data->format.big_endian = (0 != big_endian);
+				/* must be a whole number of bytes exactly representable as a double
+				 * and addressable on this platform */
+				if ((header_offset != floor(header_offset)) ||
+					(header_offset > 9007199254740992.0) ||
+					(header_offset > static_cast<double>(std::numeric_limits<size_t>::max())))
+				{
+					display_message(ERROR_MESSAGE, "gfx modify texture raw_volume:  "
+						"Invalid header_offset %.17g", header_offset);
+					return_code = 0;
+				}
+				else
+				{
+					data->format.header_offset = static_cast<size_t>(header_offset);
+				}
+				data->format.minimum = range[0];
+				data->format.maximum = range[1];
+				if (!data->file_name)
+				{
+					display_message(ERROR_MESSAGE,
+						"gfx modify texture raw_volume:  Missing file name");
+					return_code = 0;
+				}
+				else if (4 < data->format.number_of_components)
+				{
+					display_message(ERROR_MESSAGE,
+						"gfx modify texture raw_volume:  Components must be from 1 to 4");
+					return_code = 0;
+				}
+				else if (2 < data->format.texture_bytes_per_component)
+				{
+					display_message(ERROR_MESSAGE,
+						"gfx modify texture raw_volume:  Bytes per component must be 1 or 2");
+					return_code = 0;
+				}
+				else if (data->subvolume.level < -1)
+				{
+					display_message(ERROR_MESSAGE,
+						"gfx modify texture raw_volume:  Level must be -1 or more");
+					return_code = 0;
+				}
+				data->subvolume.memory_budget =
+					static_cast<size_t>(data->memory_budget_megabytes*1048576.0);
+			}
+		}
+		else
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx_modify_Texture_raw_volume.  Missing raw volume options");
+			display_parse_state_location(state);
+			return_code = 0;
+		}
+	}
+	else
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx_modify_Texture_raw_volume.  Invalid argument(s)");
+		return_code = 0;
+	}
+	LEAVE;
+
+	return (return_code);
+} /* gfx_modify_Texture_raw_volume */
+
 int gfx_modify_Texture(struct Parse_state *state,void *texture_void,
 	void *command_data_void)
 /*******************************************************************************
@@ -2983,6 +3302,7 @@ Modifies the properties of a texture.
 	struct Texture *texture, *texture_copy;
 	struct Texture_image_data image_data;
 	struct Texture_file_number_series_data file_number_series_data;
+	struct Texture_raw_volume_data raw_volume_data;
 	/* do not make the following static as 'set' flag must start at 0 */
 	struct Set_vector_with_help_data texture_distortion_data=
 		{3," DISTORTION_CENTRE_X DISTORTION_CENTRE_Y DISTORTION_FACTOR_K1",0};
@@ -3136,10 +3456,32 @@ Modifies the properties of a texture.
 					image_data.crop_width=0;
 					image_data.crop_height=0;
 
+					raw_volume_data.file_name = (char *)NULL;
+					raw_volume_data.format.width = 1;
+					raw_volume_data.format.height = 1;
+					raw_volume_data.format.depth = 1;
+					raw_volume_data.format.number_of_components = 1;
+					raw_volume_data.format.component_type = RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR;
+					raw_volume_data.format.big_endian = false;
+					raw_volume_data.format.header_offset = 0;
+					raw_volume_data.format.texture_bytes_per_component = 0;
+					raw_volume_data.format.minimum = 0.0;
+					raw_volume_data.format.maximum = 0.0;
+					for (i = 0; i < 3; ++i)
+					{
+						raw_volume_data.subvolume.origin[i] = 0;
+						raw_volume_data.subvolume.size[i] = 0;
+					}
+					raw_volume_data.subvolume.level = 0;
+					raw_volume_data.subvolume.memory_budget = 0;
+					raw_volume_data.memory_budget_megabytes = 512.0;
+
 					Texture_evaluate_image_data evaluate_data;
 					evaluate_data.region = cmzn_region_access(command_data->root_region);
 					evaluate_data.group = (cmzn_field_group_id)0;
 					evaluate_data.element_dimension = 0; /* dimension == number of texture coordinates components */
+					evaluate_data.number_of_threads = -1;
+					evaluate_data.compare_serial_flag = 0;
 					evaluate_data.propagate_field = 1;
 					evaluate_data.field = (struct Computed_field *)NULL;
 					evaluate_data.texture_coordinates_field =
@@ -3237,6 +3579,9 @@ Modifies the properties of a texture.
 					Option_table_add_entry(option_table, "number_series",
 						&file_number_series_data, NULL,
 						gfx_modify_Texture_file_number_series);
+					/* raw_volume */
+					Option_table_add_entry(option_table, "raw_volume",
+						&raw_volume_data, command_data, gfx_modify_Texture_raw_volume);
 					/* raw image storage mode */
 					raw_image_storage_string =
 						ENUMERATOR_STRING(Raw_image_storage)(RAW_PLANAR_RGB);
@@ -3540,12 +3885,24 @@ Modifies the properties of a texture.
 									Texture_allocate_image(texture, /*image_width*/1, /*image_height*/1,
 										/*image_depth*/1, TEXTURE_RGB, /*number_of_bytes_per_component*/1,
 										"INCOMPLETEDTEXTURE");
+									Texture_clear_all_properties(texture);
 									display_message(ERROR_MESSAGE,  "gfx modify texture:  "
 										"Unable to read images into texture, setting it to black.");
 								}
 							}
 							DESTROY(Cmgui_image_information)(&cmgui_image_information);
 						}
+						if (raw_volume_data.file_name)
+						{
+							if (!Texture_set_image_from_raw_volume(texture,
+								raw_volume_data.file_name, raw_volume_data.format,
+								&raw_volume_data.subvolume))
+							{
+								display_message(ERROR_MESSAGE, "gfx modify texture:  "
+									"Could not load raw volume %s", raw_volume_data.file_name);
+								return_code = 0;
+							}
+						}
 #if defined (SGI_MOVIE_FILE)
 						if ( movie != old_movie )
 						{
@@ -3600,13 +3957,18 @@ Modifies the properties of a texture.
 								specify_height, specify_depth,
 								specify_number_of_bytes_per_component,
 								command_data->graphics_buffer_package,
-								evaluate_data.fail_material);
+								evaluate_data.fail_material,
+								evaluate_data.number_of_threads,
+								evaluate_data.compare_serial_flag);
 
 							if (texture_copy != texture)
 							{
 								Texture_copy_without_identifier(texture_copy, texture);
 								DESTROY(Texture)(&texture_copy);
 							}
+							/* properties of the previous image, including how it was loaded, no
+								longer describe the evaluated image */
+							Texture_clear_all_properties(texture);
 							cmzn_mesh_destroy(&search_mesh);
 							cmzn_fieldmodule_destroy(&field_module);
 						}
@@ -3621,6 +3983,10 @@ Modifies the properties of a texture.
 					{
 						DEALLOCATE(image_data.image_file_name);
 					}
+					if (raw_volume_data.file_name)
+					{
+						DEALLOCATE(raw_volume_data.file_name);
+					}
 					DESTROY(Option_table)(&option_table);
 #if defined (SGI_MOVIE_FILE)
 					if (movie)
@@ -4418,6 +4784,7 @@ Executes a GFX CONVERT ELEMENTS command.
 			number_of_fields = 1;
 			Convert_finite_elements_mode conversion_mode = CONVERT_TO_FINITE_ELEMENTS_MODE_UNSPECIFIED;
 			double tolerance = 1.0E-6;
+			char hash_merge_flag = 0;
 			Element_discretization element_refinement = { 1, 1, 1 };
 
 			if ((state->current_token) &&
@@ -4462,11 +4829,18 @@ Executes a GFX CONVERT ELEMENTS command.
 				"Note: field value versions of non-coordinate fields are not handled"
 				" - the first processed element's versions are assumed. "
 				"Mode \'convert_hermite_2D_product_elements\' ONLY: converts element fields on 2-D elements "
-				"into bicubic hermite basis WITHOUT merging nearby nodes.");
+				"into bicubic hermite basis WITHOUT merging nearby nodes. "
+				"With hash_merge the trilinear and triquadratic modes evaluate source "
+				"elements in bounded chunks and merge nodes with a spatial hash, giving "
+				"the same result, and the time spent evaluating, and merging nodes and "
+				"creating the mesh, is reported; all source elements must be cubes. "
+				"Elements are evaluated on one thread as element field evaluation is "
+				"not safe on several.");
 			Option_table_add_set_cmzn_region(option_table, "destination_region",
 				command_data->root_region, &destination_region);
 			Option_table_add_entry(option_table,"fields",component_names,
 				&number_of_fields, set_names);
+			Option_table_add_char_flag_entry(option_table, "hash_merge", &hash_merge_flag);
 			Option_table_add_entry(option_table, "number_of_fields",
 				&number_of_fields, NULL, set_int_positive);
 			OPTION_TABLE_ADD_ENUMERATOR(Convert_finite_elements_mode)(option_table,
@@ -4549,9 +4923,20 @@ Executes a GFX CONVERT ELEMENTS command.
 					refinement.count[0] = element_refinement.number_in_xi1;
 					refinement.count[1] = element_refinement.number_in_xi2;
 					refinement.count[2] = element_refinement.number_in_xi3;
-					return_code = finite_element_conversion(
-						source_region, destination_region, conversion_mode,
-						number_of_fields, fields, refinement, tolerance);
+					if (hash_merge_flag &&
+						((CONVERT_TO_FINITE_ELEMENTS_TRILINEAR == conversion_mode) ||
+							(CONVERT_TO_FINITE_ELEMENTS_TRIQUADRATIC == conversion_mode)))
+					{
+						return_code = finite_element_conversion_hash_merge(
+							source_region, destination_region, conversion_mode,
+							number_of_fields, fields, refinement, tolerance);
+					}
+					else
+					{
+						return_code = finite_element_conversion(
+							source_region, destination_region, conversion_mode,
+							number_of_fields, fields, refinement, tolerance);
+					}
 				}
 			}
 			if (fields)
@@ -4635,6 +5020,11 @@ static int gfx_convert_graphics(struct Parse_state *state,
 			"The surface_density gives the base expected number of points per unit area, and if the "
 			"graphics has a data field, the value of its first component scaled by surface_density_scale_factor "
 			"is added to the expected number. Separate values for lines control the expected number per unit length. "
+			"Giving seeded with 'render_surface_node_cloud' samples the elements drawn by lines and "
+			"surfaces graphics with a random stream per element from seed, so the same points are made "
+			"each time, at their tessellation's divisions times refinement factors and transformed by "
+			"the scene transformations, and creates all nodes in one change. If more than "
+			"max_points points are sampled, one is kept from each of max_points equal strata of them. "
 			"With mode 'render_nodes', nodes are created at points.");
 		/* coordinate */
 		Option_table_add_string_entry(option_table,"coordinate",&coordinate_field_name,
@@ -4643,6 +5033,8 @@ static int gfx_convert_graphics(struct Parse_state *state,
 		Option_table_add_double_entry(option_table, "line_density", &line_density);
 		double line_density_scale_factor = 0.0;
 		Option_table_add_double_entry(option_table, "line_density_scale_factor", &line_density_scale_factor);
+		int maximum_number_of_points = 0;
+		Option_table_add_int_non_negative_entry(option_table, "max_points", &maximum_number_of_points);
 
 		/* render_to_finite_elements_mode */
 		OPTION_TABLE_ADD_ENUMERATOR(Render_to_finite_elements_mode)(option_table,
@@ -4658,6 +5050,10 @@ static int gfx_convert_graphics(struct Parse_state *state,
 		Option_table_add_double_entry(option_table, "surface_density", &surface_density);
 		double surface_density_scale_factor = 0.0;
 		Option_table_add_double_entry(option_table, "surface_density_scale_factor", &surface_density_scale_factor);
+		int seed = 1;
+		Option_table_add_int_non_negative_entry(option_table, "seed", &seed);
+		char seeded_flag = 0;
+		Option_table_add_char_flag_entry(option_table, "seeded", &seeded_flag);
 		return_code=Option_table_multi_parse(option_table,state);
 		DESTROY(Option_table)(&option_table);
 
@@ -4717,9 +5113,24 @@ static int gfx_convert_graphics(struct Parse_state *state,
 
 		if (return_code)
 		{
-			render_to_finite_elements(input_region, graphics_name, filter, render_mode,
-				region, group, coordinate_field, static_cast<cmzn_nodeset_id>(0),
-				line_density, line_density_scale_factor, surface_density, surface_density_scale_factor);
+			if ((RENDER_TO_FINITE_ELEMENTS_SURFACE_NODE_CLOUD == render_mode) && seeded_flag)
+			{
+				Render_node_cloud_options options;
+				options.line_density = line_density;
+				options.line_density_scale_factor = line_density_scale_factor;
+				options.surface_density = surface_density;
+				options.surface_density_scale_factor = surface_density_scale_factor;
+				options.seed = seed;
+				options.maximum_number_of_points = maximum_number_of_points;
+				return_code = Render_node_cloud_seeded(input_region, graphics_name, filter,
+					region, group, coordinate_field, options);
+			}
+			else
+			{
+				render_to_finite_elements(input_region, graphics_name, filter, render_mode,
+					region, group, coordinate_field, static_cast<cmzn_nodeset_id>(0),
+					line_density, line_density_scale_factor, surface_density, surface_density_scale_factor);
+			}
 		}
 		if (scene)
 		{
@@ -4972,14 +5383,28 @@ static int gfx_define_faces(struct Parse_state *state,
 		cmzn_region_id region = cmzn_region_access(command_data->root_region);
 		cmzn_field_group_id group = 0;
 		Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Defines faces and lines of the elements in the region or element group, "
+			"adding them to the group if given. Elements whose faces are already all "
+			"defined are skipped, so repeating the command is cheap. The number of "
+			"faces and lines created and the time taken are reported.");
 		Option_table_add_region_or_group_entry(option_table, "egroup", &region, &group);
 		return_code = Option_table_multi_parse(option_table, state);
 		DESTROY(Option_table)(&option_table);
 		if (return_code)
 		{
+			std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
 			cmzn_fieldmodule_id field_module = cmzn_region_get_fieldmodule(region);
 			cmzn_fieldmodule_begin_change(field_module);
 			FE_region *fe_region = cmzn_region_get_FE_region(region);
+			int initial_mesh_sizes[MAXIMUM_ELEMENT_XI_DIMENSIONS];
+			for (int dimension = 1; dimension < MAXIMUM_ELEMENT_XI_DIMENSIONS; ++dimension)
+			{
+				cmzn_mesh_id face_mesh = cmzn_fieldmodule_find_mesh_by_dimension(field_module, dimension);
+				initial_mesh_sizes[dimension] = cmzn_mesh_get_size(face_mesh);
+				cmzn_mesh_destroy(&face_mesh);
+			}
+			int skipped_count = 0;
 			FE_region_begin_define_faces(fe_region);
 			for (int dimension = MAXIMUM_ELEMENT_XI_DIMENSIONS; (1 < dimension) && return_code; --dimension)
 			{
@@ -4987,6 +5412,7 @@ static int gfx_define_faces(struct Parse_state *state,
 				FE_mesh *fe_mesh = FE_region_find_FE_mesh_by_dimension(fe_region, dimension);
 				if (!fe_mesh)
 				{
+					cmzn_mesh_destroy(&mesh);
 					return_code = 0;
 					break;
 				}
@@ -5014,20 +5440,32 @@ static int gfx_define_faces(struct Parse_state *state,
 					cmzn_element_id element = 0;
 					while ((0 != (element = cmzn_elementiterator_next_non_access(iter))) && return_code)
 					{
-						const int result = fe_mesh->defineElementFaces(element->getIndex());
-						if (result != CMZN_OK)
+						FE_element_shape *element_shape = get_FE_element_shape(element);
+						const int number_of_faces = FE_element_shape_get_number_of_faces(element_shape);
+						// faces of elements read with faces need no matching
+						int existing_face_count = 0;
+						while ((existing_face_count < number_of_faces) &&
+								get_FE_element_face(element, existing_face_count))
+							++existing_face_count;
+						if (existing_face_count == number_of_faces)
+						{
+							++skipped_count;
+						}
+						else
 						{
-							if (result == CMZN_ERROR_NOT_FOUND)
+							const int result = fe_mesh->defineElementFaces(element->getIndex());
+							if (result != CMZN_OK)
 							{
-								// no nodes defined, so no faces can be found
-								continue;
+								if (result == CMZN_ERROR_NOT_FOUND)
+								{
+									// no nodes defined, so no faces can be found
+									continue;
+								}
+								return_code = 0;
 							}
-							return_code = 0;
 						}
 						if (face_mesh_group)
 						{
-							FE_element_shape *element_shape = get_FE_element_shape(element);
-							int number_of_faces = FE_element_shape_get_number_of_faces(element_shape);
 							cmzn_element_id face = 0;
 							for (int face_number = 0; face_number < number_of_faces; ++face_number)
 							{
@@ -5051,6 +5489,21 @@ static int gfx_define_faces(struct Parse_state *state,
 			}
 			FE_region_end_define_faces(fe_region);
 			cmzn_fieldmodule_end_change(field_module);
+			if (return_code)
+			{
+				display_message(INFORMATION_MESSAGE, "Defined");
+				for (int dimension = MAXIMUM_ELEMENT_XI_DIMENSIONS - 1; 0 < dimension; --dimension)
+				{
+					cmzn_mesh_id face_mesh = cmzn_fieldmodule_find_mesh_by_dimension(field_module, dimension);
+					display_message(INFORMATION_MESSAGE, " %d %d-D", cmzn_mesh_get_size(face_mesh) -
+						initial_mesh_sizes[dimension], dimension);
+					cmzn_mesh_destroy(&face_mesh);
+				}
+				display_message(INFORMATION_MESSAGE,
+					" faces in %g s; %d elements already had all faces\n",
+					std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count(),
+					skipped_count);
+			}
 			cmzn_fieldmodule_destroy(&field_module);
 		}
 		cmzn_field_group_destroy(&group);
@@ -5292,6 +5745,14 @@ static int gfx_destroy_elements(struct Parse_state *state,
 		}
 
 		Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Destroys the elements in the region which are in all of the given ranges, "
+			"group, selection and where the conditional field is true, in one "
+			"batch. Faces and lines no longer used by any element are also "
+			"destroyed. Destroying all elements of a region is done without "
+			"evaluating a conditional for each element. The numbers of elements, "
+			"faces and lines destroyed and the time spent selecting, destroying "
+			"and updating the selection are reported.");
 		/* all */
 		Option_table_add_char_flag_entry(option_table, "all", &all_flag);
 		/* conditional_field */
@@ -5344,32 +5805,73 @@ static int gfx_destroy_elements(struct Parse_state *state,
 			if (dimension == 3)
 				use_dimension = FE_region_get_highest_dimension(fe_region);
 			cmzn_mesh_id mesh = cmzn_fieldmodule_find_mesh_by_dimension(fieldmodule, use_dimension);
-			const int oldSize = cmzn_mesh_get_size(mesh);
+			int old_sizes[MAXIMUM_ELEMENT_XI_DIMENSIONS + 1];
+			for (int d = 1; d <= use_dimension; ++d)
+			{
+				cmzn_mesh_id dimension_mesh = cmzn_fieldmodule_find_mesh_by_dimension(fieldmodule, d);
+				old_sizes[d] = cmzn_mesh_get_size(dimension_mesh);
+				cmzn_mesh_destroy(&dimension_mesh);
+			}
+			std::chrono::steady_clock::time_point phase_start = std::chrono::steady_clock::now();
+			double select_seconds = 0.0, destroy_seconds = 0.0, selection_seconds = 0.0;
 			if ((!selected_flag) || (selection_field)) // otherwise empty set
 			{
-				cmzn_field_id use_conditional_field = cmzn_mesh_create_conditional_field_from_ranges_and_selection(
-					mesh, element_ranges, selection_field, cmzn_field_group_base_cast(group), conditional_field, time);
-				if (use_conditional_field)
+				int result = CMZN_OK;
+				if (all_flag && (!selected_flag) && (!group) && (!conditional_field) &&
+					(0 == Multi_range_get_number_of_ranges(element_ranges)))
 				{
-					int result = cmzn_mesh_destroy_elements_conditional(mesh, use_conditional_field);
-					if (result != CMZN_OK)
-					{
-						display_message(INFORMATION_MESSAGE, "gfx destroy elements|faces|lines:  Failed\n");
-						return_code = 0;
-					}
+					// no need to build a group of every element
+					result = cmzn_mesh_destroy_all_elements(mesh);
+					destroy_seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - phase_start).count();
 				}
 				else
+				{
+					cmzn_field_id use_conditional_field = cmzn_mesh_create_conditional_field_from_ranges_and_selection(
+						mesh, element_ranges, selection_field, cmzn_field_group_base_cast(group), conditional_field, time);
+					select_seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - phase_start).count();
+					phase_start = std::chrono::steady_clock::now();
+					if (use_conditional_field)
+						result = cmzn_mesh_destroy_elements_conditional(mesh, use_conditional_field);
+					else
+						return_code = 0;
+					destroy_seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - phase_start).count();
+					cmzn_field_destroy(&use_conditional_field);
+				}
+				if (result != CMZN_OK)
+				{
+					display_message(INFORMATION_MESSAGE, "gfx destroy elements|faces|lines:  Failed\n");
 					return_code = 0;
-				cmzn_field_destroy(&use_conditional_field);
+				}
 			}
-			const int newSize = cmzn_mesh_get_size(mesh);
-			if (return_code && (newSize == oldSize))
-				display_message(INFORMATION_MESSAGE, "gfx destroy elements|faces|lines:  No elements destroyed\n");
 			if (selection_field)
 			{
+				phase_start = std::chrono::steady_clock::now();
 				cmzn_field_group_id selection_group = cmzn_field_cast_group(selection_field);
 				cmzn_field_group_remove_empty_subgroups(selection_group);
 				cmzn_field_group_destroy(&selection_group);
+				selection_seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - phase_start).count();
+			}
+			if (return_code)
+			{
+				if (cmzn_mesh_get_size(mesh) == old_sizes[use_dimension])
+					display_message(INFORMATION_MESSAGE, "gfx destroy elements|faces|lines:  No elements destroyed\n");
+				else
+				{
+					display_message(INFORMATION_MESSAGE, "Destroyed");
+					for (int d = use_dimension; 0 < d; --d)
+					{
+						cmzn_mesh_id dimension_mesh = cmzn_fieldmodule_find_mesh_by_dimension(fieldmodule, d);
+						display_message(INFORMATION_MESSAGE, " %d %d-D",
+							old_sizes[d] - cmzn_mesh_get_size(dimension_mesh), d);
+						cmzn_mesh_destroy(&dimension_mesh);
+					}
+					display_message(INFORMATION_MESSAGE, " elements: select %g s, destroy %g s,"
+						" update selection %g s\n", select_seconds, destroy_seconds, selection_seconds);
+				}
 			}
 			cmzn_mesh_destroy(&mesh);
 			cmzn_field_destroy(&selection_field);
@@ -5644,6 +6146,13 @@ static int gfx_destroy_nodes(struct Parse_state *state,
 		}
 
 		Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Destroys the nodes or data points in the region which are in all of the "
+			"given ranges, group, selection and where the conditional field is true, "
+			"in one batch. Nodes used by elements are not destroyed. Destroying all "
+			"nodes of a region is done without evaluating a conditional for each "
+			"node. The number destroyed and the time spent selecting, destroying "
+			"and updating the selection are reported.");
 		/* all */
 		Option_table_add_char_flag_entry(option_table, "all", &all_flag);
 		/* conditional_field */
@@ -5695,7 +6204,21 @@ static int gfx_destroy_nodes(struct Parse_state *state,
 				use_data ? CMZN_FIELD_DOMAIN_TYPE_DATAPOINTS : CMZN_FIELD_DOMAIN_TYPE_NODES);
 			const int oldSize = cmzn_nodeset_get_size(master_nodeset);
 			bool nodesInElementsNotDestroyed = false;
-			if ((!selected_flag) || selection_group) // otherwise empty set
+			std::chrono::steady_clock::time_point phase_start = std::chrono::steady_clock::now();
+			double select_seconds = 0.0, destroy_seconds = 0.0, selection_seconds = 0.0;
+			if (all_flag && (!selected_flag) && (!group) && (!conditional_field) &&
+				(0 == Multi_range_get_number_of_ranges(node_ranges)))
+			{
+				// no need to build a group of every node
+				int result = cmzn_nodeset_destroy_all_nodes(master_nodeset);
+				if (result == CMZN_RESULT_ERROR_IN_USE)
+					nodesInElementsNotDestroyed = true;
+				else if (result != CMZN_OK)
+					return_code = 0;
+				destroy_seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - phase_start).count();
+			}
+			else if ((!selected_flag) || selection_group) // otherwise empty set
 			{
 				cmzn_nodeset_id nodeset = 0;
 				if (selection_group)
@@ -5711,15 +6234,25 @@ static int gfx_destroy_nodes(struct Parse_state *state,
 				{
 					cmzn_field_id use_conditional_field = cmzn_nodeset_create_conditional_field_from_ranges_and_selection(
 						nodeset, node_ranges, /*selection_field*/0, cmzn_field_group_base_cast(group), conditional_field, time);
+					select_seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - phase_start).count();
 					if (use_conditional_field)
 					{
+						phase_start = std::chrono::steady_clock::now();
 						int result = cmzn_nodeset_destroy_nodes_conditional(nodeset, use_conditional_field);
 						if (result == CMZN_RESULT_ERROR_IN_USE)
 							nodesInElementsNotDestroyed = true;
 						else if (result != CMZN_OK)
 							return_code = 0;
+						destroy_seconds = std::chrono::duration<double>(
+							std::chrono::steady_clock::now() - phase_start).count();
 						if (selection_group)
+						{
+							phase_start = std::chrono::steady_clock::now();
 							cmzn_field_group_remove_empty_subgroups(selection_group);
+							selection_seconds = std::chrono::duration<double>(
+								std::chrono::steady_clock::now() - phase_start).count();
+						}
 					}
 					else
 						return_code = 0;
@@ -5737,6 +6270,12 @@ static int gfx_destroy_nodes(struct Parse_state *state,
 					display_message(INFORMATION_MESSAGE, "gfx destroy nodes|datapoints:  Nodes used by elements were not destroyed\n");
 				else if (newSize == oldSize)
 					display_message(INFORMATION_MESSAGE, "gfx destroy nodes|datapoints:  No nodes destroyed\n");
+				if (newSize != oldSize)
+				{
+					display_message(INFORMATION_MESSAGE, "Destroyed %d %s: select %g s, destroy %g s,"
+						" update selection %g s\n", oldSize - newSize, use_data ? "data points" : "nodes",
+						select_seconds, destroy_seconds, selection_seconds);
+				}
 			}
 			else
 			{
@@ -7655,6 +8194,9 @@ Executes a GFX EXPORT command.
 			command_data_void, gfx_export_alias);
 		Option_table_add_entry(option_table,"cm",NULL,
 			command_data_void, gfx_export_cm);
+		Option_table_add_entry(option_table,"field_values",NULL,
+			(void *)(((struct cmzn_command_data *)command_data_void)->root_region),
+			gfx_export_field_values);
 		Option_table_add_entry(option_table,"iges",NULL,
 			command_data_void, gfx_export_iges);
 		Option_table_add_entry(option_table,"stl",NULL,
@@ -7769,6 +8311,38 @@ void create_triangle_mesh(struct cmzn_region *region, Triangle_mesh *trimesh)
 	cmzn_fieldmodule_destroy(&fieldmodule);
 }
 
+#if defined (ZINC_USE_NETGEN)
+/**
+ * Timeout callback polling the background tetrahedral meshing job, creating its
+ * nodes and elements in the region once the mesher has finished.
+ */
+static int gfx_mesh_graphics_tetrahedral_poll(void *command_data_void)
+{
+	struct cmzn_command_data *command_data =
+		static_cast<struct cmzn_command_data *>(command_data_void);
+	if (!command_data)
+		return 0;
+	command_data->generate_netgen_timeout_callback = NULL;
+	if (command_data->generate_netgen_job)
+	{
+		if (command_data->generate_netgen_job->isFinished())
+		{
+			command_data->generate_netgen_job->finish();
+			delete command_data->generate_netgen_job;
+			command_data->generate_netgen_job = NULL;
+		}
+		else
+		{
+			command_data->generate_netgen_timeout_callback =
+				Event_dispatcher_add_timeout_callback(command_data->event_dispatcher,
+					/*timeout_s*/1, /*timeout_ns*/0, gfx_mesh_graphics_tetrahedral_poll,
+					command_data_void);
+		}
+	}
+	return 1;
+}
+#endif /* defined (ZINC_USE_NETGEN) */
+
 static int gfx_mesh_graphics_tetrahedral(struct Parse_state *state,
 	void *dummy_to_be_modified,void *command_data_void)
 {
@@ -7789,12 +8363,30 @@ static int gfx_mesh_graphics_tetrahedral(struct Parse_state *state,
 			int secondorder=0;
 			cmzn_scene_id scene;
 			char *meshsize_file = NULL;
+			char background = 0, cancel = 0, status = 0;
+			double progress_interval = 10.0;
 			struct Option_table *option_table;
 			scene = ACCESS(Scene)(command_data->default_scene);
 			cmzn_scenefilter_id filter =
 				cmzn_scenefiltermodule_get_default_scenefilter(command_data->filter_module);
 			option_table = CREATE(Option_table)();
+			Option_table_add_help(option_table,
+				"Generate a tetrahedral mesh in <region> filling the closed surface "
+				"drawn by the graphics in <scene> passing <filter>. The surface is "
+				"meshed by netgen with <mesh_global_size>, <fineness>, <secondorder> "
+				"and an optional <meshsize_file> on a copy of the surface on a worker "
+				"thread, then the nodes and elements are created in <region> in one "
+				"change, numbered after those already there or replacing them with "
+				"<clear_region>. Without <background> the command waits, reporting "
+				"the elapsed time every <progress_interval> seconds. With "
+				"<background> it returns at once and the mesh is created when ready; "
+				"<status> then reports the elapsed time and <cancel> discards the "
+				"result. Netgen cannot be interrupted, so a cancelled mesher runs to "
+				"completion before another can start, <status> reports it as still "
+				"running, and quitting waits for it to finish.");
 			char clear = 0;
+			Option_table_add_char_flag_entry(option_table, "background", &background);
+			Option_table_add_char_flag_entry(option_table, "cancel", &cancel);
 			Option_table_add_entry(option_table, "region", &region_path,
 				command_data->root_region, set_cmzn_region_path);
 			Option_table_add_entry(option_table, "scene", &scene,
@@ -7811,12 +8403,51 @@ static int gfx_mesh_graphics_tetrahedral(struct Parse_state *state,
 				&secondorder,(void *)NULL,set_int);
 			Option_table_add_string_entry(option_table,"meshsize_file",
 				&meshsize_file, " FILENAME");
+			Option_table_add_double_entry(option_table, "progress_interval",
+				&progress_interval);
+			Option_table_add_char_flag_entry(option_table, "status", &status);
 
 			if ((return_code = Option_table_multi_parse(option_table, state)))
 			{
 #if defined (ZINC_USE_NETGEN)
-				Triangle_mesh *trimesh = NULL;
-				if (scene)
+				Generate_netgen_job *job = command_data->generate_netgen_job;
+				if (cancel || status)
+				{
+					if (!job)
+					{
+						display_message(INFORMATION_MESSAGE,
+							"No tetrahedral meshing is running\n");
+					}
+					else if (cancel)
+					{
+						job->cancel();
+						display_message(INFORMATION_MESSAGE,
+							"Tetrahedral meshing cancelled after %g s; the mesher cannot be "
+							"interrupted and runs to completion in the background, and no other "
+							"meshing can start until it has finished\n", job->getElapsedTime());
+					}
+					else if (job->isCancelled())
+					{
+						display_message(INFORMATION_MESSAGE,
+							"Tetrahedral meshing cancelled: %g s elapsed; the mesher is still "
+							"running and holds netgen, so no other meshing can start until it has "
+							"finished. Quitting waits for it\n", job->getElapsedTime());
+					}
+					else
+					{
+						display_message(INFORMATION_MESSAGE,
+							"Tetrahedral meshing running: %g s elapsed\n", job->getElapsedTime());
+					}
+				}
+				else if (job)
+				{
+					display_message(ERROR_MESSAGE, "gfx_mesh_graphics_tetrahedral.  %s",
+						job->isCancelled() ?
+							"A cancelled mesher is still running; try again when it has finished" :
+							"Tetrahedral meshing is already running; wait or use 'cancel'");
+					return_code = 0;
+				}
+				else if (scene)
 				{
 					float tolerance = 0.000001;
 					build_Scene(scene, filter);
@@ -7834,26 +8465,38 @@ static int gfx_mesh_graphics_tetrahedral(struct Parse_state *state,
 					if (renderer.Scene_compile(scene, filter))
 					{
 						return_code = renderer.Scene_tree_execute(scene);
-						trimesh = renderer.get_triangle_mesh();
 						struct cmzn_region *region = cmzn_region_find_subregion_at_path(
 							command_data->root_region, region_path);
-						if (clear)
-						{
-							cmzn_region_clear_finite_elements(region);
-						}
-						if (trimesh && region)
+						if (renderer.get_triangle_mesh() && region)
 						{
-							struct Generate_netgen_parameters *generate_netgen_para=NULL;
-							generate_netgen_para=create_netgen_parameters();
-							set_netgen_parameters_maxh(generate_netgen_para,maxh);
-							set_netgen_parameters_fineness(generate_netgen_para,fineness);
-							set_netgen_parameters_secondorder(generate_netgen_para,secondorder);
-							set_netgen_parameters_trimesh(generate_netgen_para, trimesh);
-							if (meshsize_file)
-								set_netgen_parameters_meshsize_filename(generate_netgen_para, meshsize_file);
-							generate_mesh_netgen(region, generate_netgen_para);
-							release_netgen_parameters(generate_netgen_para);
-
+							/* the job copies the surface so the renderer need not outlive it */
+							job = new Generate_netgen_job(region, *renderer.get_triangle_mesh(),
+								maxh, fineness, secondorder, meshsize_file, (0 != clear));
+							if (!job->start())
+							{
+								return_code = 0;
+							}
+							else if (background && command_data->event_dispatcher)
+							{
+								command_data->generate_netgen_job = job;
+								command_data->generate_netgen_timeout_callback =
+									Event_dispatcher_add_timeout_callback(command_data->event_dispatcher,
+										/*timeout_s*/1, /*timeout_ns*/0, gfx_mesh_graphics_tetrahedral_poll,
+										command_data_void);
+								job = NULL;
+								display_message(INFORMATION_MESSAGE,
+									"Tetrahedral meshing started in the background\n");
+							}
+							else
+							{
+								if (background)
+								{
+									display_message(WARNING_MESSAGE, "gfx_mesh_graphics_tetrahedral.  "
+										"No event dispatcher to poll background meshing; waiting for it");
+								}
+								return_code = job->wait(progress_interval);
+							}
+							delete job;
 						}
 						else
 						{
@@ -7866,6 +8509,10 @@ static int gfx_mesh_graphics_tetrahedral(struct Parse_state *state,
 #else
 				USE_PARAMETER(scene);
 				USE_PARAMETER(region_path);
+				USE_PARAMETER(background);
+				USE_PARAMETER(cancel);
+				USE_PARAMETER(status);
+				USE_PARAMETER(progress_interval);
 				display_message(ERROR_MESSAGE,
 					"gfx_mesh_graphics. Does not support tetrahedral mesh yet. To use this feature"
 					" please compile cmgui with Netgen");
@@ -8056,6 +8703,100 @@ Executes a GFX EXPORT command.
 	return (return_code);
 } /* execute_command_gfx_export */
 
+/**
+ * Assigns <destination_field> from <source_field> at every node in <nodeset>
+ * where <conditional_field> is true or not supplied, evaluating on
+ * <number_of_threads> threads. Nodes are partitioned into contiguous ranges in
+ * iteration order, each evaluated with its own field cache, so each thread
+ * only accesses its own nodes; all values are then assigned on this thread in
+ * one change bracket. Results match cmzn_nodeset_assign_field_from_source
+ * provided source values at a node do not depend on destination values at
+ * other nodes. Only call for node-local source and conditional fields, see
+ * cmzn_field_is_node_local, as other fields share element and image
+ * state between caches.
+ * @param number_of_points_address  On return, number of nodes in nodeset.
+ * @return  Result OK, WARNING_PART_DONE if any node failed, or error.
+ */
+static int gfx_evaluate_nodeset_threaded(cmzn_fieldmodule_id field_module,
+	cmzn_nodeset_id nodeset, cmzn_field_id destination_field,
+	cmzn_field_id source_field, cmzn_field_id conditional_field, FE_value time,
+	int number_of_threads, int *number_of_points_address)
+{
+	const int number_of_components = cmzn_field_get_number_of_components(source_field);
+	if ((number_of_components < 1) ||
+		(number_of_components != cmzn_field_get_number_of_components(destination_field)) ||
+		(CMZN_FIELD_VALUE_TYPE_REAL != cmzn_field_get_value_type(source_field)))
+	{
+		display_message(ERROR_MESSAGE, "gfx evaluate:  Source field must be real "
+			"valued with the same number of components as the destination");
+		return CMZN_ERROR_ARGUMENT;
+	}
+	std::vector<cmzn_node_id> nodes;
+	nodes.reserve(cmzn_nodeset_get_size(nodeset));
+	cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(nodeset);
+	cmzn_node_id node;
+	while (0 != (node = cmzn_nodeiterator_next(iterator)))
+		nodes.push_back(node);
+	cmzn_nodeiterator_destroy(&iterator);
+	const int number_of_nodes = static_cast<int>(nodes.size());
+	*number_of_points_address = number_of_nodes;
+	number_of_threads = cmgui_get_number_of_threads_for_items(number_of_threads,
+		number_of_nodes);
+	/* caches are created and destroyed here as they register with the region */
+	std::vector<cmzn_fieldcache_id> field_caches(number_of_threads);
+	for (int t = 0; t < number_of_threads; ++t)
+	{
+		field_caches[t] = cmzn_fieldmodule_create_fieldcache(field_module);
+		cmzn_fieldcache_set_time(field_caches[t], time);
+	}
+	enum
+	{
+		NODE_SKIPPED = 0,
+		NODE_EVALUATED = 1,
+		NODE_FAILED = 2
+	};
+	std::vector<double> values(static_cast<size_t>(number_of_nodes)*number_of_components);
+	std::vector<unsigned char> node_states(number_of_nodes, NODE_SKIPPED);
+	cmgui_parallel_for_ranges(number_of_nodes, number_of_threads,
+		[&](int thread_index, int begin, int end)
+	{
+		cmzn_fieldcache_id field_cache = field_caches[thread_index];
+		for (int i = begin; i < end; ++i)
+		{
+			cmzn_fieldcache_set_node(field_cache, nodes[i]);
+			if (conditional_field &&
+				(!cmzn_field_evaluate_boolean(conditional_field, field_cache)))
+				continue;
+			node_states[i] = (CMZN_OK == cmzn_field_evaluate_real(source_field,
+				field_cache, number_of_components,
+				values.data() + static_cast<size_t>(i)*number_of_components)) ?
+				NODE_EVALUATED : NODE_FAILED;
+		}
+	});
+	int number_of_failures = 0;
+	cmzn_fieldmodule_begin_change(field_module);
+	for (int i = 0; i < number_of_nodes; ++i)
+	{
+		if (NODE_EVALUATED == node_states[i])
+		{
+			cmzn_fieldcache_set_node(field_caches[0], nodes[i]);
+			if (CMZN_OK != cmzn_field_assign_real(destination_field, field_caches[0],
+				number_of_components, values.data() + static_cast<size_t>(i)*number_of_components))
+				++number_of_failures;
+		}
+		else if (NODE_FAILED == node_states[i])
+		{
+			++number_of_failures;
+		}
+	}
+	cmzn_fieldmodule_end_change(field_module);
+	for (int t = 0; t < number_of_threads; ++t)
+		cmzn_fieldcache_destroy(&field_caches[t]);
+	for (int i = 0; i < number_of_nodes; ++i)
+		cmzn_node_destroy(&nodes[i]);
+	return (0 == number_of_failures) ? CMZN_RESULT_OK : CMZN_RESULT_WARNING_PART_DONE;
+}
+
 /***************************************************************************//**
  * Executes a GFX EVALUATE DGROUP/EGROUP/NGROUP command.
  */
@@ -8076,14 +8817,27 @@ int gfx_evaluate(struct Parse_state *state, void *dummy_to_be_modified,
 		char *source_field_name = 0;
 		char *destination_field_name = 0;
 		FE_value time = 0;
+		int number_of_threads = 1;
 
 		Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Assigns the destination field from the source field at nodes, data "
+			"points or element grid points in a region or group, optionally only "
+			"where selected. For dgroup and ngroup, threads N > 1 evaluates the "
+			"source on N threads (0 = number of hardware threads) with one field "
+			"cache each, then assigns all values together; the source must not "
+			"depend on destination values at other nodes. Threads are only used "
+			"if the source is built from nodal finite element, constant and "
+			"arithmetic fields which read nothing but the node being evaluated; "
+			"otherwise it is evaluated on one thread with a warning. The number "
+			"of points per second evaluated is reported.");
 		Option_table_add_string_entry(option_table, "destination", &destination_field_name, " FIELD_NAME");
 		Option_table_add_string_entry(option_table, "dgroup", &data_region_path, " REGION_PATH/GROUP_NAME");
 		Option_table_add_string_entry(option_table, "egroup", &element_region_path, " REGION_PATH/GROUP_NAME");
 		Option_table_add_string_entry(option_table, "ngroup", &node_region_path, " REGION_PATH/GROUP_NAME");
 		Option_table_add_char_flag_entry(option_table, "selected", &selected_flag);
 		Option_table_add_string_entry(option_table, "source", &source_field_name, " FIELD_NAME");
+		Option_table_add_int_non_negative_entry(option_table, "threads", &number_of_threads);
 
 		if (0 != (return_code = Option_table_multi_parse(option_table, state)))
 		{
@@ -8154,12 +8908,43 @@ int gfx_evaluate(struct Parse_state *state, void *dummy_to_be_modified,
 							}
 							if (nodeset)
 							{
-								const int result = cmzn_nodeset_assign_field_from_source(nodeset, destination_field, source_field,
-									/*conditional_field*/selection_field, time);
+								const std::chrono::steady_clock::time_point start_time =
+									std::chrono::steady_clock::now();
+								int number_of_points = 0;
+								int result;
+								if ((1 != number_of_threads) &&
+									!(cmzn_field_is_node_local(source_field) &&
+										((!selection_field) || cmzn_field_is_node_local(selection_field))))
+								{
+									display_message(WARNING_MESSAGE,
+										"gfx evaluate:  Source field %s depends on fields not local to "
+										"each node; evaluating on one thread", source_field_name);
+									number_of_threads = 1;
+								}
+								if (1 == number_of_threads)
+								{
+									number_of_points = cmzn_nodeset_get_size(nodeset);
+									result = cmzn_nodeset_assign_field_from_source(nodeset, destination_field, source_field,
+										/*conditional_field*/selection_field, time);
+								}
+								else
+								{
+									result = gfx_evaluate_nodeset_threaded(field_module, nodeset,
+										destination_field, source_field, /*conditional_field*/selection_field,
+										time, number_of_threads, &number_of_points);
+								}
 								if ((CMZN_RESULT_OK != result) && (CMZN_RESULT_WARNING_PART_DONE != result))
 								{
 									return_code = 0;
 								}
+								else
+								{
+									const double seconds = std::chrono::duration<double>(
+										std::chrono::steady_clock::now() - start_time).count();
+									display_message(INFORMATION_MESSAGE,
+										"gfx evaluate:  %d points in %g s (%g points/s)\n", number_of_points,
+										seconds, (0.0 < seconds) ? number_of_points/seconds : 0.0);
+								}
 								cmzn_nodeset_destroy(&nodeset);
 							}
 						}
@@ -8176,6 +8961,12 @@ int gfx_evaluate(struct Parse_state *state, void *dummy_to_be_modified,
 							}
 							if (mesh)
 							{
+								if (1 != number_of_threads)
+								{
+									display_message(WARNING_MESSAGE,
+										"gfx evaluate:  threads only applies to dgroup and ngroup; "
+										"evaluating element grid on one thread");
+								}
 								return_code = cmzn_mesh_assign_grid_field_from_source(mesh, destination_field, source_field,
 									/*conditional_field*/selection_field,
 									element_point_ranges_selection, time);
@@ -8426,7 +9217,9 @@ Executes a GFX LIST FIELD.
 ==============================================================================*/
 {
 	static const char	*command_prefix="gfx define field ";
-	char commands_flag, *command_prefix_plus_region_path;
+	char commands_flag, graph_flag, *command_prefix_plus_region_path, *mesh_name,
+		*nodeset_name, profile_flag;
+	int sample_size;
 	int path_length, return_code;
 	struct cmzn_region *root_region;
 	struct cmzn_region_path_and_name region_path_and_name;
@@ -8440,14 +9233,34 @@ Executes a GFX LIST FIELD.
 	if (state && (root_region = (struct cmzn_region *)root_region_void))
 	{
 		commands_flag=0;
+		graph_flag = 0;
+		mesh_name = (char *)NULL;
+		nodeset_name = (char *)NULL;
+		profile_flag = 0;
+		sample_size = 1000;
 		region_path_and_name.region = (struct cmzn_region *)NULL;
 		region_path_and_name.region_path = (char *)NULL;
 		region_path_and_name.name = (char *)NULL;
 
 		option_table=CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Lists the named field, or the names of all fields in the region. "
+			"commands lists the gfx define field commands needed to recreate them. "
+			"graph lists the graph of source fields of the named field with their "
+			"types, marking fields shared by several paths. profile also times the "
+			"evaluation of each field in the graph at up to sample_size nodes of "
+			"the nodeset, or element centres of the mesh if given, listing the most "
+			"expensive fields first.");
 		/* commands */
 		Option_table_add_entry(option_table, "commands", &commands_flag, NULL,
 			set_char_flag);
+		Option_table_add_char_flag_entry(option_table, "graph", &graph_flag);
+		Option_table_add_string_entry(option_table, "mesh", &mesh_name,
+			" ELEMENT_GROUP_FIELD_NAME|[GROUP_NAME.]mesh1d|mesh2d|mesh3d");
+		Option_table_add_string_entry(option_table, "nodeset", &nodeset_name,
+			" NODE_GROUP_FIELD_NAME|[GROUP_NAME.]nodes|datapoints");
+		Option_table_add_char_flag_entry(option_table, "profile", &profile_flag);
+		Option_table_add_int_positive_entry(option_table, "sample_size", &sample_size);
 		/* default option: region_path and/or field_name */
 		Option_table_add_region_path_and_or_field_name_entry(
 			option_table, (char *)NULL, &region_path_and_name, root_region);
@@ -8482,9 +9295,56 @@ Executes a GFX LIST FIELD.
 				{
 					region_path_and_name.region = cmzn_region_access(root_region);
 				}
-				if (commands_flag)
+				if (graph_flag || profile_flag)
 				{
-					if (ALLOCATE(command_prefix_plus_region_path,char,
+					if (field)
+					{
+						cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(field);
+						cmzn_mesh_id mesh = (cmzn_mesh_id)NULL;
+						cmzn_nodeset_id nodeset = (cmzn_nodeset_id)NULL;
+						if (profile_flag)
+						{
+							if (mesh_name)
+							{
+								mesh = cmzn_fieldmodule_find_mesh_by_name(field_module, mesh_name);
+								if (!mesh)
+								{
+									display_message(ERROR_MESSAGE,
+										"gfx list field:  Unknown mesh %s", mesh_name);
+									return_code = 0;
+								}
+							}
+							else
+							{
+								nodeset = cmzn_fieldmodule_find_nodeset_by_name(field_module,
+									(nodeset_name) ? nodeset_name : "nodes");
+								if (!nodeset)
+								{
+									display_message(ERROR_MESSAGE,
+										"gfx list field:  Unknown nodeset %s", (nodeset_name) ? nodeset_name : "nodes");
+									return_code = 0;
+								}
+							}
+						}
+						if (return_code)
+						{
+							return_code = Computed_field_list_graph(field, profile_flag,
+								nodeset, mesh, sample_size);
+						}
+						cmzn_nodeset_destroy(&nodeset);
+						cmzn_mesh_destroy(&mesh);
+						cmzn_fieldmodule_destroy(&field_module);
+					}
+					else
+					{
+						display_message(ERROR_MESSAGE,
+							"gfx list field:  Must name a field to list its graph");
+						return_code = 0;
+					}
+				}
+				else if (commands_flag)
+				{
+					if (ALLOCATE(command_prefix_plus_region_path,char,
 						strlen(command_prefix)+1+path_length))
 					{
 						strcpy(command_prefix_plus_region_path,command_prefix);
@@ -8561,6 +9421,14 @@ Executes a GFX LIST FIELD.
 		{
 			DEALLOCATE(region_path_and_name.name);
 		}
+		if (mesh_name)
+		{
+			DEALLOCATE(mesh_name);
+		}
+		if (nodeset_name)
+		{
+			DEALLOCATE(nodeset_name);
+		}
 	}
 	else
 	{
@@ -9683,6 +10551,28 @@ Executes a GFX LIST SPECTRUM.
 	return (return_code);
 } /* gfx_list_spectrum */
 
+/**
+ * Lists the image <field> as list_image_field does, followed by the storage
+ * and memory use of its texture.
+ */
+static int list_image_field_and_storage(struct Computed_field *field,
+	void *dummy_void)
+{
+	int return_code = list_image_field(field, dummy_void);
+	if (return_code)
+	{
+		cmzn_field_image_id image = cmzn_field_cast_image(field);
+		if (image)
+		{
+			struct Texture *texture = cmzn_field_image_get_texture(image);
+			if (texture)
+				return_code = Texture_list_storage(texture);
+			cmzn_field_image_destroy(&image);
+		}
+	}
+	return (return_code);
+}
+
 static int gfx_list_texture(struct Parse_state *state,
 	void *dummy_to_be_modified,void *region_void)
 /*******************************************************************************
@@ -9752,7 +10642,7 @@ Executes a GFX LIST TEXTURE.
 								}
 								else
 								{
-									return_code=list_image_field(existing_field,NULL);
+									return_code=list_image_field_and_storage(existing_field,NULL);
 								}
 							}
 							else
@@ -9778,7 +10668,7 @@ Executes a GFX LIST TEXTURE.
 						else
 						{
 							return_code=FOR_EACH_OBJECT_IN_MANAGER(Computed_field)(
-									list_image_field,(void *)NULL,field_manager);
+									list_image_field_and_storage,(void *)NULL,field_manager);
 						}
 					}
 					cmzn_region_destroy(&region);
@@ -10129,6 +11019,11 @@ Executes a GFX LIST command.
 			/* group */
 			Option_table_add_entry(option_table, "group", (void *)0,
 				command_data->root_region, gfx_list_group);
+#if defined (ZINC_USE_ITK)
+			/* image_filters */
+			Option_table_add_entry(option_table, "image_filters", NULL,
+				(void *)command_data->image_filter_package, gfx_list_image_filters);
+#endif /* defined (ZINC_USE_ITK) */
 			/* light */
 			Option_table_add_entry(option_table, "light", NULL,
 				cmzn_lightmodule_get_manager(command_data->lightmodule), gfx_list_light);
@@ -11569,13 +12464,631 @@ Which tool that is being modified is passed in <node_tool_void>.
 			  (WIN32_USER_INTERFACE) || defined (CARBON_USER_INTERFACE) || defined(WX_USER_INTERFACE */
 
 #if defined (GTK_USER_INTERFACE) || defined (WIN32_USER_INTERFACE) || defined (WX_USER_INTERFACE)
-static int execute_command_gfx_print(struct Parse_state *state,
+namespace {
+
+/** One view on a camera path. View angle is in radians. */
+struct Camera_path_view
+{
+	double eye[3], lookat[3], up[3];
+	double view_angle;
+};
+
+/** A rendered frame waiting to be written by an encoder thread. */
+struct Camera_path_frame
+{
+	struct Cmgui_image *cmgui_image;
+	struct Cmgui_image_information *cmgui_image_information;
+};
+
+/**
+ * Rotates <vector> by <angle> radians about the unit <axis> using Rodrigues'
+ * formula, writing the result to <result>.
+ */
+void camera_path_rotate_vector(const double *vector, const double *axis,
+	double angle, double *result)
+{
+	const double c = cos(angle);
+	const double s = sin(angle);
+	const double dot = axis[0]*vector[0] + axis[1]*vector[1] + axis[2]*vector[2];
+	double cross[3];
+	cross[0] = axis[1]*vector[2] - axis[2]*vector[1];
+	cross[1] = axis[2]*vector[0] - axis[0]*vector[2];
+	cross[2] = axis[0]*vector[1] - axis[1]*vector[0];
+	for (int i = 0; i < 3; ++i)
+		result[i] = vector[i]*c + cross[i]*s + axis[i]*dot*(1.0 - c);
+}
+
+/**
+ * Reads keyframe views from <file_name>. Each line holds
+ * EYE_X EYE_Y EYE_Z LOOKAT_X LOOKAT_Y LOOKAT_Z UP_X UP_Y UP_Z [VIEW_ANGLE]
+ * with an optional view angle in degrees; blank lines and lines starting with
+ * # are ignored. Views without an angle keep <default_view_angle>.
+ */
+int camera_path_read_keyframes(const char *file_name, double default_view_angle,
+	std::vector<Camera_path_view>& keyframes)
+{
+	FILE *file = fopen(file_name, "r");
+	if (!file)
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx print camera_path:  Could not open keyframes file %s", file_name);
+		return 0;
+	}
+	int return_code = 1;
+	int line_number = 0;
+	char line[1024];
+	while (return_code && fgets(line, sizeof(line), file))
+	{
+		++line_number;
+		const char *text = line;
+		while ((' ' == *text) || ('\t' == *text))
+			++text;
+		if (('#' == *text) || ('\n' == *text) || ('\r' == *text) || ('\0' == *text))
+			continue;
+		Camera_path_view view;
+		double view_angle_degrees = 0.0;
+		const int count = sscanf(text, "%lf %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+			&view.eye[0], &view.eye[1], &view.eye[2],
+			&view.lookat[0], &view.lookat[1], &view.lookat[2],
+			&view.up[0], &view.up[1], &view.up[2], &view_angle_degrees);
+		if (count < 9)
+		{
+			display_message(ERROR_MESSAGE, "gfx print camera_path:  "
+				"Expected 9 or 10 values on line %d of %s", line_number, file_name);
+			return_code = 0;
+		}
+		else
+		{
+			view.view_angle = (count == 10) ? view_angle_degrees*(PI/180.0) :
+				default_view_angle;
+			keyframes.push_back(view);
+		}
+	}
+	fclose(file);
+	if (return_code && (keyframes.size() == 0))
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx print camera_path:  No keyframes in %s", file_name);
+		return_code = 0;
+	}
+	return return_code;
+}
+
+/**
+ * Returns an allocated file name for <frame_number> from <file_name_template>.
+ * A run of # characters in the template is replaced by the zero-padded frame
+ * number; otherwise _NNNN is inserted before the file extension.
+ */
+char *camera_path_get_frame_file_name(const char *file_name_template,
+	int frame_number)
+{
+	std::string name(file_name_template);
+	const size_t hash_start = name.find('#');
+	char number[32];
+	if (std::string::npos != hash_start)
+	{
+		size_t hash_end = name.find_first_not_of('#', hash_start);
+		if (std::string::npos == hash_end)
+			hash_end = name.size();
+		/* pad to any number of # characters without a fixed size buffer */
+		sprintf(number, "%d", frame_number);
+		std::string padded_number(number);
+		if (padded_number.size() < hash_end - hash_start)
+			padded_number.insert(0, hash_end - hash_start - padded_number.size(), '0');
+		name.replace(hash_start, hash_end - hash_start, padded_number);
+	}
+	else
+	{
+		sprintf(number, "_%04d", frame_number);
+		const size_t slash = name.find_last_of("/\\");
+		size_t dot = name.rfind('.');
+		if ((std::string::npos == dot) ||
+			((std::string::npos != slash) && (dot < slash)))
+		{
+			dot = name.size();
+		}
+		name.insert(dot, number);
+	}
+	return duplicate_string(name.c_str());
+}
+
+/**
+ * Writes and destroys <frame>. If <write_mutex> is given it is locked while
+ * writing, as image writing and the error messages it may display are not
+ * thread-safe. @return  true on success.
+ */
+bool camera_path_write_frame(Camera_path_frame& frame, std::mutex *write_mutex)
+{
+	bool result;
+	if (write_mutex)
+	{
+		std::lock_guard<std::mutex> lock(*write_mutex);
+		result = (0 != Cmgui_image_write(frame.cmgui_image,
+			frame.cmgui_image_information));
+	}
+	else
+	{
+		result = (0 != Cmgui_image_write(frame.cmgui_image,
+			frame.cmgui_image_information));
+	}
+	DESTROY(Cmgui_image)(&frame.cmgui_image);
+	DESTROY(Cmgui_image_information)(&frame.cmgui_image_information);
+	return result;
+}
+
+} // anonymous namespace
+
+/**
+ * Executes a GFX PRINT CAMERA_PATH command. Renders a turntable or a
+ * keyframed fly-through from one window into numbered image files, reusing
+ * the window's pooled offscreen buffers for every frame and optionally writing
+ * the images on a separate encoder thread while the next frame is drawn.
+ */
+static int execute_command_gfx_print_camera_path(struct Parse_state *state,
+	void *dummy_to_be_modified, void *command_data_void)
+{
+	USE_PARAMETER(dummy_to_be_modified);
+	struct cmzn_command_data *command_data =
+		static_cast<struct cmzn_command_data *>(command_data_void);
+	if (!(state && command_data))
+	{
+		display_message(ERROR_MESSAGE,
+			"execute_command_gfx_print_camera_path.  Invalid argument(s)");
+		return 0;
+	}
+	char *file_name = 0;
+	char *keyframes_file_name = 0;
+	char video_stream_flag = 0;
+	enum Image_file_format image_file_format = UNKNOWN_IMAGE_FILE_FORMAT;
+	enum Texture_storage_type storage = TEXTURE_RGBA;
+	int antialias = -1;
+	int first_frame_number = 0;
+	int frames_between = 0;
+	int height = 0;
+	int pane_no = 1;
+	int queue_frames = 0;
+	int transparency_layers = 0;
+	int turntable_frames = 0;
+	int width = 0;
+	double turntable_angle = 360.0;
+	double turntable_axis[3] = { 0.0, 0.0, 0.0 };
+	int number_of_axis_components = 3;
+	struct Graphics_window *window = FIRST_OBJECT_IN_MANAGER_THAT(Graphics_window)(
+		(MANAGER_CONDITIONAL_FUNCTION(Graphics_window) *)NULL,
+		(void *)NULL, command_data->graphics_window_manager);
+	if (window)
+	{
+		ACCESS(Graphics_window)(window);
+	}
+
+	struct Option_table *option_table = CREATE(Option_table)();
+	Option_table_add_help(option_table,
+		"Renders a sequence of views from a graphics window into numbered image "
+		"files. Either give turntable_frames to rotate the view about "
+		"turntable_axis (default is the current up vector) through the lookat "
+		"point by turntable_angle degrees, or give a keyframes file with one view "
+		"per line: EYE(3) LOOKAT(3) UP(3) [VIEW_ANGLE_DEGREES], with "
+		"frames_between views interpolated linearly between consecutive keyframes. "
+		"A run of # characters in the file name is replaced by the frame number, "
+		"otherwise _NNNN is added before the extension. The window's pooled "
+		"offscreen buffers and built graphics are reused for all frames. With queue_frames > 0 images "
+		"are written on a separate encoder thread while later frames are rendered, with up to "
+		"queue_frames frames waiting to be written. With "
+		"video_stream, frames are appended to the window's open video stream "
+		"instead of image files; see 'gfx print video_stream'. The original view "
+		"is restored afterwards.");
+	Option_table_add_entry(option_table, "antialias",
+		&antialias, NULL, set_int_positive);
+	Option_table_add_entry(option_table, "file", &file_name,
+		(void *)1, set_name);
+	Option_table_add_int_non_negative_entry(option_table, "first_frame_number",
+		&first_frame_number);
+	Option_table_add_entry(option_table, "format", &storage,
+		NULL, set_Texture_storage);
+	Option_table_add_int_non_negative_entry(option_table, "frames_between",
+		&frames_between);
+	Option_table_add_entry(option_table, "height",
+		&height, NULL, set_int_non_negative);
+	const char *image_file_format_string =
+		ENUMERATOR_STRING(Image_file_format)(image_file_format);
+	int number_of_valid_strings;
+	const char **valid_strings = ENUMERATOR_GET_VALID_STRINGS(Image_file_format)(
+		&number_of_valid_strings,
+		(ENUMERATOR_CONDITIONAL_FUNCTION(Image_file_format) *)NULL,
+		(void *)NULL);
+	Option_table_add_enumerator(option_table, number_of_valid_strings,
+		valid_strings, &image_file_format_string);
+	DEALLOCATE(valid_strings);
+	Option_table_add_entry(option_table, "keyframes", &keyframes_file_name,
+		(void *)1, set_name);
+	Option_table_add_int_positive_entry(option_table, "pane",
+		&pane_no);
+	Option_table_add_int_non_negative_entry(option_table, "queue_frames",
+		&queue_frames);
+	Option_table_add_entry(option_table, "transparency_layers",
+		&transparency_layers, NULL, set_int_positive);
+	Option_table_add_double_entry(option_table, "turntable_angle",
+		&turntable_angle);
+	Option_table_add_double_vector_entry(option_table, "turntable_axis",
+		turntable_axis, &number_of_axis_components);
+	Option_table_add_int_non_negative_entry(option_table, "turntable_frames",
+		&turntable_frames);
+	Option_table_add_char_flag_entry(option_table, "video_stream",
+		&video_stream_flag);
+	Option_table_add_entry(option_table, "width",
+		&width, NULL, set_int_non_negative);
+	Option_table_add_entry(option_table, "window",
+		&window, command_data->graphics_window_manager, set_Graphics_window);
+	int return_code = Option_table_multi_parse(option_table, state);
+	DESTROY(Option_table)(&option_table);
+
+	std::vector<Camera_path_view> views;
+	Camera_path_view original_view;
+	if (return_code)
+	{
+		if (!window)
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx print camera_path:  No graphics windows to print");
+			return_code = 0;
+		}
+		else if (video_stream_flag)
+		{
+			if (!Graphics_window_has_video_stream(window))
+			{
+				display_message(ERROR_MESSAGE, "gfx print camera_path:  "
+					"No video stream open. Use 'gfx print video_stream open'");
+				return_code = 0;
+			}
+		}
+		else if (!file_name)
+		{
+			display_message(ERROR_MESSAGE, "gfx print camera_path:  No file name specified");
+			return_code = 0;
+		}
+		if ((0 < turntable_frames) == (0 != keyframes_file_name))
+		{
+			display_message(ERROR_MESSAGE, "gfx print camera_path:  "
+				"Specify exactly one of turntable_frames or keyframes");
+			return_code = 0;
+		}
+	}
+	if (return_code)
+	{
+		return_code = Graphics_window_get_pane_view(window, pane_no - 1,
+			original_view.eye, original_view.lookat, original_view.up,
+			&original_view.view_angle);
+	}
+	if (return_code)
+	{
+		if (0 < turntable_frames)
+		{
+			double axis[3], eye_offset[3];
+			for (int i = 0; i < 3; ++i)
+			{
+				axis[i] = turntable_axis[i];
+				eye_offset[i] = original_view.eye[i] - original_view.lookat[i];
+			}
+			if (0.0 == norm3(axis))
+			{
+				for (int i = 0; i < 3; ++i)
+					axis[i] = original_view.up[i];
+			}
+			if (0.0 < normalize3(axis))
+			{
+				views.resize(turntable_frames);
+				for (int f = 0; f < turntable_frames; ++f)
+				{
+					Camera_path_view& view = views[f];
+					const double angle = (turntable_angle*(PI/180.0)*f)/turntable_frames;
+					camera_path_rotate_vector(eye_offset, axis, angle, view.eye);
+					camera_path_rotate_vector(original_view.up, axis, angle, view.up);
+					for (int i = 0; i < 3; ++i)
+					{
+						view.eye[i] += original_view.lookat[i];
+						view.lookat[i] = original_view.lookat[i];
+					}
+					view.view_angle = original_view.view_angle;
+				}
+			}
+			else
+			{
+				display_message(ERROR_MESSAGE,
+					"gfx print camera_path:  Invalid turntable_axis");
+				return_code = 0;
+			}
+		}
+		else
+		{
+			std::vector<Camera_path_view> keyframes;
+			return_code = camera_path_read_keyframes(keyframes_file_name,
+				original_view.view_angle, keyframes);
+			if (return_code)
+			{
+				const size_t number_of_keyframes = keyframes.size();
+				for (size_t k = 0; k < number_of_keyframes; ++k)
+				{
+					views.push_back(keyframes[k]);
+					if (k + 1 < number_of_keyframes)
+					{
+						const Camera_path_view& key1 = keyframes[k];
+						const Camera_path_view& key2 = keyframes[k + 1];
+						for (int f = 1; f <= frames_between; ++f)
+						{
+							const double xi = static_cast<double>(f)/(frames_between + 1);
+							Camera_path_view view;
+							for (int i = 0; i < 3; ++i)
+							{
+								view.eye[i] = (1.0 - xi)*key1.eye[i] + xi*key2.eye[i];
+								view.lookat[i] = (1.0 - xi)*key1.lookat[i] + xi*key2.lookat[i];
+								view.up[i] = (1.0 - xi)*key1.up[i] + xi*key2.up[i];
+							}
+							view.view_angle = (1.0 - xi)*key1.view_angle + xi*key2.view_angle;
+							views.push_back(view);
+						}
+					}
+				}
+			}
+		}
+	}
+	if (return_code && (0 < views.size()))
+	{
+		if (image_file_format_string)
+		{
+			STRING_TO_ENUMERATOR(Image_file_format)(
+				image_file_format_string, &image_file_format);
+		}
+		const int number_of_frames = static_cast<int>(views.size());
+		Cmgui_bounded_queue<Camera_path_frame> frame_queue(queue_frames);
+		std::atomic<int> write_failures(0);
+		/* image writing and messages are not thread-safe, so frames are written
+		 * on one encoder thread which holds this mutex while writing; the main
+		 * thread holds it while displaying messages during the sequence */
+		std::mutex write_mutex;
+		std::thread encoder;
+		if ((!video_stream_flag) && (0 < queue_frames))
+		{
+			encoder = std::thread([&frame_queue, &write_failures, &write_mutex]()
+			{
+				Camera_path_frame frame;
+				while (frame_queue.pop(frame))
+				{
+					if (!camera_path_write_frame(frame, &write_mutex))
+						++write_failures;
+				}
+			});
+		}
+		const std::chrono::steady_clock::time_point start_time =
+			std::chrono::steady_clock::now();
+		double render_seconds = 0.0;
+		int frames_printed = 0;
+		for (int f = 0; return_code && (f < number_of_frames); ++f)
+		{
+			const Camera_path_view& view = views[f];
+			if (!Graphics_window_set_pane_view(window, pane_no - 1,
+				view.eye, view.lookat, view.up, view.view_angle))
+			{
+				return_code = 0;
+				break;
+			}
+			const std::chrono::steady_clock::time_point render_start =
+				std::chrono::steady_clock::now();
+			if (video_stream_flag)
+			{
+				/* stream has its own writer thread so no encoders are needed */
+				if (!Graphics_window_write_video_frame(window, antialias,
+					transparency_layers))
+				{
+					display_message(ERROR_MESSAGE, "gfx print camera_path:  "
+						"Could not write frame %d to video stream", first_frame_number + f);
+					return_code = 0;
+					break;
+				}
+				render_seconds += std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - render_start).count();
+				++frames_printed;
+				continue;
+			}
+			Camera_path_frame frame;
+			frame.cmgui_image = Graphics_window_get_image(window,
+				/*force_onscreen*/0, width, height, antialias,
+				transparency_layers, storage);
+			render_seconds += std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - render_start).count();
+			if (!frame.cmgui_image)
+			{
+				std::lock_guard<std::mutex> lock(write_mutex);
+				display_message(ERROR_MESSAGE,
+					"gfx print camera_path:  Could not get image for frame %d",
+					first_frame_number + f);
+				return_code = 0;
+				break;
+			}
+			char *frame_file_name = camera_path_get_frame_file_name(file_name,
+				first_frame_number + f);
+			frame.cmgui_image_information = CREATE(Cmgui_image_information)();
+			Cmgui_image_information_set_image_file_format(
+				frame.cmgui_image_information, image_file_format);
+			Cmgui_image_information_add_file_name(frame.cmgui_image_information,
+				frame_file_name);
+			Cmgui_image_information_set_io_stream_package(
+				frame.cmgui_image_information, command_data->io_stream_package);
+			DEALLOCATE(frame_file_name);
+			if (!encoder.joinable())
+			{
+				if (!camera_path_write_frame(frame, /*write_mutex*/0))
+					++write_failures;
+			}
+			else
+			{
+				frame_queue.push(frame);
+			}
+			++frames_printed;
+		}
+		frame_queue.close();
+		if (encoder.joinable())
+			encoder.join();
+		const double total_seconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start_time).count();
+		Graphics_window_set_pane_view(window, pane_no - 1, original_view.eye,
+			original_view.lookat, original_view.up, original_view.view_angle);
+		Graphics_window_update(window);
+		if (0 < write_failures)
+		{
+			display_message(ERROR_MESSAGE, "gfx print camera_path:  "
+				"Failed to write %d of %d frames", static_cast<int>(write_failures),
+				frames_printed);
+			return_code = 0;
+		}
+		display_message(INFORMATION_MESSAGE,
+			"gfx print camera_path:  %d frames in %g s (render %g s, %g ms/frame)\n",
+			frames_printed, total_seconds, render_seconds,
+			(0 < frames_printed) ? 1000.0*render_seconds/frames_printed : 0.0);
+	}
+	if (window)
+	{
+		DEACCESS(Graphics_window)(&window);
+	}
+	if (keyframes_file_name)
+	{
+		DEALLOCATE(keyframes_file_name);
+	}
+	if (file_name)
+	{
+		DEALLOCATE(file_name);
+	}
+	return return_code;
+}
+
+static int execute_command_gfx_print_video_stream(struct Parse_state *state,
+	void *dummy_to_be_modified, void *command_data_void)
+{
+	USE_PARAMETER(dummy_to_be_modified);
+	struct cmzn_command_data *command_data =
+		static_cast<struct cmzn_command_data *>(command_data_void);
+	if (!(state && command_data))
+	{
+		display_message(ERROR_MESSAGE,
+			"execute_command_gfx_print_video_stream.  Invalid argument(s)");
+		return 0;
+	}
+	char close_flag = 0;
+	char open_flag = 0;
+	char *command = 0;
+	char *file_name = 0;
+	int antialias = -1;
+	int frame_rate = 25;
+	int height = 0;
+	int queue_size = 8;
+	int transparency_layers = 0;
+	int width = 0;
+	struct Graphics_window *window = FIRST_OBJECT_IN_MANAGER_THAT(Graphics_window)(
+		(MANAGER_CONDITIONAL_FUNCTION(Graphics_window) *)NULL,
+		(void *)NULL, command_data->graphics_window_manager);
+	if (window)
+	{
+		ACCESS(Graphics_window)(window);
+	}
+	const char *format_strings[] = {
+		Video_stream_format_string(VIDEO_STREAM_FORMAT_Y4M),
+		Video_stream_format_string(VIDEO_STREAM_FORMAT_RAW_RGB)
+	};
+	const char *format_string = format_strings[0];
+
+	struct Option_table *option_table = CREATE(Option_table)();
+	Option_table_add_help(option_table,
+		"Opens or closes a stream of uncompressed frames for a graphics window. "
+		"While open, 'gfx print video_stream' and 'gfx print camera_path "
+		"video_stream' append rendered frames to the stream instead of writing "
+		"image files. Frames go to a file, or to the standard input of a shell "
+		"command such as an encoder (e.g. command \"ffmpeg -y -i - out.mp4\"), as "
+		"YUV4MPEG2 with 4:4:4 chroma (y4m) or headerless top-row-first rgb24 "
+		"(raw_rgb). Width and height default to the current viewing area size. "
+		"Frames are converted and written on a separate thread with up to "
+		"queue_size frames buffered. Without open or close, one frame is "
+		"rendered with the given antialias and transparency_layers and appended "
+		"to the window's open stream.");
+	Option_table_add_entry(option_table, "antialias",
+		&antialias, NULL, set_int_positive);
+	Option_table_add_char_flag_entry(option_table, "close", &close_flag);
+	Option_table_add_entry(option_table, "command", &command,
+		(void *)1, set_name);
+	Option_table_add_entry(option_table, "file", &file_name,
+		(void *)1, set_name);
+	Option_table_add_enumerator(option_table, 2, format_strings, &format_string);
+	Option_table_add_int_positive_entry(option_table, "frame_rate", &frame_rate);
+	Option_table_add_entry(option_table, "height",
+		&height, NULL, set_int_non_negative);
+	Option_table_add_char_flag_entry(option_table, "open", &open_flag);
+	Option_table_add_int_positive_entry(option_table, "queue_size", &queue_size);
+	Option_table_add_entry(option_table, "transparency_layers",
+		&transparency_layers, NULL, set_int_positive);
+	Option_table_add_entry(option_table, "width",
+		&width, NULL, set_int_non_negative);
+	Option_table_add_entry(option_table, "window",
+		&window, command_data->graphics_window_manager, set_Graphics_window);
+	int return_code = Option_table_multi_parse(option_table, state);
+	DESTROY(Option_table)(&option_table);
+	if (return_code)
+	{
+		if (!window)
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx print video_stream:  No graphics windows to print");
+			return_code = 0;
+		}
+		else if (open_flag && close_flag)
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx print video_stream:  Specify only one of open or close");
+			return_code = 0;
+		}
+		else if (open_flag)
+		{
+			const enum Video_stream_format format =
+				(0 == strcmp(format_string, format_strings[1])) ? VIDEO_STREAM_FORMAT_RAW_RGB :
+				VIDEO_STREAM_FORMAT_Y4M;
+			return_code = Graphics_window_open_video_stream(window, file_name,
+				command, format, width, height, frame_rate, queue_size);
+		}
+		else if (close_flag)
+		{
+			return_code = Graphics_window_close_video_stream(window);
+		}
+		else if (!Graphics_window_has_video_stream(window))
+		{
+			display_message(ERROR_MESSAGE, "gfx print video_stream:  "
+				"No video stream open. Use 'gfx print video_stream open'");
+			return_code = 0;
+		}
+		else
+		{
+			return_code = Graphics_window_write_video_frame(window,
+				antialias, transparency_layers);
+		}
+	}
+	if (window)
+	{
+		DEACCESS(Graphics_window)(&window);
+	}
+	if (file_name)
+	{
+		DEALLOCATE(file_name);
+	}
+	if (command)
+	{
+		DEALLOCATE(command);
+	}
+	return return_code;
+}
+
+static int execute_command_gfx_print_image(struct Parse_state *state,
 	void *dummy_to_be_modified,void *command_data_void)
 /*******************************************************************************
 LAST MODIFIED : 23 April 2002
 
 DESCRIPTION :
-Executes a GFX PRINT command.
+Executes a GFX PRINT command writing a single image of a graphics window.
 ==============================================================================*/
 {
 	char *file_name, force_onscreen_flag;
@@ -11590,7 +13103,7 @@ Executes a GFX PRINT command.
 	struct Graphics_window *window;
 	struct Option_table *option_table;
 
-	ENTER(execute_command_gfx_print);
+	ENTER(execute_command_gfx_print_image);
 	USE_PARAMETER(dummy_to_be_modified);
 	if (state && (command_data=(struct cmzn_command_data *)command_data_void))
 	{
@@ -11613,6 +13126,8 @@ Executes a GFX PRINT command.
 		}
 
 		option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Writes an image of a graphics window to file.");
 		/* antialias */
 		Option_table_add_entry(option_table, "antialias",
 			&antialias, NULL, set_int_positive);
@@ -11706,7 +13221,7 @@ Executes a GFX PRINT command.
 			else
 			{
 				display_message(ERROR_MESSAGE,
-					"execute_command_gfx_print.  Could not get image from window");
+					"execute_command_gfx_print_image.  Could not get image from window");
 				return_code = 0;
 			}
 			DESTROY(Cmgui_image_information)(&cmgui_image_information);
@@ -11721,6 +13236,54 @@ Executes a GFX PRINT command.
 		}
 	}
 	else
+	{
+		display_message(ERROR_MESSAGE,
+			"execute_command_gfx_print_image.  Invalid argument(s)");
+		return_code = 0;
+	}
+	LEAVE;
+
+	return (return_code);
+} /* execute_command_gfx_print_image */
+
+/**
+ * Executes a GFX PRINT command. Dispatches the camera_path and video_stream
+ * sub-commands, otherwise writes a single image of a graphics window.
+ */
+static int execute_command_gfx_print(struct Parse_state *state,
+	void *dummy_to_be_modified, void *command_data_void)
+{
+	int return_code;
+
+	ENTER(execute_command_gfx_print);
+	USE_PARAMETER(dummy_to_be_modified);
+	if (state && command_data_void)
+	{
+		if (state->current_token)
+		{
+			struct Option_table *option_table = CREATE(Option_table)();
+			Option_table_add_help(option_table,
+				"Writes an image of a graphics window to file. Use "
+				"'gfx print camera_path' to write a turntable or keyframed sequence "
+				"of frames in one command. 'gfx print video_stream open|close' "
+				"manages a raw video stream for the window, and 'gfx print "
+				"video_stream' then appends one frame to it.");
+			Option_table_add_entry(option_table, "camera_path", NULL,
+				command_data_void, execute_command_gfx_print_camera_path);
+			Option_table_add_entry(option_table, "video_stream", NULL,
+				command_data_void, execute_command_gfx_print_video_stream);
+			Option_table_add_entry(option_table, (const char *)NULL, NULL,
+				command_data_void, execute_command_gfx_print_image);
+			return_code = Option_table_parse(option_table, state);
+			DESTROY(Option_table)(&option_table);
+		}
+		else
+		{
+			return_code = execute_command_gfx_print_image(state, NULL,
+				command_data_void);
+		}
+	}
+	else
 	{
 		display_message(ERROR_MESSAGE,
 			"execute_command_gfx_print.  Invalid argument(s)");
@@ -11803,15 +13366,20 @@ int offset_region_identifier(cmzn_region_id region, char element_flag, int eleme
 			{
 				return_code = 0;
 			}
+			cmzn_nodeset_destroy(&nodeset);
 		}
 		struct cmzn_region *child_region = cmzn_region_get_first_child(region);
 		while ((NULL != child_region))
 		{
-			return_code = offset_region_identifier(child_region, element_flag, element_offset, face_flag,
-				face_offset, line_flag, line_offset, node_flag, node_offset, use_data);
+			if (!offset_region_identifier(child_region, element_flag, element_offset, face_flag,
+				face_offset, line_flag, line_offset, node_flag, node_offset, use_data))
+			{
+				return_code = 0;
+			}
 			cmzn_region_reaccess_next_sibling(&child_region);
 		}
 		cmzn_fieldmodule_end_change(fieldmodule);
+		cmzn_fieldmodule_destroy(&fieldmodule);
 	}
 	else
 	{
@@ -13410,62 +14978,111 @@ static int execute_command_gfx_smooth(struct Parse_state *state,
 	cmzn_command_data *command_data = reinterpret_cast<cmzn_command_data *>(command_data_void);
 	if (state && command_data)
 	{
-		char *fieldName = 0;
+		Multiple_strings fieldNames;
 		cmzn_region *region = cmzn_region_access(command_data->root_region);
 		FE_value time = 0.0;
 		if (command_data->default_time_keeper_app)
 			time = command_data->default_time_keeper_app->getTimeKeeper()->getTime();
+		double endTime = 0.0;
+		char endTimeFlag = 0;
+		int numberOfTimeSteps = 0;
 
 		Option_table *option_table = CREATE(Option_table)();
-		Option_table_add_string_entry(option_table, "field", &fieldName, " FINITE ELEMENT FIELD NAME");
+		Option_table_add_help(option_table,
+			"Smooths the listed finite element fields in the region. Fields are "
+			"smoothed in the order given, so the result is the same as smoothing "
+			"each with a separate command, but all are checked before any is "
+			"changed and graphics are updated once at the end. If number_of_time_steps "
+			"is greater than 0, each field is smoothed at number_of_time_steps + 1 "
+			"equally spaced times from time to end_time, which must then be given.");
+		Option_table_add_entry(option_table, "end_time", &endTime, &endTimeFlag,
+			set_double_and_char_flag);
+		Option_table_add_multiple_strings_entry(option_table, "field", &fieldNames,
+			"FINITE_ELEMENT_FIELD_NAME [& FINITE_ELEMENT_FIELD_NAME [& ...]]");
+		Option_table_add_entry(option_table, "number_of_time_steps", &numberOfTimeSteps,
+			NULL, set_int_non_negative);
 		Option_table_add_set_cmzn_region(option_table, "region", command_data->root_region, &region);
 		Option_table_add_entry(option_table, "time", &time, NULL, set_FE_value);
 		return_code = Option_table_multi_parse(option_table, state);
 		if (return_code)
 		{
-			if (0 == fieldName)
+			if (0 == fieldNames.number_of_strings)
 			{
 				display_message(ERROR_MESSAGE, "gfx smooth:  Must specify field to smooth");
 				display_parse_state_location(state);
 				return_code = 0;
 			}
+			else if ((0 < numberOfTimeSteps) && (!endTimeFlag))
+			{
+				display_message(ERROR_MESSAGE,
+					"gfx smooth:  Must specify end_time with number_of_time_steps");
+				display_parse_state_location(state);
+				return_code = 0;
+			}
 			else
 			{
 				cmzn_fieldmodule_id fieldModule = cmzn_region_get_fieldmodule(region);
-				cmzn_field_id field = cmzn_fieldmodule_find_field_by_name(fieldModule, fieldName);
-				if (!field)
+				std::vector<cmzn_field_id> fields;
+				for (int i = 0; i < fieldNames.number_of_strings; ++i)
 				{
-					display_message(ERROR_MESSAGE, "gfx smooth:  Could not find field '%s' in region", fieldName);
-					display_parse_state_location(state);
-					return_code = 0;
-				}
-				else
-				{
-					cmzn_field_finite_element_id finite_element_field = cmzn_field_cast_finite_element(field);
-					if (!finite_element_field)
+					cmzn_field_id field = cmzn_fieldmodule_find_field_by_name(fieldModule, fieldNames.strings[i]);
+					if (!field)
 					{
-						display_message(ERROR_MESSAGE, "gfx smooth:  Field '%s' is not finite element type", fieldName);
-						display_parse_state_location(state);
+						display_message(ERROR_MESSAGE, "gfx smooth:  Could not find field '%s' in region",
+							fieldNames.strings[i]);
 						return_code = 0;
+						continue;
+					}
+					cmzn_field_finite_element_id finite_element_field = cmzn_field_cast_finite_element(field);
+					if (finite_element_field)
+					{
+						fields.push_back(field);
 					}
 					else
 					{
-						cmzn_fieldsmoothing_id fieldsmoothing = cmzn_fieldmodule_create_fieldsmoothing(fieldModule);
-						cmzn_fieldsmoothing_set_time(fieldsmoothing, time);
-						int result = cmzn_field_smooth(field, fieldsmoothing);
-						if (result != CMZN_OK)
-							return_code = 0;
-						cmzn_fieldsmoothing_destroy(&fieldsmoothing);
+						display_message(ERROR_MESSAGE, "gfx smooth:  Field '%s' is not finite element type",
+							fieldNames.strings[i]);
+						return_code = 0;
+						cmzn_field_destroy(&field);
 					}
 					cmzn_field_finite_element_destroy(&finite_element_field);
 				}
-				cmzn_field_destroy(&field);
+				if (return_code)
+				{
+					// one smoothing object serves all fields and times, smoothing each
+					// in turn; changes are cached so dependent graphics and fields
+					// update once
+					cmzn_fieldmodule_begin_change(fieldModule);
+					cmzn_fieldsmoothing_id fieldsmoothing = cmzn_fieldmodule_create_fieldsmoothing(fieldModule);
+					for (int t = 0; (t <= numberOfTimeSteps) && return_code; ++t)
+					{
+						const double smoothTime = (numberOfTimeSteps > 0) ?
+							(time + t*(endTime - time)/numberOfTimeSteps) : time;
+						cmzn_fieldsmoothing_set_time(fieldsmoothing, smoothTime);
+						for (size_t f = 0; f < fields.size(); ++f)
+						{
+							if (CMZN_OK != cmzn_field_smooth(fields[f], fieldsmoothing))
+							{
+								display_message(ERROR_MESSAGE, "gfx smooth:  Failed to smooth field '%s' at time %g",
+									fieldNames.strings[f], smoothTime);
+								return_code = 0;
+								break;
+							}
+						}
+					}
+					cmzn_fieldsmoothing_destroy(&fieldsmoothing);
+					cmzn_fieldmodule_end_change(fieldModule);
+				}
+				else
+				{
+					display_parse_state_location(state);
+				}
+				for (size_t f = 0; f < fields.size(); ++f)
+					cmzn_field_destroy(&fields[f]);
 				cmzn_fieldmodule_destroy(&fieldModule);
 			}
 		}
 		DESTROY(Option_table)(&option_table);
-		if (fieldName)
-			DEALLOCATE(fieldName);
 		cmzn_region_destroy(&region);
 	}
 	else
@@ -14943,10 +16560,14 @@ Executes a GFX command.
 				command_data_void, gfx_evaluate);
 			Option_table_add_entry(option_table, "export", NULL,
 				command_data_void, execute_command_gfx_export);
+			Option_table_add_entry(option_table, "find_mesh_locations", NULL,
+				(void *)command_data->mesh_location_index_cache, gfx_find_mesh_locations);
 #if defined (USE_OPENCASCADE)
 			Option_table_add_entry(option_table, "import", NULL,
 				command_data_void, execute_command_gfx_import);
 #endif /* defined (USE_OPENCASCADE) */
+			Option_table_add_entry(option_table, "integrate",
+				(void *)command_data->root_region, NULL, gfx_integrate);
 			Option_table_add_entry(option_table, "list", NULL,
 				command_data_void, execute_command_gfx_list);
 			Option_table_add_entry(option_table, "minimise",
@@ -16392,6 +18013,11 @@ Initialise all the subcomponents of cmgui and create the cmzn_command_data
 		command_data->execute_command = CREATE(Execute_command)();;
 		command_data->set_command = CREATE(Execute_command)();
 		command_data->event_dispatcher = (struct Event_dispatcher *)NULL;
+#if defined (ZINC_USE_NETGEN)
+		command_data->generate_netgen_job = (Generate_netgen_job *)NULL;
+		command_data->generate_netgen_timeout_callback =
+			(struct Event_dispatcher_timeout_callback *)NULL;
+#endif /* defined (ZINC_USE_NETGEN) */
 		command_data->user_interface= (struct User_interface *)NULL;
 		command_data->logger = 0;
 		command_data->loggerNotifier = 0;
@@ -16424,6 +18050,10 @@ Initialise all the subcomponents of cmgui and create the cmzn_command_data
 		command_data->graphics_window_manager=(struct MANAGER(Graphics_window) *)NULL;
 #endif /* defined (USE_CMGUI_GRAPHICS_WINDOW) */
 		command_data->root_region = (struct cmzn_region *)NULL;
+		command_data->mesh_location_index_cache = (struct Mesh_location_index_cache *)NULL;
+#if defined (ZINC_USE_ITK)
+		command_data->image_filter_package = (Image_filter_package *)NULL;
+#endif /* defined (ZINC_USE_ITK) */
 		command_data->basis_manager=(struct MANAGER(FE_basis) *)NULL;
 		command_data->streampoint_list=(struct Streampoint *)NULL;
 #if defined (SELECT_DESCRIPTORS)
@@ -16759,6 +18389,8 @@ Initialise all the subcomponents of cmgui and create the cmzn_command_data
 		command_data->basis_manager=CREATE(MANAGER(FE_basis))();
 
 		command_data->root_region = cmzn_context_get_default_region(cmzn_context_app_get_core_context(context));
+		command_data->mesh_location_index_cache =
+			Mesh_location_index_cache_create(command_data->root_region);
 
 #if defined (SELECT_DESCRIPTORS)
 		/* create device list */
@@ -16843,36 +18475,38 @@ Initialise all the subcomponents of cmgui and create the cmzn_command_data
 			Computed_field_register_types_image_resample(
 				command_data->computed_field_package);
 #if defined (ZINC_USE_ITK)
+			command_data->image_filter_package = new Image_filter_package();
+			command_data->image_filter_package->addref();
 			Computed_field_register_types_threshold_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_binary_threshold_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_canny_edge_detection_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_mean_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_sigmoid_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_discrete_gaussian_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_histogram_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_curvature_anisotropic_diffusion_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_derivative_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_rescale_intensity_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_connected_threshold_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_gradient_magnitude_recursive_gaussian_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_fast_marching_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_binary_dilate_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 			Computed_field_register_types_binary_erode_image_filter(
-				command_data->computed_field_package);
+				command_data->computed_field_package, command_data->image_filter_package);
 #endif /* defined (ZINC_USE_ITK) */
 		}
 		/* graphics_module */
@@ -17148,10 +18782,20 @@ NOTE: Do not call this directly: call cmzn_command_data_destroy() to deaccess.
 			Computed_field_package_remove_types(command_data->computed_field_package);
 			DESTROY(Computed_field_package)(&command_data->computed_field_package);
 		}
+#if defined (ZINC_USE_ITK)
+		/* cached filter outputs hold fields so must go before the regions */
+		if (command_data->image_filter_package)
+		{
+			command_data->image_filter_package->removeref();
+			command_data->image_filter_package = (Image_filter_package *)NULL;
+		}
+#endif /* defined (ZINC_USE_ITK) */
 #if defined (SELECT_DESCRIPTORS)
 		DESTROY(LIST(Io_device))(&command_data->device_list);
 #endif /* defined (SELECT_DESCRIPTORS) */
 
+		/* indexes hold fields and elements so must go before the regions */
+		Mesh_location_index_cache_destroy(&command_data->mesh_location_index_cache);
 		cmzn_region_destroy(&(command_data->root_region));
 		DESTROY(MANAGER(FE_basis))(&command_data->basis_manager);
 		DESTROY(LIST(FE_element_shape))(&command_data->element_shape_list);
@@ -17201,6 +18845,27 @@ NOTE: Do not call this directly: call cmzn_command_data_destroy() to deaccess.
 		}
 #endif /* defined (WIN32_USER_INTERFACE) || defined (GTK_USER_INTERFACE) */
 
+#if defined (ZINC_USE_NETGEN)
+		if (command_data->generate_netgen_timeout_callback)
+		{
+			Event_dispatcher_remove_timeout_callback(command_data->event_dispatcher,
+				command_data->generate_netgen_timeout_callback);
+			command_data->generate_netgen_timeout_callback = NULL;
+		}
+		if (command_data->generate_netgen_job)
+		{
+			/* cannot interrupt the mesher: discard its result and wait for it, as
+			 * netgen global state must not be torn down under a running mesher */
+			command_data->generate_netgen_job->cancel();
+			if (!command_data->generate_netgen_job->isFinished())
+			{
+				display_message(INFORMATION_MESSAGE,
+					"Waiting for tetrahedral meshing to finish\n");
+			}
+			delete command_data->generate_netgen_job;
+			command_data->generate_netgen_job = NULL;
+		}
+#endif /* defined (ZINC_USE_NETGEN) */
 		if (command_data->user_interface)
 			command_data->user_interface = NULL;
 		if (command_data->event_dispatcher)
@@ -954,3 +954,41 @@ void cmzn_field_set_name_unique(cmzn_field *field, const char *stemName)
 	delete[] name;
 	cmzn_fieldmodule_destroy(&fieldmodule);
 }
+
+bool cmzn_field_is_node_local(cmzn_field *field)
+{
+	static const char *node_local_type_strings[] =
+	{
+		"finite_element", "node_value", "cmiss_number", "constant", "composite",
+		"component", "identity", "time_value", "group", "node_group",
+		"add", "scale", "offset", "multiply_components", "divide_components",
+		"power", "sqrt", "exp", "log", "abs", "clamp_maximum", "clamp_minimum",
+		"sum_components", "magnitude", "normalise", "dot_product", "cross_product",
+		"sin", "cos", "tan", "asin", "acos", "atan", "atan2",
+		"if", "not", "and", "or", "xor", "equal_to", "greater_than", "less_than",
+		"is_defined", "coordinate_transformation", "vector_coordinate_transformation",
+		"determinant", "eigenvalues", "eigenvectors", "matrix_invert",
+		"matrix_multiply", "transpose", "projection", "quaternion_to_matrix",
+		"matrix_to_quaternion"
+	};
+	const char *type_string = Computed_field_get_type_string(field);
+	if (!type_string)
+		return false;
+	bool node_local = false;
+	for (size_t i = 0; i < sizeof(node_local_type_strings)/sizeof(const char *); ++i)
+	{
+		if (0 == strcmp(type_string, node_local_type_strings[i]))
+		{
+			node_local = true;
+			break;
+		}
+	}
+	const int number_of_source_fields = cmzn_field_get_number_of_source_fields(field);
+	for (int i = 1; node_local && (i <= number_of_source_fields); ++i)
+	{
+		cmzn_field_id source_field = cmzn_field_get_source_field(field, i);
+		node_local = cmzn_field_is_node_local(source_field);
+		cmzn_field_destroy(&source_field);
+	}
+	return node_local;
+}
@@ -239,4 +239,13 @@ Computed_field_simple_package *Computed_field_package_get_simple_package(
 /** Set name of field to the stem name supplied or append with _# to make unique. */
 void cmzn_field_set_name_unique(cmzn_field *field, const char *stemName);
 
+/**
+ * @return  True if <field> and all fields it depends on are of types whose
+ * value at a node only reads that node's parameters, or group membership, so
+ * it can be evaluated at different nodes on different threads. False if any
+ * field evaluates in elements, at other nodes or other regions, uses images
+ * or filters, or is of a type not known here.
+ */
+bool cmzn_field_is_node_local(cmzn_field *field);
+
 #endif
@@ -0,0 +1,340 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/status.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "computed_field/computed_field.h"
+#include "computed_field/computed_field_graph_app.h"
+
+namespace {
+
+/** A field in the source graph of a listed field. */
+struct Field_graph_node
+{
+	cmzn_field_id field; // accessed
+	std::vector<int> source_indexes; // distinct sources in order
+	double number_of_paths; // from the root field; may be large
+	double total_seconds, self_seconds;
+	int number_defined;
+	bool timed;
+};
+
+/**
+ * Source graph of a field, with each field stored once and sources stored
+ * before the fields using them.
+ */
+class Field_graph
+{
+	std::vector<Field_graph_node> nodes;
+	std::map<cmzn_field_id, int> node_indexes;
+
+	Field_graph(const Field_graph&);
+	Field_graph& operator=(const Field_graph&);
+
+	int add_field(cmzn_field_id field);
+
+	void list_node(int node_index, int depth, std::vector<char>& listed) const;
+
+public:
+
+	explicit Field_graph(cmzn_field_id root_field);
+
+	~Field_graph()
+	{
+		for (size_t i = 0; i < this->nodes.size(); ++i)
+			cmzn_field_destroy(&this->nodes[i].field);
+	}
+
+	int get_root_index() const
+	{
+		return static_cast<int>(this->nodes.size()) - 1;
+	}
+
+	void list() const;
+
+	/** Times each field at the locations set by <set_location>. */
+	template <typename Set_location> void profile(cmzn_fieldmodule_id field_module,
+		int number_of_locations, Set_location set_location);
+
+	void list_profile(const char *location_description, int number_of_locations) const;
+};
+
+Field_graph::Field_graph(cmzn_field_id root_field)
+{
+	this->add_field(root_field);
+	/* count paths from the root, visiting users before their sources */
+	const int root_index = this->get_root_index();
+	this->nodes[root_index].number_of_paths = 1.0;
+	for (int i = root_index; i >= 0; --i)
+	{
+		const Field_graph_node& node = this->nodes[i];
+		const int number_of_sources = cmzn_field_get_number_of_source_fields(node.field);
+		for (int s = 1; s <= number_of_sources; ++s)
+		{
+			/* repeated sources are separate paths */
+			cmzn_field_id source_field = cmzn_field_get_source_field(node.field, s);
+			this->nodes[this->node_indexes[source_field]].number_of_paths += node.number_of_paths;
+			cmzn_field_destroy(&source_field);
+		}
+	}
+}
+
+int Field_graph::add_field(cmzn_field_id field)
+{
+	std::map<cmzn_field_id, int>::iterator iter = this->node_indexes.find(field);
+	if (iter != this->node_indexes.end())
+		return iter->second;
+	std::vector<int> source_indexes;
+	const int number_of_sources = cmzn_field_get_number_of_source_fields(field);
+	for (int s = 1; s <= number_of_sources; ++s)
+	{
+		cmzn_field_id source_field = cmzn_field_get_source_field(field, s);
+		const int source_index = this->add_field(source_field);
+		if (std::find(source_indexes.begin(), source_indexes.end(), source_index) == source_indexes.end())
+			source_indexes.push_back(source_index);
+		cmzn_field_destroy(&source_field);
+	}
+	Field_graph_node node;
+	node.field = cmzn_field_access(field);
+	node.source_indexes = source_indexes;
+	node.number_of_paths = 0.0;
+	node.total_seconds = 0.0;
+	node.self_seconds = 0.0;
+	node.number_defined = 0;
+	node.timed = false;
+	const int index = static_cast<int>(this->nodes.size());
+	this->nodes.push_back(node);
+	this->node_indexes[node.field] = index;
+	return index;
+}
+
+void Field_graph::list_node(int node_index, int depth, std::vector<char>& listed) const
+{
+	const Field_graph_node& node = this->nodes[node_index];
+	char *name = cmzn_field_get_name(node.field);
+	display_message(INFORMATION_MESSAGE, "%*s%s", 2*depth, "", name);
+	cmzn_deallocate(name);
+	if (listed[node_index] && (!node.source_indexes.empty()))
+	{
+		display_message(INFORMATION_MESSAGE, " (see above)\n");
+		return;
+	}
+	display_message(INFORMATION_MESSAGE, " : %s, %d component(s)",
+		Computed_field_get_type_string(node.field), cmzn_field_get_number_of_components(node.field));
+	if (node.number_of_paths > 1.0)
+		display_message(INFORMATION_MESSAGE, " [shared, %g paths]", node.number_of_paths);
+	display_message(INFORMATION_MESSAGE, "\n");
+	listed[node_index] = 1;
+	for (size_t s = 0; s < node.source_indexes.size(); ++s)
+		this->list_node(node.source_indexes[s], depth + 1, listed);
+}
+
+void Field_graph::list() const
+{
+	std::vector<char> listed(this->nodes.size(), 0);
+	int number_shared = 0;
+	for (size_t i = 0; i < this->nodes.size(); ++i)
+	{
+		if (this->nodes[i].number_of_paths > 1.0)
+			++number_shared;
+	}
+	display_message(INFORMATION_MESSAGE,
+		"Source graph with %d fields, %d shared by several paths:\n",
+		static_cast<int>(this->nodes.size()), number_shared);
+	this->list_node(this->get_root_index(), 1, listed);
+}
+
+template <typename Set_location> void Field_graph::profile(cmzn_fieldmodule_id field_module,
+	int number_of_locations, Set_location set_location)
+{
+	std::vector<double> values;
+	/* time to set the locations alone, subtracted from totals */
+	double baseline_seconds = 0.0;
+	{
+		cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int l = 0; l < number_of_locations; ++l)
+			set_location(field_cache, l);
+		baseline_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cmzn_fieldcache_destroy(&field_cache);
+	}
+	for (size_t i = 0; i < this->nodes.size(); ++i)
+	{
+		Field_graph_node& node = this->nodes[i];
+		if (cmzn_field_get_value_type(node.field) != CMZN_FIELD_VALUE_TYPE_REAL)
+			continue;
+		node.timed = true;
+		const int number_of_components = cmzn_field_get_number_of_components(node.field);
+		if (static_cast<int>(values.size()) < number_of_components)
+			values.resize(number_of_components);
+		/* a new cache for each field so no values are left from earlier fields;
+		 * changing location clears cached values of the previous location */
+		cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+		node.number_defined = 0;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int l = 0; l < number_of_locations; ++l)
+		{
+			set_location(field_cache, l);
+			if (CMZN_OK == cmzn_field_evaluate_real(node.field, field_cache, number_of_components, values.data()))
+				++node.number_defined;
+		}
+		node.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cmzn_fieldcache_destroy(&field_cache);
+		/* time for all direct sources together, sharing their common sources */
+		field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+		start = std::chrono::steady_clock::now();
+		for (int l = 0; l < number_of_locations; ++l)
+		{
+			set_location(field_cache, l);
+			for (size_t s = 0; s < node.source_indexes.size(); ++s)
+			{
+				cmzn_field_id source_field = this->nodes[node.source_indexes[s]].field;
+				if (cmzn_field_get_value_type(source_field) != CMZN_FIELD_VALUE_TYPE_REAL)
+					continue;
+				const int source_components = cmzn_field_get_number_of_components(source_field);
+				if (static_cast<int>(values.size()) < source_components)
+					values.resize(source_components);
+				cmzn_field_evaluate_real(source_field, field_cache, source_components, values.data());
+			}
+		}
+		const double sources_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cmzn_fieldcache_destroy(&field_cache);
+		node.self_seconds = std::max(0.0, node.total_seconds - sources_seconds);
+		node.total_seconds = std::max(0.0, node.total_seconds - baseline_seconds);
+	}
+}
+
+void Field_graph::list_profile(const char *location_description, int number_of_locations) const
+{
+	std::vector<int> order;
+	for (size_t i = 0; i < this->nodes.size(); ++i)
+	{
+		if (this->nodes[i].timed)
+			order.push_back(static_cast<int>(i));
+	}
+	/* most expensive first */
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+		{
+			return this->nodes[a].self_seconds > this->nodes[b].self_seconds;
+		});
+	display_message(INFORMATION_MESSAGE,
+		"Evaluation profile at %d %s, microseconds per location:\n"
+		"  total is the time to evaluate the field from scratch, self excludes\n"
+		"  its sources, paths is how often it would be evaluated per location\n"
+		"  if values were not cached.\n"
+		"%12s %12s %8s %9s  %s\n", number_of_locations, location_description,
+		"total", "self", "paths", "defined", "field");
+	const double scale = (number_of_locations > 0) ? (1.0E6/number_of_locations) : 0.0;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const Field_graph_node& node = this->nodes[order[i]];
+		char *name = cmzn_field_get_name(node.field);
+		display_message(INFORMATION_MESSAGE, "%12.3f %12.3f %8g %9d  %s%s\n",
+			node.total_seconds*scale, node.self_seconds*scale, node.number_of_paths,
+			node.number_defined, name, (node.number_of_paths > 1.0) ? " *" : "");
+		cmzn_deallocate(name);
+	}
+}
+
+/**
+ * Sets <xi> to the centroid of an element of <shape_type>: 1/3 in the two
+ * simplex directions of triangles and wedges, 1/4 in all three for tetrahedra,
+ * otherwise 0.5.
+ */
+void Field_graph_get_element_centre_xi(enum cmzn_element_shape_type shape_type,
+	double *xi)
+{
+	xi[0] = xi[1] = xi[2] = 0.5;
+	switch (shape_type)
+	{
+		case CMZN_ELEMENT_SHAPE_TYPE_TRIANGLE:
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE12:
+			xi[0] = xi[1] = 1.0/3.0;
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE13:
+			xi[0] = xi[2] = 1.0/3.0;
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE23:
+			xi[1] = xi[2] = 1.0/3.0;
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_TETRAHEDRON:
+			xi[0] = xi[1] = xi[2] = 0.25;
+			break;
+		default:
+			break;
+	}
+}
+
+} // anonymous namespace
+
+int Computed_field_list_graph(cmzn_field_id field, int profile_flag,
+	cmzn_nodeset_id nodeset, cmzn_mesh_id mesh, int sample_size)
+{
+	if (!(field && ((!profile_flag) || ((nodeset || mesh) && (sample_size > 0)))))
+	{
+		display_message(ERROR_MESSAGE, "Computed_field_list_graph.  Invalid argument(s)");
+		return 0;
+	}
+	Field_graph graph(field);
+	graph.list();
+	if (!profile_flag)
+		return 1;
+	cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(field);
+	if (mesh)
+	{
+		std::vector<cmzn_element_id> elements;
+		cmzn_elementiterator_id iterator = cmzn_mesh_create_elementiterator(mesh);
+		cmzn_element_id element = 0;
+		while ((static_cast<int>(elements.size()) < sample_size) &&
+			(0 != (element = cmzn_elementiterator_next(iterator))))
+			elements.push_back(element);
+		cmzn_elementiterator_destroy(&iterator);
+		const int dimension = cmzn_mesh_get_dimension(mesh);
+		std::vector<double> centre_xi(3*elements.size());
+		for (size_t e = 0; e < elements.size(); ++e)
+			Field_graph_get_element_centre_xi(cmzn_element_get_shape_type(elements[e]), &centre_xi[3*e]);
+		graph.profile(field_module, static_cast<int>(elements.size()),
+			[&](cmzn_fieldcache_id field_cache, int l)
+			{
+				cmzn_fieldcache_set_mesh_location(field_cache, elements[l], dimension, &centre_xi[3*l]);
+			});
+		graph.list_profile("element centres", static_cast<int>(elements.size()));
+		for (size_t e = 0; e < elements.size(); ++e)
+			cmzn_element_destroy(&elements[e]);
+	}
+	else
+	{
+		std::vector<cmzn_node_id> nodes;
+		cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(nodeset);
+		cmzn_node_id node = 0;
+		while ((static_cast<int>(nodes.size()) < sample_size) &&
+			(0 != (node = cmzn_nodeiterator_next(iterator))))
+			nodes.push_back(node);
+		cmzn_nodeiterator_destroy(&iterator);
+		graph.profile(field_module, static_cast<int>(nodes.size()),
+			[&](cmzn_fieldcache_id field_cache, int l)
+			{
+				cmzn_fieldcache_set_node(field_cache, nodes[l]);
+			});
+		graph.list_profile("nodes", static_cast<int>(nodes.size()));
+		for (size_t n = 0; n < nodes.size(); ++n)
+			cmzn_node_destroy(&nodes[n]);
+	}
+	cmzn_fieldmodule_destroy(&field_module);
+	return 1;
+}
@@ -0,0 +1,27 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (COMPUTED_FIELD_GRAPH_APP_H)
+#define COMPUTED_FIELD_GRAPH_APP_H
+
+#include "opencmiss/zinc/types/fieldid.h"
+#include "opencmiss/zinc/types/meshid.h"
+#include "opencmiss/zinc/types/nodesetid.h"
+
+/**
+ * Lists the graph of source fields of <field> with their types, listing each
+ * field's sources once only and marking fields reached by more than one path
+ * as shared. If <profile_flag> is set, each field in the graph is also timed
+ * at up to <sample_size> locations: the nodes of <nodeset>, or the centres of
+ * elements of <mesh> if given instead. For each field the total time to
+ * evaluate it from scratch is listed with the part of that not spent
+ * evaluating its sources.
+ * @return  1 on success, 0 on failure.
+ */
+int Computed_field_list_graph(cmzn_field_id field, int profile_flag,
+	cmzn_nodeset_id nodeset, cmzn_mesh_id mesh, int sample_size);
+
+#endif /* !defined (COMPUTED_FIELD_GRAPH_APP_H) */
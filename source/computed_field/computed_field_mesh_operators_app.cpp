@@ -4,8 +4,18 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/fieldcache.h"
 #include "opencmiss/zinc/fieldmeshoperators.h"
+#include "opencmiss/zinc/fieldmodule.h"
 #include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/region.h"
+#include "opencmiss/zinc/status.h"
 #include "general/debug.h"
 #include "general/message.h"
 #include "command/parser.h"
@@ -20,6 +30,7 @@
 #include "finite_element/finite_element.h"
 #include "graphics/tessellation_app.hpp"
 #include "mesh/cmiss_element_private.hpp"
+#include "region/cmiss_region_app.h"
 
 /**
  * Command modifier function for getting the arguments common to several
@@ -251,3 +262,110 @@ int Computed_field_register_types_mesh_operators(
 
 	return (return_code);
 }
+
+namespace {
+
+/** Evaluates <field> with a new field cache at <time> into <values>. */
+bool Mesh_integral_evaluate(cmzn_fieldmodule_id field_module,
+	cmzn_field_id field, double time, int number_of_components, double *values)
+{
+	cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+	cmzn_fieldcache_set_time(field_cache, time);
+	const bool result = (CMZN_OK == cmzn_field_evaluate_real(field, field_cache,
+		number_of_components, values));
+	cmzn_fieldcache_destroy(&field_cache);
+	return result;
+}
+
+/** @return  Seconds elapsed since <start>. */
+double Mesh_integral_get_elapsed_seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+int gfx_integrate(struct Parse_state *state, void *root_region_void, void *)
+{
+	cmzn_region_id root_region = static_cast<cmzn_region_id>(root_region_void);
+	if (!(state && root_region))
+	{
+		display_message(ERROR_MESSAGE, "gfx_integrate.  Invalid argument(s)");
+		return 0;
+	}
+	char *field_name = 0;
+	cmzn_region_id region = cmzn_region_access(root_region);
+	int repeat = 1;
+	double time = 0.0;
+	Option_table *option_table = CREATE(Option_table)();
+	Option_table_add_help(option_table,
+		"Evaluates a mesh_integral or mesh_integral_squares field and lists its value "
+		"with the number of elements in its mesh and the time per evaluation. repeat "
+		"evaluates several times for timing. Evaluation is serial: element field "
+		"evaluation shares element and basis state between field caches, so mesh "
+		"integrals cannot be split over threads.");
+	Option_table_add_string_entry(option_table, "field", &field_name,
+		" FIELD_NAME");
+	Option_table_add_set_cmzn_region(option_table, "region", root_region, &region);
+	Option_table_add_int_positive_entry(option_table, "repeat", &repeat);
+	Option_table_add_double_entry(option_table, "time", &time);
+	int return_code = Option_table_multi_parse(option_table, state);
+	DESTROY(Option_table)(&option_table);
+	if (return_code)
+	{
+		cmzn_fieldmodule_id field_module = cmzn_region_get_fieldmodule(region);
+		cmzn_field_id field = (field_name) ?
+			cmzn_fieldmodule_find_field_by_name(field_module, field_name) : 0;
+		Computed_field_mesh_integral *mesh_integral_core = (field) ?
+			dynamic_cast<Computed_field_mesh_integral *>(field->core) : 0;
+		if (!mesh_integral_core)
+		{
+			if (field_name)
+				display_message(ERROR_MESSAGE, "gfx integrate:  "
+					"'%s' is not a mesh_integral or mesh_integral_squares field", field_name);
+			else
+				display_message(ERROR_MESSAGE, "gfx integrate:  Must specify field");
+			return_code = 0;
+		}
+		if (return_code)
+		{
+			/* the mesh the field integrates over, which may be a group */
+			cmzn_mesh_id mesh = mesh_integral_core->getMesh();
+			char *mesh_name = cmzn_mesh_get_name(mesh);
+			const int number_of_elements = cmzn_mesh_get_size(mesh);
+			const int number_of_components = cmzn_field_get_number_of_components(field);
+			std::vector<double> values(number_of_components, 0.0);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int r = 0; (r < repeat) && return_code; ++r)
+				return_code = Mesh_integral_evaluate(field_module, field, time,
+					number_of_components, values.data());
+			const double seconds = Mesh_integral_get_elapsed_seconds(start)/repeat;
+			if (return_code)
+			{
+				std::string values_string;
+				char number_string[50];
+				for (int c = 0; c < number_of_components; ++c)
+				{
+					sprintf(number_string, (c > 0) ? ", %.15g" : "%.15g", values[c]);
+					values_string += number_string;
+				}
+				display_message(INFORMATION_MESSAGE, "%s = %s\n", field_name, values_string.c_str());
+				display_message(INFORMATION_MESSAGE,
+					"gfx integrate:  %d elements of %s in %g s per evaluation\n",
+					number_of_elements, mesh_name, seconds);
+			}
+			else
+			{
+				display_message(ERROR_MESSAGE, "gfx integrate:  Could not evaluate %s; "
+					"integrand or coordinate field is not defined on all elements", field_name);
+			}
+			cmzn_deallocate(mesh_name);
+		}
+		cmzn_field_destroy(&field);
+		cmzn_fieldmodule_destroy(&field_module);
+	}
+	if (field_name)
+		DEALLOCATE(field_name);
+	cmzn_region_destroy(&region);
+	return return_code;
+}
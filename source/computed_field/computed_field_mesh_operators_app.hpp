@@ -9,4 +9,13 @@
 int Computed_field_register_types_mesh_operators(
 	struct Computed_field_package *computed_field_package);
 
+/**
+ * Executes a GFX INTEGRATE command: evaluates a mesh_integral or
+ * mesh_integral_squares field and lists its value with the number of elements
+ * in the field's mesh and the time taken per evaluation.
+ * @param root_region_void  Root region of the command.
+ */
+int gfx_integrate(struct Parse_state *state, void *root_region_void,
+	void *dummy_user_data);
+
 #endif
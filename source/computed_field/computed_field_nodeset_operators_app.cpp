@@ -4,11 +4,24 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "opencmiss/zinc/fieldcache.h"
 #include "opencmiss/zinc/fieldfiniteelement.h"
+#include "opencmiss/zinc/fieldmodule.h"
 #include "opencmiss/zinc/fieldnodesetoperators.h"
+#include "opencmiss/zinc/node.h"
 #include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/status.h"
 #include "general/debug.h"
 #include "general/message.h"
+#include "general/mystring.h"
 #include "command/parser.h"
 #include "computed_field/computed_field.h"
 #include "computed_field/computed_field_app.h"
@@ -17,6 +30,11 @@
 #include "computed_field/computed_field_set.h"
 #include "computed_field/computed_field_set_app.h"
 #include "computed_field/computed_field_nodeset_operators.hpp"
+#include "computed_field/computed_field_nodeset_operators_app.hpp"
+#include "computed_field/field_module.hpp"
+#include "datastore/labelschangelog.hpp"
+#include "finite_element/finite_element_nodeset.hpp"
+#include "finite_element/finite_element_region.h"
 #include "mesh/cmiss_node_private.hpp"
 
 const char computed_field_nodeset_mean_squares_type_string[] = "nodeset_mean_squares";
@@ -27,6 +45,596 @@ const char computed_field_nodeset_maximum_type_string[] = "nodeset_maximum";
 const char computed_field_nodeset_minimum_type_string[] = "nodeset_minimum";
 const char computed_field_nodeset_operator_type_string[] = "nodeset_operator";
 
+namespace {
+
+enum Nodeset_aggregate_type
+{
+	NODESET_AGGREGATE_SUM,
+	NODESET_AGGREGATE_MEAN,
+	NODESET_AGGREGATE_SUM_SQUARES,
+	NODESET_AGGREGATE_MEAN_SQUARES,
+	NODESET_AGGREGATE_MAXIMUM,
+	NODESET_AGGREGATE_MINIMUM
+};
+
+/**
+ * Running count, sums, sums of squares and extrema of each component over a
+ * set of values which are added and removed one at a time. Extrema cannot be
+ * maintained when the value holding one is removed, after which they are
+ * invalid until the aggregate is cleared and rebuilt.
+ */
+class Nodeset_running_aggregate
+{
+	int number_of_components;
+	int count;
+	std::vector<double> sums, sums_squares, maximums, minimums;
+	bool extrema_valid;
+
+public:
+
+	explicit Nodeset_running_aggregate(int number_of_componentsIn) :
+		number_of_components(number_of_componentsIn),
+		count(0),
+		sums(number_of_componentsIn),
+		sums_squares(number_of_componentsIn),
+		maximums(number_of_componentsIn),
+		minimums(number_of_componentsIn),
+		extrema_valid(true)
+	{
+		this->clear();
+	}
+
+	void clear()
+	{
+		this->count = 0;
+		for (int c = 0; c < this->number_of_components; ++c)
+		{
+			this->sums[c] = this->sums_squares[c] = 0.0;
+			this->maximums[c] = -std::numeric_limits<double>::max();
+			this->minimums[c] = std::numeric_limits<double>::max();
+		}
+		this->extrema_valid = true;
+	}
+
+	void add(const double *values)
+	{
+		++this->count;
+		for (int c = 0; c < this->number_of_components; ++c)
+		{
+			this->sums[c] += values[c];
+			this->sums_squares[c] += values[c]*values[c];
+			if (values[c] > this->maximums[c])
+				this->maximums[c] = values[c];
+			if (values[c] < this->minimums[c])
+				this->minimums[c] = values[c];
+		}
+	}
+
+	void remove(const double *values)
+	{
+		--this->count;
+		for (int c = 0; c < this->number_of_components; ++c)
+		{
+			this->sums[c] -= values[c];
+			this->sums_squares[c] -= values[c]*values[c];
+			if ((values[c] >= this->maximums[c]) || (values[c] <= this->minimums[c]))
+				this->extrema_valid = false;
+		}
+	}
+
+	/** @return  true if aggregate of <type> can be got from running values. */
+	bool is_valid(enum Nodeset_aggregate_type type) const
+	{
+		return this->extrema_valid ||
+			((NODESET_AGGREGATE_MAXIMUM != type) && (NODESET_AGGREGATE_MINIMUM != type));
+	}
+
+	/**
+	 * Gets aggregate of <type> for each component into <values>. Means and
+	 * extrema of no values are zero.
+	 */
+	void get_values(enum Nodeset_aggregate_type type, double *values) const
+	{
+		for (int c = 0; c < this->number_of_components; ++c)
+		{
+			switch (type)
+			{
+			case NODESET_AGGREGATE_SUM:
+				values[c] = this->sums[c];
+				break;
+			case NODESET_AGGREGATE_MEAN:
+				values[c] = (0 < this->count) ? this->sums[c]/this->count : 0.0;
+				break;
+			case NODESET_AGGREGATE_SUM_SQUARES:
+				values[c] = this->sums_squares[c];
+				break;
+			case NODESET_AGGREGATE_MEAN_SQUARES:
+				values[c] = (0 < this->count) ? this->sums_squares[c]/this->count : 0.0;
+				break;
+			case NODESET_AGGREGATE_MAXIMUM:
+				values[c] = (0 < this->count) ? this->maximums[c] : 0.0;
+				break;
+			case NODESET_AGGREGATE_MINIMUM:
+				values[c] = (0 < this->count) ? this->minimums[c] : 0.0;
+				break;
+			}
+		}
+	}
+};
+
+/**
+ * @return  true if <field> or any field it depends on has changed and the
+ * change has not yet been notified because the field manager is caching.
+ */
+bool Computed_field_has_pending_change(cmzn_field_id field)
+{
+	if (field->manager_change_status != MANAGER_CHANGE_NONE(Computed_field))
+		return true;
+	const int number_of_source_fields = cmzn_field_get_number_of_source_fields(field);
+	for (int i = 1; i <= number_of_source_fields; ++i)
+	{
+		cmzn_field_id source_field = cmzn_field_get_source_field(field, i);
+		const bool pending = Computed_field_has_pending_change(source_field);
+		cmzn_field_destroy(&source_field);
+		if (pending)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Running aggregate over a nodeset of a source field, updated from field module
+ * change events by re-evaluating the source field only at changed nodes and
+ * adjusting running totals. The last value of each node is kept so its old
+ * contribution can be removed. Recomputes over the whole nodeset when more
+ * than recompute_fraction of the nodes change, when the source field changes
+ * independently of nodes, on node removal or renumbering, on nodeset group
+ * membership change, or when an extremum is lost. Changes made while the field
+ * module is caching changes are only notified when caching ends, so until then
+ * the field is evaluated over the whole nodeset.
+ * Shared by the cores of an incremental nodeset operator field and its copies.
+ * Holds no field module, cache or region access so it does not keep the region
+ * of the field owning it alive.
+ */
+class Nodeset_incremental_aggregate
+{
+	cmzn_field_id source_field;
+	cmzn_nodeset_id nodeset;
+	cmzn_nodeset_id master_nodeset;
+	cmzn_field_id nodeset_group_field; /* node group field if nodeset is a group */
+	cmzn_fieldmodulenotifier_id notifier;
+	enum Nodeset_aggregate_type type;
+	double recompute_fraction;
+	int number_of_components;
+	Nodeset_running_aggregate running;
+	/* slot in node_values of each node by identifier, and whether the source
+	 * field was defined there */
+	std::unordered_map<int, int> node_slots;
+	std::vector<double> node_values;
+	std::vector<char> node_defined;
+	/* values at time 0 of aggregate, valid if synchronised */
+	std::vector<double> values;
+	bool synchronised;
+
+	static void field_module_callback(cmzn_fieldmoduleevent_id event,
+		void *aggregate_void);
+
+	void update_node(cmzn_fieldcache_id field_cache, cmzn_node_id node);
+
+	void update_from_event(cmzn_fieldmoduleevent_id event);
+
+	void update_values();
+
+	bool has_pending_changes() const;
+
+public:
+
+	Nodeset_incremental_aggregate(cmzn_fieldmodule_id field_module,
+		cmzn_field_id source_fieldIn, cmzn_nodeset_id nodesetIn,
+		enum Nodeset_aggregate_type typeIn, double recompute_fractionIn);
+
+	~Nodeset_incremental_aggregate();
+
+	cmzn_nodeset_id get_nodeset() const
+	{
+		return this->nodeset;
+	}
+
+	double get_recompute_fraction() const
+	{
+		return this->recompute_fraction;
+	}
+
+	/**
+	 * Gets the running aggregate values if they can be used for evaluation at
+	 * <time>: only at time 0, when up to date with all changes notified and
+	 * no changes are pending notification.
+	 * @return  true if values got, false if the field must be evaluated in full.
+	 */
+	bool get_values(double time, double *valuesOut) const
+	{
+		if (!(this->synchronised && (0.0 == time) && !this->has_pending_changes()))
+			return false;
+		for (int c = 0; c < this->number_of_components; ++c)
+			valuesOut[c] = this->values[c];
+		return true;
+	}
+
+	/** Evaluates source field at all nodes and rebuilds the running aggregate. */
+	void recompute();
+};
+
+Nodeset_incremental_aggregate::Nodeset_incremental_aggregate(
+	cmzn_fieldmodule_id field_module, cmzn_field_id source_fieldIn,
+	cmzn_nodeset_id nodesetIn, enum Nodeset_aggregate_type typeIn,
+	double recompute_fractionIn) :
+	source_field(cmzn_field_access(source_fieldIn)),
+	nodeset(cmzn_nodeset_access(nodesetIn)),
+	master_nodeset(cmzn_nodeset_get_master_nodeset(nodesetIn)),
+	nodeset_group_field(0),
+	notifier(cmzn_fieldmodule_create_fieldmodulenotifier(field_module)),
+	type(typeIn),
+	recompute_fraction(recompute_fractionIn),
+	number_of_components(cmzn_field_get_number_of_components(source_fieldIn)),
+	running(number_of_components),
+	values(number_of_components, 0.0),
+	synchronised(false)
+{
+	cmzn_nodeset_group_id nodeset_group = cmzn_nodeset_cast_group(nodesetIn);
+	if (nodeset_group)
+	{
+		/* node group fields are named after their nodeset e.g. GROUP.nodes */
+		char *nodeset_name = cmzn_nodeset_get_name(nodesetIn);
+		this->nodeset_group_field = cmzn_fieldmodule_find_field_by_name(field_module, nodeset_name);
+		cmzn_deallocate(nodeset_name);
+		cmzn_nodeset_group_destroy(&nodeset_group);
+	}
+	cmzn_fieldmodulenotifier_set_callback(this->notifier,
+		Nodeset_incremental_aggregate::field_module_callback, static_cast<void *>(this));
+}
+
+Nodeset_incremental_aggregate::~Nodeset_incremental_aggregate()
+{
+	cmzn_fieldmodulenotifier_clear_callback(this->notifier);
+	cmzn_fieldmodulenotifier_destroy(&this->notifier);
+	cmzn_field_destroy(&this->nodeset_group_field);
+	cmzn_nodeset_destroy(&this->master_nodeset);
+	cmzn_nodeset_destroy(&this->nodeset);
+	cmzn_field_destroy(&this->source_field);
+}
+
+void Nodeset_incremental_aggregate::field_module_callback(
+	cmzn_fieldmoduleevent_id event, void *aggregate_void)
+{
+	Nodeset_incremental_aggregate *aggregate =
+		static_cast<Nodeset_incremental_aggregate *>(aggregate_void);
+	if (event && aggregate)
+		aggregate->update_from_event(event);
+}
+
+void Nodeset_incremental_aggregate::update_values()
+{
+	if (!this->running.is_valid(this->type))
+	{
+		this->recompute();
+		return;
+	}
+	this->running.get_values(this->type, this->values.data());
+	this->synchronised = true;
+}
+
+/**
+ * @return  true if nodes, the source field or nodeset group membership have
+ * changed inside a change cache which has not ended. Node changes are logged
+ * in the nodeset and field changes in the field manager until notified.
+ */
+bool Nodeset_incremental_aggregate::has_pending_changes() const
+{
+	const DsLabelsChangeLog *change_log =
+		cmzn_nodeset_get_FE_nodeset_internal(this->master_nodeset)->getChangeLog();
+	if (change_log && (change_log->isAllChange() || (0 != change_log->getChangeSummary())))
+		return true;
+	if (this->nodeset_group_field && Computed_field_has_pending_change(this->nodeset_group_field))
+		return true;
+	return Computed_field_has_pending_change(this->source_field);
+}
+
+void Nodeset_incremental_aggregate::recompute()
+{
+	this->running.clear();
+	this->node_slots.clear();
+	this->node_values.clear();
+	this->node_defined.clear();
+	cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(this->source_field);
+	cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+	cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(this->nodeset);
+	cmzn_node_id node;
+	while (0 != (node = cmzn_nodeiterator_next(iterator)))
+	{
+		this->update_node(field_cache, node);
+		cmzn_node_destroy(&node);
+	}
+	cmzn_nodeiterator_destroy(&iterator);
+	cmzn_fieldcache_destroy(&field_cache);
+	cmzn_fieldmodule_destroy(&field_module);
+	this->update_values();
+}
+
+/** Replaces the contribution of <node> with its current source field value. */
+void Nodeset_incremental_aggregate::update_node(cmzn_fieldcache_id field_cache,
+	cmzn_node_id node)
+{
+	const int identifier = cmzn_node_get_identifier(node);
+	std::unordered_map<int, int>::iterator iter = this->node_slots.find(identifier);
+	int slot;
+	if (iter == this->node_slots.end())
+	{
+		slot = static_cast<int>(this->node_defined.size());
+		this->node_slots[identifier] = slot;
+		this->node_values.resize(this->node_values.size() + this->number_of_components);
+		this->node_defined.push_back(0);
+	}
+	else
+	{
+		slot = iter->second;
+	}
+	double *node_value = this->node_values.data() + static_cast<size_t>(slot)*this->number_of_components;
+	if (this->node_defined[slot])
+		this->running.remove(node_value);
+	cmzn_fieldcache_set_node(field_cache, node);
+	this->node_defined[slot] = (CMZN_OK == cmzn_field_evaluate_real(this->source_field,
+		field_cache, this->number_of_components, node_value));
+	if (this->node_defined[slot])
+		this->running.add(node_value);
+}
+
+void Nodeset_incremental_aggregate::update_from_event(cmzn_fieldmoduleevent_id event)
+{
+	const cmzn_field_change_flags source_change =
+		cmzn_fieldmoduleevent_get_field_change_flags(event, this->source_field);
+	if (source_change & (CMZN_FIELD_CHANGE_FLAG_DEFINITION | CMZN_FIELD_CHANGE_FLAG_FULL_RESULT))
+	{
+		this->recompute();
+		return;
+	}
+	if (this->nodeset_group_field && (cmzn_fieldmoduleevent_get_field_change_flags(
+		event, this->nodeset_group_field) & CMZN_FIELD_CHANGE_FLAG_RESULT))
+	{
+		this->recompute();
+		return;
+	}
+	cmzn_nodesetchanges_id nodesetchanges = cmzn_fieldmoduleevent_get_nodesetchanges(
+		event, this->master_nodeset);
+	if (!nodesetchanges)
+		return;
+	const cmzn_node_change_flags summary = cmzn_nodesetchanges_get_summary(nodesetchanges);
+	const int number_of_changes = cmzn_nodesetchanges_get_number_of_changes(nodesetchanges);
+	if ((number_of_changes < 0) ||
+		(summary & (CMZN_NODE_CHANGE_FLAG_REMOVE | CMZN_NODE_CHANGE_FLAG_IDENTIFIER)))
+	{
+		this->recompute();
+	}
+	else if ((summary & CMZN_NODE_CHANGE_FLAG_ADD) ||
+		(source_change & CMZN_FIELD_CHANGE_FLAG_PARTIAL_RESULT))
+	{
+		if (number_of_changes > this->recompute_fraction*static_cast<double>(this->node_slots.size()))
+		{
+			this->recompute();
+		}
+		else
+		{
+			cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(this->source_field);
+			cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+			/* visit only the nodes in the event's change log */
+			FE_nodeset *fe_nodeset = cmzn_nodeset_get_FE_nodeset_internal(this->master_nodeset);
+			const DsLabelsChangeLog *change_log =
+				event->getFeRegionChanges()->getNodeChangeLog(fe_nodeset->getFieldDomainType());
+			const DsLabelsGroup *changed_labels = change_log->getChangedLabelsGroup();
+			DsLabelIndex index = changed_labels->getFirstIndex();
+			while (DS_LABEL_INDEX_INVALID != index)
+			{
+				if (change_log->getChangeByIndex(index) &
+					(CMZN_NODE_CHANGE_FLAG_ADD | CMZN_NODE_CHANGE_FLAG_DEFINITION | CMZN_NODE_CHANGE_FLAG_FIELD))
+				{
+					cmzn_node_id node = fe_nodeset->getNode(index);
+					if (node && cmzn_nodeset_contains_node(this->nodeset, node))
+						this->update_node(field_cache, node);
+				}
+				if (!changed_labels->incrementIndex(index))
+					break;
+			}
+			cmzn_fieldcache_destroy(&field_cache);
+			cmzn_fieldmodule_destroy(&field_module);
+			this->update_values();
+		}
+	}
+	cmzn_nodesetchanges_destroy(&nodesetchanges);
+}
+
+/**
+ * Core of an incremental nodeset operator field: the Zinc nodeset operator
+ * <Operator_core> whose value evaluation uses the running aggregate when it
+ * is up to date. Evaluation at other times, of derivatives and of the terms
+ * used by least squares minimisation is unchanged.
+ */
+template <class Operator_core> class Computed_field_nodeset_incremental : public Operator_core
+{
+	std::shared_ptr<Nodeset_incremental_aggregate> aggregate;
+
+public:
+
+	Computed_field_nodeset_incremental(
+		const std::shared_ptr<Nodeset_incremental_aggregate> &aggregateIn) :
+		Operator_core(aggregateIn->get_nodeset()),
+		aggregate(aggregateIn)
+	{
+	}
+
+	Computed_field_core *copy()
+	{
+		return new Computed_field_nodeset_incremental<Operator_core>(this->aggregate);
+	}
+
+	int evaluate(cmzn_fieldcache& cache, FieldValueCache& inValueCache)
+	{
+		RealFieldValueCache& valueCache = RealFieldValueCache::cast(inValueCache);
+		if (this->aggregate->get_values(cache.getTime(), valueCache.values))
+			return 1;
+		return Operator_core::evaluate(cache, inValueCache);
+	}
+
+	char *get_command_string()
+	{
+		char *command_string = Operator_core::get_command_string();
+		if (command_string)
+		{
+			int error = 0;
+			char temp_string[60];
+			sprintf(temp_string, " incremental recompute_fraction %g",
+				this->aggregate->get_recompute_fraction());
+			append_string(&command_string, temp_string, &error);
+		}
+		return command_string;
+	}
+};
+
+/**
+ * Creates an incremental nodeset operator field with core <Operator_core>
+ * evaluating <aggregate>, whose source field and nodeset it uses.
+ */
+template <class Operator_core> cmzn_field_id cmzn_fieldmodule_create_field_nodeset_incremental(
+	cmzn_fieldmodule_id field_module, cmzn_field_id source_field,
+	const std::shared_ptr<Nodeset_incremental_aggregate> &aggregate)
+{
+	return Computed_field_create_generic(field_module,
+		/*check_source_field_existence*/true,
+		cmzn_field_get_number_of_components(source_field),
+		/*number_of_source_fields*/1, &source_field,
+		/*number_of_source_values*/0, NULL,
+		new Computed_field_nodeset_incremental<Operator_core>(aggregate));
+}
+
+/**
+ * Compares <field>, an incremental nodeset operator field, with <full_field>,
+ * the same operator evaluated in full, after each of <number_of_edits> random
+ * edits of <source_field> at nodes in <nodeset>, some several nodes in one
+ * change. The source field values are restored afterwards.
+ * @return  1 if the fields agree, 0 if not or the source field cannot be
+ * assigned at the nodes.
+ */
+int Nodeset_incremental_verify_edits(cmzn_fieldmodule_id field_module,
+	cmzn_field_id field, cmzn_field_id full_field, cmzn_field_id source_field,
+	cmzn_nodeset_id nodeset, int number_of_edits)
+{
+	const int number_of_components = cmzn_field_get_number_of_components(source_field);
+	cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+	std::vector<cmzn_node_id> nodes;
+	std::vector<double> original_values;
+	std::vector<double> values(number_of_components);
+	cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(nodeset);
+	cmzn_node_id node;
+	while (0 != (node = cmzn_nodeiterator_next(iterator)))
+	{
+		cmzn_fieldcache_set_node(field_cache, node);
+		if (CMZN_OK == cmzn_field_evaluate_real(source_field, field_cache, number_of_components, values.data()))
+		{
+			nodes.push_back(node);
+			original_values.insert(original_values.end(), values.begin(), values.end());
+		}
+		else
+		{
+			cmzn_node_destroy(&node);
+		}
+	}
+	cmzn_nodeiterator_destroy(&iterator);
+	const int number_of_nodes = static_cast<int>(nodes.size());
+	int return_code = (0 < number_of_nodes);
+	if (!return_code)
+	{
+		display_message(ERROR_MESSAGE, "verify_edits:  Source field is not defined on nodeset");
+	}
+	std::mt19937 generator(1);
+	std::uniform_int_distribution<int> node_distribution(0, number_of_nodes - 1);
+	std::uniform_real_distribution<double> value_distribution(-1.0, 1.0);
+	std::vector<double> incremental_values(number_of_components);
+	std::vector<double> full_values(number_of_components);
+	double maximum_difference = 0.0;
+	/* compares incremental and full values with a new cache holding no values
+	 * from before the edit */
+	auto compare_values = [&](int edit) -> int
+	{
+		int result = 1;
+		cmzn_fieldcache_id evaluate_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+		if ((CMZN_OK != cmzn_field_evaluate_real(field, evaluate_cache, number_of_components, incremental_values.data())) ||
+			(CMZN_OK != cmzn_field_evaluate_real(full_field, evaluate_cache, number_of_components, full_values.data())))
+		{
+			display_message(ERROR_MESSAGE, "verify_edits:  Field cannot be evaluated after edit %d", edit + 1);
+			result = 0;
+		}
+		for (int c = 0; (c < number_of_components) && result; ++c)
+		{
+			const double difference = fabs(incremental_values[c] - full_values[c])/
+				(1.0 + fabs(full_values[c]));
+			if (difference > maximum_difference)
+				maximum_difference = difference;
+		}
+		cmzn_fieldcache_destroy(&evaluate_cache);
+		return result;
+	};
+	for (int edit = 0; (edit < number_of_edits) && return_code; ++edit)
+	{
+		const int number_of_edited_nodes = (0 == edit % 5) ? 1 + (edit/5) % 8 : 1;
+		cmzn_fieldmodule_begin_change(field_module);
+		for (int n = 0; n < number_of_edited_nodes; ++n)
+		{
+			const int node_index = node_distribution(generator);
+			const double *original = original_values.data() + static_cast<size_t>(node_index)*number_of_components;
+			for (int c = 0; c < number_of_components; ++c)
+				values[c] = original[c]*(1.0 + 0.5*value_distribution(generator)) + value_distribution(generator);
+			cmzn_fieldcache_set_node(field_cache, nodes[node_index]);
+			if (CMZN_OK != cmzn_field_assign_real(source_field, field_cache, number_of_components, values.data()))
+			{
+				display_message(ERROR_MESSAGE, "verify_edits:  Source field cannot be assigned at nodes");
+				return_code = 0;
+				break;
+			}
+		}
+		/* pending changes are not yet in the running totals */
+		if (return_code)
+			return_code = compare_values(edit);
+		cmzn_fieldmodule_end_change(field_module);
+		if (return_code)
+			return_code = compare_values(edit);
+	}
+	cmzn_fieldmodule_begin_change(field_module);
+	for (int n = 0; n < number_of_nodes; ++n)
+	{
+		cmzn_fieldcache_set_node(field_cache, nodes[n]);
+		cmzn_field_assign_real(source_field, field_cache, number_of_components,
+			original_values.data() + static_cast<size_t>(n)*number_of_components);
+		cmzn_node_destroy(&nodes[n]);
+	}
+	cmzn_fieldmodule_end_change(field_module);
+	cmzn_fieldcache_destroy(&field_cache);
+	if (return_code)
+	{
+		if (maximum_difference > 1.0E-10)
+		{
+			display_message(ERROR_MESSAGE, "verify_edits:  Incremental and full values differ "
+				"by up to %g over %d random edits", maximum_difference, number_of_edits);
+			return_code = 0;
+		}
+		else
+		{
+			display_message(INFORMATION_MESSAGE, "verify_edits:  Incremental and full values agree "
+				"to %g over %d random edits\n", maximum_difference, number_of_edits);
+		}
+	}
+	return return_code;
+}
+
+} // anonymous namespace
+
 int cmzn_field_is_valid_nodeset_operator_element_map(cmzn_field_id field, void *)
 {
 	if (field)
@@ -44,11 +652,15 @@ int cmzn_field_is_valid_nodeset_operator_element_map(cmzn_field_id field, void *
 /**
  * Command modifier function for getting the arguments common to all
  * nodeset_operator-derived field types and creating the field using the
- * supplied field create function pointer.
+ * supplied field create function pointer, or with the incremental option the
+ * incremental create function with a running aggregate of <aggregate_type>.
  */
-int define_Computed_field_type_nodeset_operator(struct Parse_state *state,
+static int define_Computed_field_type_nodeset_operator(struct Parse_state *state,
 	Computed_field_modify_data *field_modify, const char *type_name, const char *help_string,
-	cmzn_field_id (*field_create_function)(cmzn_fieldmodule_id, cmzn_field_id, cmzn_nodeset_id))
+	cmzn_field_id (*field_create_function)(cmzn_fieldmodule_id, cmzn_field_id, cmzn_nodeset_id),
+	enum Nodeset_aggregate_type aggregate_type,
+	cmzn_field_id (*incremental_create_function)(cmzn_fieldmodule_id, cmzn_field_id,
+		const std::shared_ptr<Nodeset_incremental_aggregate> &))
 {
 	if (!(state && field_modify && help_string))
 		return 0;
@@ -57,8 +669,27 @@ int define_Computed_field_type_nodeset_operator(struct Parse_state *state,
 	cmzn_nodeset_id nodeset = nullptr;
 	cmzn_field_id element_map_field = nullptr;
 	char *nodeset_name = 0;
+	char incremental_flag = 0;
+	double recompute_fraction = 0.1;
+	int verify_edits = 0;
+	std::string full_help_string(help_string);
+	full_help_string +=
+		" With the incremental option the field keeps running totals which are "
+		"updated as nodes and the source field change, by re-evaluating the "
+		"source field only at changed nodes, and uses them when evaluated at "
+		"time 0; the whole nodeset is evaluated again when more than "
+		"recompute_fraction of its nodes change, when nodes are removed or the "
+		"source field changes independently of nodes, or when the field is "
+		"redefined. Evaluation at other times, derivatives and minimisation are "
+		"as without the option. Changes are seen by the running totals when "
+		"the change cache they are made in ends; until then the field is "
+		"evaluated over the whole nodeset. verify_edits makes that many "
+		"random edits of the source field, comparing the incremental value with "
+		"a full evaluation inside and after each change cache, then restores "
+		"the source field. Not "
+		"available with element_map_field.";
 	Option_table *option_table = CREATE(Option_table)();
-	Option_table_add_help(option_table, help_string);
+	Option_table_add_help(option_table, full_help_string.c_str());
 	struct Set_Computed_field_conditional_data set_source_field_data =
 	{
 		Computed_field_has_numerical_components,
@@ -77,6 +708,10 @@ int define_Computed_field_type_nodeset_operator(struct Parse_state *state,
 		" NODE_GROUP_FIELD_NAME|[GROUP_NAME.]nodes|datapoints");
 	Option_table_add_entry(option_table, "element_map_field", &element_map_field,
 		&set_element_map_field_data, set_Computed_field_conditional);
+	Option_table_add_char_flag_entry(option_table, "incremental", &incremental_flag);
+	Option_table_add_non_negative_double_entry(option_table, "recompute_fraction",
+		&recompute_fraction);
+	Option_table_add_int_non_negative_entry(option_table, "verify_edits", &verify_edits);
 	return_code = Option_table_multi_parse(option_table, state);
 	DESTROY(Option_table)(&option_table);
 	if (return_code)
@@ -110,7 +745,39 @@ int define_Computed_field_type_nodeset_operator(struct Parse_state *state,
 				"gfx define field %s:  Must specify source field", type_name);
 			return_code = 0;
 		}
-		if (return_code)
+		if ((incremental_flag || verify_edits) && element_map_field)
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx define field %s:  incremental cannot be used with element_map_field", type_name);
+			return_code = 0;
+		}
+		if (verify_edits && !incremental_flag)
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx define field %s:  verify_edits requires incremental", type_name);
+			return_code = 0;
+		}
+		if (return_code && incremental_flag)
+		{
+			std::shared_ptr<Nodeset_incremental_aggregate> aggregate =
+				std::make_shared<Nodeset_incremental_aggregate>(field_modify->get_field_module(),
+					source_field, nodeset, aggregate_type, recompute_fraction);
+			return_code = field_modify->define_field((incremental_create_function)(
+				field_modify->get_field_module(), source_field, aggregate));
+			if (return_code)
+			{
+				aggregate->recompute();
+				if (verify_edits)
+				{
+					cmzn_field_id full_field = (field_create_function)(
+						field_modify->get_field_module(), source_field, nodeset);
+					return_code = Nodeset_incremental_verify_edits(field_modify->get_field_module(),
+						field_modify->get_field(), full_field, source_field, nodeset, verify_edits);
+					cmzn_field_destroy(&full_field);
+				}
+			}
+		}
+		else if (return_code)
 		{
 			cmzn_field_id field = (field_create_function)(
 				field_modify->get_field_module(), source_field, nodeset);
@@ -146,7 +813,8 @@ int define_Computed_field_type_nodeset_sum(struct Parse_state *state,
 	return define_Computed_field_type_nodeset_operator(state, field_modify, "nodeset_sum",
 		"A nodeset_sum field calculates the sums of each of the supplied field's "
 		"component values over all nodes in the nodeset over which it is defined.",
-		cmzn_fieldmodule_create_field_nodeset_sum);
+		cmzn_fieldmodule_create_field_nodeset_sum,
+		NODESET_AGGREGATE_SUM, cmzn_fieldmodule_create_field_nodeset_incremental<Computed_field_nodeset_sum>);
 }
 
 /**
@@ -162,7 +830,8 @@ int define_Computed_field_type_nodeset_mean(struct Parse_state *state,
 	return define_Computed_field_type_nodeset_operator(state, field_modify, "nodeset_mean",
 		"A nodeset_mean field calculates the means of each of the supplied field's "
 		"component values over all nodes in the nodeset over which it is defined.",
-		cmzn_fieldmodule_create_field_nodeset_mean);
+		cmzn_fieldmodule_create_field_nodeset_mean,
+		NODESET_AGGREGATE_MEAN, cmzn_fieldmodule_create_field_nodeset_incremental<Computed_field_nodeset_mean>);
 }
 
 /**
@@ -180,7 +849,8 @@ int define_Computed_field_type_nodeset_sum_squares(struct Parse_state *state,
 		"supplied field's component values over all nodes in the nodeset over which it is "
 		"defined. This field supplies individual terms to least-squares optimisation methods. "
 		"See 'gfx minimise' command.",
-		cmzn_fieldmodule_create_field_nodeset_sum_squares);
+		cmzn_fieldmodule_create_field_nodeset_sum_squares,
+		NODESET_AGGREGATE_SUM_SQUARES, cmzn_fieldmodule_create_field_nodeset_incremental<Computed_field_nodeset_sum_squares>);
 	return return_code;
 }
 
@@ -198,7 +868,8 @@ int define_Computed_field_type_nodeset_mean_squares(struct Parse_state *state,
 		"A nodeset_mean_squares field calculates the means of the squares of each of the "
 		"supplied field's component values over all nodes in the nodeset over which it is "
 		"defined. This field supplies individual terms to least-squares optimisation methods. "
-		"See 'gfx minimise' command.", cmzn_fieldmodule_create_field_nodeset_mean_squares);
+		"See 'gfx minimise' command.", cmzn_fieldmodule_create_field_nodeset_mean_squares,
+		NODESET_AGGREGATE_MEAN_SQUARES, cmzn_fieldmodule_create_field_nodeset_incremental<Computed_field_nodeset_mean_squares>);
 }
 
 /**
@@ -213,7 +884,8 @@ int define_Computed_field_type_nodeset_maximum(struct Parse_state *state,
 		reinterpret_cast<Computed_field_modify_data *>(field_modify_void);
 	return define_Computed_field_type_nodeset_operator(state, field_modify, "nodeset_maximum",
 		"A nodeset_maximum field returns the maximum value of each component of "
-		"the source field over the nodeset.", cmzn_fieldmodule_create_field_nodeset_maximum);
+		"the source field over the nodeset.", cmzn_fieldmodule_create_field_nodeset_maximum,
+		NODESET_AGGREGATE_MAXIMUM, cmzn_fieldmodule_create_field_nodeset_incremental<Computed_field_nodeset_maximum>);
 }
 
 /**
@@ -228,7 +900,8 @@ int define_Computed_field_type_nodeset_minimum(struct Parse_state *state,
 		reinterpret_cast<Computed_field_modify_data *>(field_modify_void);
 	return define_Computed_field_type_nodeset_operator(state, field_modify, "nodeset_minimum",
 		"A nodeset_minimum field returns the minimum value of each component of "
-		"the source field over the nodeset.", cmzn_fieldmodule_create_field_nodeset_minimum);
+		"the source field over the nodeset.", cmzn_fieldmodule_create_field_nodeset_minimum,
+		NODESET_AGGREGATE_MINIMUM, cmzn_fieldmodule_create_field_nodeset_incremental<Computed_field_nodeset_minimum>);
 }
 
 int Computed_field_register_types_nodeset_operators(
@@ -0,0 +1,435 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/status.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "general/parallel_app.hpp"
+#include "computed_field/computed_field_app.h"
+#include "finite_element/change_identifiers_app.hpp"
+
+namespace {
+
+/** Node functions for Change_identifiers_sorted. */
+struct Change_identifiers_node_traits
+{
+	typedef cmzn_nodeset_id container_id;
+	typedef cmzn_node_id object_id;
+	typedef cmzn_nodeiterator_id iterator_id;
+
+	static const char *get_object_name()
+	{
+		return "node";
+	}
+
+	static container_id get_master(container_id nodeset)
+	{
+		return cmzn_nodeset_get_master_nodeset(nodeset);
+	}
+
+	static void destroy_container(container_id *nodeset_address)
+	{
+		cmzn_nodeset_destroy(nodeset_address);
+	}
+
+	static iterator_id create_iterator(container_id nodeset)
+	{
+		return cmzn_nodeset_create_nodeiterator(nodeset);
+	}
+
+	static object_id next(iterator_id iterator)
+	{
+		return cmzn_nodeiterator_next(iterator);
+	}
+
+	static void destroy_iterator(iterator_id *iterator_address)
+	{
+		cmzn_nodeiterator_destroy(iterator_address);
+	}
+
+	static bool contains(container_id nodeset, object_id node)
+	{
+		return cmzn_nodeset_contains_node(nodeset, node);
+	}
+
+	static object_id find(container_id nodeset, int identifier)
+	{
+		return cmzn_nodeset_find_node_by_identifier(nodeset, identifier);
+	}
+
+	static int get_identifier(object_id node)
+	{
+		return cmzn_node_get_identifier(node);
+	}
+
+	static int set_identifier(object_id node, int identifier)
+	{
+		return cmzn_node_set_identifier(node, identifier);
+	}
+
+	static void destroy(object_id *node_address)
+	{
+		cmzn_node_destroy(node_address);
+	}
+
+	static cmzn_fieldmodule_id get_fieldmodule(container_id nodeset)
+	{
+		return cmzn_nodeset_get_fieldmodule(nodeset);
+	}
+
+	static int set_location(cmzn_fieldcache_id field_cache, object_id node)
+	{
+		return cmzn_fieldcache_set_node(field_cache, node);
+	}
+
+	/** Only node-local fields can be evaluated at different nodes on threads. */
+	static bool can_evaluate_on_threads(cmzn_field_id field)
+	{
+		return cmzn_field_is_node_local(field);
+	}
+};
+
+/** Element functions for Change_identifiers_sorted. */
+struct Change_identifiers_element_traits
+{
+	typedef cmzn_mesh_id container_id;
+	typedef cmzn_element_id object_id;
+	typedef cmzn_elementiterator_id iterator_id;
+
+	static const char *get_object_name()
+	{
+		return "element";
+	}
+
+	static container_id get_master(container_id mesh)
+	{
+		return cmzn_mesh_get_master_mesh(mesh);
+	}
+
+	static void destroy_container(container_id *mesh_address)
+	{
+		cmzn_mesh_destroy(mesh_address);
+	}
+
+	static iterator_id create_iterator(container_id mesh)
+	{
+		return cmzn_mesh_create_elementiterator(mesh);
+	}
+
+	static object_id next(iterator_id iterator)
+	{
+		return cmzn_elementiterator_next(iterator);
+	}
+
+	static void destroy_iterator(iterator_id *iterator_address)
+	{
+		cmzn_elementiterator_destroy(iterator_address);
+	}
+
+	static bool contains(container_id mesh, object_id element)
+	{
+		return cmzn_mesh_contains_element(mesh, element);
+	}
+
+	static object_id find(container_id mesh, int identifier)
+	{
+		return cmzn_mesh_find_element_by_identifier(mesh, identifier);
+	}
+
+	static int get_identifier(object_id element)
+	{
+		return cmzn_element_get_identifier(element);
+	}
+
+	static int set_identifier(object_id element, int identifier)
+	{
+		return cmzn_element_set_identifier(element, identifier);
+	}
+
+	static void destroy(object_id *element_address)
+	{
+		cmzn_element_destroy(element_address);
+	}
+
+	static cmzn_fieldmodule_id get_fieldmodule(container_id mesh)
+	{
+		return cmzn_mesh_get_fieldmodule(mesh);
+	}
+
+	/** Sets the location to the centre of <element>. */
+	static int set_location(cmzn_fieldcache_id field_cache, object_id element)
+	{
+		double xi[3] = { 0.5, 0.5, 0.5 };
+		switch (cmzn_element_get_shape_type(element))
+		{
+			case CMZN_ELEMENT_SHAPE_TYPE_TRIANGLE:
+				xi[0] = xi[1] = 1.0/3.0;
+				break;
+			case CMZN_ELEMENT_SHAPE_TYPE_TETRAHEDRON:
+				xi[0] = xi[1] = xi[2] = 0.25;
+				break;
+			case CMZN_ELEMENT_SHAPE_TYPE_WEDGE12:
+				xi[0] = xi[1] = 1.0/3.0;
+				break;
+			case CMZN_ELEMENT_SHAPE_TYPE_WEDGE13:
+				xi[0] = xi[2] = 1.0/3.0;
+				break;
+			case CMZN_ELEMENT_SHAPE_TYPE_WEDGE23:
+				xi[1] = xi[2] = 1.0/3.0;
+				break;
+			default:
+				break;
+		}
+		return cmzn_fieldcache_set_mesh_location(field_cache, element,
+			cmzn_element_get_dimension(element), xi);
+	}
+
+	/** Element evaluation shares element and basis state between caches. */
+	static bool can_evaluate_on_threads(cmzn_field_id)
+	{
+		return false;
+	}
+};
+
+/**
+ * Orders objects by sort field values, first component most significant, then
+ * by their position in identifier order.
+ */
+class Change_identifiers_compare
+{
+	const std::vector<double>& values;
+	const int number_of_components;
+
+public:
+
+	Change_identifiers_compare(const std::vector<double>& valuesIn, int number_of_componentsIn) :
+		values(valuesIn),
+		number_of_components(number_of_componentsIn)
+	{
+	}
+
+	bool operator()(int a, int b) const
+	{
+		const double *a_values = this->values.data() + static_cast<size_t>(a)*this->number_of_components;
+		const double *b_values = this->values.data() + static_cast<size_t>(b)*this->number_of_components;
+		for (int c = 0; c < this->number_of_components; ++c)
+		{
+			if (a_values[c] < b_values[c])
+				return true;
+			if (a_values[c] > b_values[c])
+				return false;
+		}
+		return a < b;
+	}
+};
+
+/**
+ * Sets the identifiers of <objects> to <identifiers>, first moving those which
+ * change to free identifiers after <temporary_identifier>, which is advanced.
+ * @return  True on success, false if any identifier could not be set.
+ */
+template <class Traits>
+bool Change_identifiers_assign(const std::vector<typename Traits::object_id>& objects,
+	const std::vector<int>& identifiers, int& temporary_identifier)
+{
+	const size_t number_of_objects = objects.size();
+	for (size_t i = 0; i < number_of_objects; ++i)
+	{
+		if ((identifiers[i] != Traits::get_identifier(objects[i])) &&
+			(CMZN_OK != Traits::set_identifier(objects[i], ++temporary_identifier)))
+		{
+			return false;
+		}
+	}
+	for (size_t i = 0; i < number_of_objects; ++i)
+	{
+		if ((identifiers[i] != Traits::get_identifier(objects[i])) &&
+			(CMZN_OK != Traits::set_identifier(objects[i], identifiers[i])))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+template <class Traits>
+int Change_identifiers_sorted(typename Traits::container_id container, int offset,
+	cmzn_field_id sort_by_field, double time, int number_of_threads)
+{
+	const int number_of_components = (sort_by_field) ?
+		cmzn_field_get_number_of_components(sort_by_field) : 0;
+	if (!(container && (0 < number_of_components)))
+	{
+		display_message(ERROR_MESSAGE, "Change_identifiers_sorted.  Invalid argument(s)");
+		return 0;
+	}
+	/* iterators visit objects in identifier order */
+	std::vector<typename Traits::object_id> objects;
+	typename Traits::iterator_id iterator = Traits::create_iterator(container);
+	typename Traits::object_id object;
+	while (0 != (object = Traits::next(iterator)))
+		objects.push_back(object);
+	Traits::destroy_iterator(&iterator);
+	const int number_of_objects = static_cast<int>(objects.size());
+	int return_code = 1;
+
+	/* evaluate sort_by field with a field cache per thread if safe, otherwise serially */
+	number_of_threads = cmgui_get_number_of_threads_for_items(number_of_threads, number_of_objects);
+	const int number_of_evaluate_threads =
+		Traits::can_evaluate_on_threads(sort_by_field) ? number_of_threads : 1;
+	cmzn_fieldmodule_id field_module = Traits::get_fieldmodule(container);
+	std::vector<cmzn_fieldcache_id> field_caches(number_of_evaluate_threads);
+	for (int t = 0; t < number_of_evaluate_threads; ++t)
+	{
+		field_caches[t] = cmzn_fieldmodule_create_fieldcache(field_module);
+		cmzn_fieldcache_set_time(field_caches[t], time);
+	}
+	cmzn_fieldmodule_destroy(&field_module);
+	std::vector<double> values(static_cast<size_t>(number_of_objects)*number_of_components);
+	std::vector<int> failed_objects(number_of_evaluate_threads, -1);
+	cmgui_parallel_for_ranges(number_of_objects, number_of_evaluate_threads,
+		[&](int thread_index, int begin, int end)
+	{
+		cmzn_fieldcache_id field_cache = field_caches[thread_index];
+		for (int i = begin; i < end; ++i)
+		{
+			Traits::set_location(field_cache, objects[i]);
+			if (CMZN_OK != cmzn_field_evaluate_real(sort_by_field, field_cache,
+				number_of_components, values.data() + static_cast<size_t>(i)*number_of_components))
+			{
+				failed_objects[thread_index] = i;
+				break;
+			}
+		}
+	});
+	for (int t = 0; t < number_of_evaluate_threads; ++t)
+	{
+		if ((0 <= failed_objects[t]) && return_code)
+		{
+			char *field_name = cmzn_field_get_name(sort_by_field);
+			display_message(ERROR_MESSAGE, "Change identifiers.  Could not evaluate "
+				"sort_by field %s at %s %d", field_name, Traits::get_object_name(),
+				Traits::get_identifier(objects[failed_objects[t]]));
+			cmzn_deallocate(field_name);
+			return_code = 0;
+		}
+		cmzn_fieldcache_destroy(&field_caches[t]);
+	}
+
+	/* sort ranges in parallel, then merge them in order */
+	std::vector<int> order(number_of_objects);
+	for (int i = 0; i < number_of_objects; ++i)
+		order[i] = i;
+	if (return_code)
+	{
+		const Change_identifiers_compare compare(values, number_of_components);
+		std::vector<int> range_ends(number_of_threads + 1, 0);
+		cmgui_parallel_for_ranges(number_of_objects, number_of_threads,
+			[&](int thread_index, int begin, int end)
+		{
+			std::sort(order.begin() + begin, order.begin() + end, compare);
+			range_ends[thread_index + 1] = end;
+		});
+		for (int t = 2; t <= number_of_threads; ++t)
+			std::inplace_merge(order.begin(), order.begin() + range_ends[t - 1],
+				order.begin() + range_ends[t], compare);
+	}
+
+	/* map old identifiers to new and check for clashes with objects not renumbered */
+	std::vector<int> old_identifiers(number_of_objects);
+	std::vector<int> new_identifiers(number_of_objects);
+	typename Traits::container_id master = Traits::get_master(container);
+	int maximum_identifier = 0;
+	for (int i = 0; (i < number_of_objects) && return_code; ++i)
+	{
+		const int old_identifier = Traits::get_identifier(objects[i]);
+		if (((0 < offset) && (old_identifier > std::numeric_limits<int>::max() - offset)) ||
+			((offset < 0) && (old_identifier + offset < 1)))
+		{
+			display_message(ERROR_MESSAGE, "Change identifiers.  Offset %d takes %s %d out "
+				"of range", offset, Traits::get_object_name(), old_identifier);
+			return_code = 0;
+			break;
+		}
+		const int new_identifier = old_identifier + offset;
+		old_identifiers[i] = old_identifier;
+		new_identifiers[order[i]] = new_identifier;
+		typename Traits::object_id existing_object = Traits::find(master, new_identifier);
+		if (existing_object && !Traits::contains(container, existing_object))
+		{
+			display_message(ERROR_MESSAGE, "Change identifiers.  %s %d is already in use",
+				Traits::get_object_name(), new_identifier);
+			return_code = 0;
+		}
+		Traits::destroy(&existing_object);
+		maximum_identifier = std::max(maximum_identifier, std::max(old_identifier, new_identifier));
+	}
+	if (return_code)
+	{
+		/* highest identifier in use outside the container */
+		iterator = Traits::create_iterator(master);
+		while (0 != (object = Traits::next(iterator)))
+		{
+			maximum_identifier = std::max(maximum_identifier, Traits::get_identifier(object));
+			Traits::destroy(&object);
+		}
+		Traits::destroy_iterator(&iterator);
+		/* room for temporary identifiers for renumbering and for undoing it */
+		if (maximum_identifier > std::numeric_limits<int>::max() - 2*number_of_objects)
+		{
+			display_message(ERROR_MESSAGE, "Change identifiers.  "
+				"Identifiers too large to renumber %ss", Traits::get_object_name());
+			return_code = 0;
+		}
+	}
+	Traits::destroy_container(&master);
+
+	/* all keys and identifiers are checked; move changed objects to free
+	 * identifiers so the final pass cannot clash */
+	if (return_code)
+	{
+		int temporary_identifier = maximum_identifier;
+		if (!Change_identifiers_assign<Traits>(objects, new_identifiers, temporary_identifier))
+		{
+			/* put every object back on its old identifier the same way */
+			const bool restored = Change_identifiers_assign<Traits>(objects, old_identifiers,
+				temporary_identifier);
+			display_message(ERROR_MESSAGE, "Change identifiers.  Failed to renumber %ss; %s",
+				Traits::get_object_name(), restored ? "identifiers restored" :
+				"could not restore all identifiers");
+			return_code = 0;
+		}
+	}
+	for (int i = 0; i < number_of_objects; ++i)
+		Traits::destroy(&objects[i]);
+	return (return_code);
+}
+
+} // anonymous namespace
+
+int Nodeset_change_identifiers_sorted(cmzn_nodeset_id nodeset, int offset,
+	cmzn_field_id sort_by_field, double time, int number_of_threads)
+{
+	return Change_identifiers_sorted<Change_identifiers_node_traits>(nodeset, offset,
+		sort_by_field, time, number_of_threads);
+}
+
+int Mesh_change_identifiers_sorted(cmzn_mesh_id mesh, int offset,
+	cmzn_field_id sort_by_field, double time, int number_of_threads)
+{
+	return Change_identifiers_sorted<Change_identifiers_element_traits>(mesh, offset,
+		sort_by_field, time, number_of_threads);
+}
@@ -0,0 +1,40 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (CHANGE_IDENTIFIERS_APP_HPP)
+#define CHANGE_IDENTIFIERS_APP_HPP
+
+#include "opencmiss/zinc/types/fieldid.h"
+#include "opencmiss/zinc/types/meshid.h"
+#include "opencmiss/zinc/types/nodesetid.h"
+
+/**
+ * Renumbers the nodes in <nodeset>, which may be a group, in order of the
+ * values of <sort_by_field> at <time>, first component most significant and
+ * keeping the current identifier order for equal values. The existing set of
+ * identifiers is reassigned in this order with <offset> added. The values are
+ * sorted on <number_of_threads> (0 = hardware threads), and the field is
+ * evaluated on them too if cmzn_field_is_node_local, otherwise serially. The
+ * complete map from old to new identifiers is checked against nodes outside
+ * the group before any identifier is changed, and if setting an identifier
+ * fails the old identifiers are restored. The result is independent of the
+ * number of threads.
+ * @return  1 on success, 0 on failure.
+ */
+int Nodeset_change_identifiers_sorted(cmzn_nodeset_id nodeset, int offset,
+	cmzn_field_id sort_by_field, double time, int number_of_threads);
+
+/**
+ * Renumbers the elements in <mesh>, which may be a group, in order of the
+ * values of <sort_by_field> at their centres at <time>, evaluated serially as
+ * element evaluation is not thread safe. Otherwise as for
+ * Nodeset_change_identifiers_sorted.
+ * @return  1 on success, 0 on failure.
+ */
+int Mesh_change_identifiers_sorted(cmzn_mesh_id mesh, int offset,
+	cmzn_field_id sort_by_field, double time, int number_of_threads);
+
+#endif /* !defined (CHANGE_IDENTIFIERS_APP_HPP) */
@@ -0,0 +1,670 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldgroup.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/fieldsubobjectgroup.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/region.h"
+#include "opencmiss/zinc/status.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "general/parallel_app.hpp"
+#include "command/parser.h"
+#include "computed_field/computed_field_app.h"
+#include "region/cmiss_region_app.h"
+#include "finite_element/export_field_values_app.h"
+
+namespace {
+
+enum Field_values_export_format
+{
+	FIELD_VALUES_EXPORT_FORMAT_BINARY,
+	FIELD_VALUES_EXPORT_FORMAT_CSV
+};
+
+/** Node, or element and xi, at which one row of values is evaluated. */
+struct Field_values_location
+{
+	cmzn_node_id node;
+	cmzn_element_id element;
+	double xi[3];
+};
+
+/**
+ * Evaluates fields at chunks of locations and streams the rows to file.
+ * Every column, including identifiers and xi, is written as a double.
+ */
+class Field_values_exporter
+{
+	cmzn_fieldmodule_id field_module;
+	std::vector<cmzn_field_id> fields;
+	std::vector<int> field_components;
+	std::vector<std::string> column_names;
+	int number_of_location_columns, number_of_columns;
+	int dimension; /* 0 for nodes */
+	enum Field_values_export_format format;
+	std::string file_name;
+	FILE *file;
+	std::vector<cmzn_fieldcache_id> field_caches;
+	long long number_of_rows;
+	bool write_failed;
+
+	/* chunk being assembled: locations, and offsets in it of location groups
+	 * that must be evaluated on the same thread, i.e. all points in an element */
+	std::vector<Field_values_location> locations;
+	std::vector<int> group_starts;
+	std::vector<double> values;
+
+	void evaluate_chunk();
+
+	void write_chunk();
+
+	void clear_chunk();
+
+public:
+
+	Field_values_exporter(cmzn_fieldmodule_id field_moduleIn,
+		enum Field_values_export_format formatIn, int number_of_threads,
+		double time) :
+		field_module(cmzn_fieldmodule_access(field_moduleIn)),
+		number_of_location_columns(0),
+		number_of_columns(0),
+		dimension(0),
+		format(formatIn),
+		file(0),
+		field_caches(number_of_threads),
+		number_of_rows(0),
+		write_failed(false)
+	{
+		/* caches are only created and destroyed on this thread as they register
+		 * with the region */
+		for (int t = 0; t < number_of_threads; ++t)
+		{
+			this->field_caches[t] = cmzn_fieldmodule_create_fieldcache(this->field_module);
+			cmzn_fieldcache_set_time(this->field_caches[t], time);
+		}
+	}
+
+	~Field_values_exporter()
+	{
+		if (this->file)
+			fclose(this->file);
+		for (size_t t = 0; t < this->field_caches.size(); ++t)
+			cmzn_fieldcache_destroy(&this->field_caches[t]);
+		for (size_t f = 0; f < this->fields.size(); ++f)
+			cmzn_field_destroy(&this->fields[f]);
+		cmzn_fieldmodule_destroy(&this->field_module);
+	}
+
+	/** @return  true if field is found and real-valued, otherwise false with error. */
+	bool add_field(const char *field_name);
+
+	/** Set domain: dimension 0 for nodes or datapoints, otherwise mesh dimension. */
+	void set_domain_dimension(int dimensionIn, const char *identifier_name);
+
+	bool open(const char *file_nameIn);
+
+	/** Adds all nodes in nodeset to chunks and writes them. */
+	bool export_nodeset(cmzn_nodeset_id nodeset, int chunk_size);
+
+	/** Adds a grid of divisions^dimension cell-centred points per element. */
+	bool export_mesh(cmzn_mesh_id mesh, int divisions, int chunk_size);
+
+	/** Closes the data file and writes the JSON header for binary output. */
+	bool finish(const char *domain_name);
+
+	long long get_number_of_rows() const
+	{
+		return this->number_of_rows;
+	}
+
+	int get_number_of_columns() const
+	{
+		return this->number_of_columns;
+	}
+
+	/**
+	 * @return  Number of threads chunks are evaluated on: the number of field
+	 * caches for nodes where all fields are node-local, otherwise 1 as element
+	 * field evaluation is not safe on several threads.
+	 */
+	int get_number_of_evaluate_threads() const;
+};
+
+int Field_values_exporter::get_number_of_evaluate_threads() const
+{
+	if (0 != this->dimension)
+		return 1;
+	for (size_t f = 0; f < this->fields.size(); ++f)
+	{
+		if (!cmzn_field_is_node_local(this->fields[f]))
+			return 1;
+	}
+	return static_cast<int>(this->field_caches.size());
+}
+
+bool Field_values_exporter::add_field(const char *field_name)
+{
+	cmzn_field_id field = cmzn_fieldmodule_find_field_by_name(this->field_module, field_name);
+	if (!field)
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx export field_values:  Unknown field '%s'", field_name);
+		return false;
+	}
+	if (CMZN_FIELD_VALUE_TYPE_REAL != cmzn_field_get_value_type(field))
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx export field_values:  Field '%s' is not real-valued", field_name);
+		cmzn_field_destroy(&field);
+		return false;
+	}
+	const int number_of_components = cmzn_field_get_number_of_components(field);
+	this->fields.push_back(field);
+	this->field_components.push_back(number_of_components);
+	for (int c = 1; c <= number_of_components; ++c)
+	{
+		std::string column_name(field_name);
+		if (1 < number_of_components)
+		{
+			char *component_name = cmzn_field_get_component_name(field, c);
+			column_name += ".";
+			column_name += (component_name) ? component_name : "?";
+			cmzn_deallocate(component_name);
+		}
+		this->column_names.push_back(column_name);
+	}
+	this->number_of_columns += number_of_components;
+	return true;
+}
+
+void Field_values_exporter::set_domain_dimension(int dimensionIn,
+	const char *identifier_name)
+{
+	this->dimension = dimensionIn;
+	std::vector<std::string> location_names(1, identifier_name);
+	for (int i = 1; i <= this->dimension; ++i)
+	{
+		char xi_name[8];
+		sprintf(xi_name, "xi%d", i);
+		location_names.push_back(xi_name);
+	}
+	this->column_names.insert(this->column_names.begin(),
+		location_names.begin(), location_names.end());
+	this->number_of_location_columns = 1 + this->dimension;
+	this->number_of_columns += this->number_of_location_columns;
+}
+
+bool Field_values_exporter::open(const char *file_nameIn)
+{
+	this->file_name = file_nameIn;
+	this->file = fopen(file_nameIn,
+		(FIELD_VALUES_EXPORT_FORMAT_BINARY == this->format) ? "wb" : "w");
+	if (!this->file)
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx export field_values:  Could not open file %s", file_nameIn);
+		return false;
+	}
+	if (FIELD_VALUES_EXPORT_FORMAT_CSV == this->format)
+	{
+		for (size_t i = 0; i < this->column_names.size(); ++i)
+		{
+			fprintf(this->file, (0 == i) ? "%s" : ",%s", this->column_names[i].c_str());
+		}
+		fprintf(this->file, "\n");
+	}
+	return true;
+}
+
+void Field_values_exporter::evaluate_chunk()
+{
+	const int number_of_locations = static_cast<int>(this->locations.size());
+	const int number_of_groups = static_cast<int>(this->group_starts.size());
+	this->group_starts.push_back(number_of_locations);
+	this->values.resize(static_cast<size_t>(number_of_locations)*this->number_of_columns);
+	const int number_of_threads = cmgui_get_number_of_threads_for_items(
+		this->get_number_of_evaluate_threads(), number_of_groups);
+	cmgui_parallel_for_ranges(number_of_groups, number_of_threads,
+		[this](int thread_index, int begin, int end)
+	{
+		cmzn_fieldcache_id field_cache = this->field_caches[thread_index];
+		const int location_end = this->group_starts[end];
+		for (int i = this->group_starts[begin]; i < location_end; ++i)
+		{
+			const Field_values_location& location = this->locations[i];
+			double *row = this->values.data() + static_cast<size_t>(i)*this->number_of_columns;
+			if (location.node)
+			{
+				cmzn_fieldcache_set_node(field_cache, location.node);
+				row[0] = static_cast<double>(cmzn_node_get_identifier(location.node));
+			}
+			else
+			{
+				cmzn_fieldcache_set_mesh_location(field_cache, location.element,
+					this->dimension, location.xi);
+				row[0] = static_cast<double>(cmzn_element_get_identifier(location.element));
+				for (int d = 0; d < this->dimension; ++d)
+					row[1 + d] = location.xi[d];
+			}
+			double *field_values = row + this->number_of_location_columns;
+			for (size_t f = 0; f < this->fields.size(); ++f)
+			{
+				const int number_of_components = this->field_components[f];
+				if (CMZN_OK != cmzn_field_evaluate_real(this->fields[f], field_cache,
+					number_of_components, field_values))
+				{
+					for (int c = 0; c < number_of_components; ++c)
+						field_values[c] = std::numeric_limits<double>::quiet_NaN();
+				}
+				field_values += number_of_components;
+			}
+		}
+	});
+}
+
+void Field_values_exporter::write_chunk()
+{
+	const size_t number_of_locations = this->locations.size();
+	if (FIELD_VALUES_EXPORT_FORMAT_BINARY == this->format)
+	{
+		if (number_of_locations*this->number_of_columns != fwrite(this->values.data(),
+			sizeof(double), number_of_locations*this->number_of_columns, this->file))
+			this->write_failed = true;
+	}
+	else
+	{
+		const double *value = this->values.data();
+		for (size_t i = 0; i < number_of_locations; ++i)
+		{
+			/* identifier */
+			fprintf(this->file, "%d", static_cast<int>(*value));
+			++value;
+			for (int c = 1; c < this->number_of_columns; ++c)
+			{
+				fprintf(this->file, ",%.17g", *value);
+				++value;
+			}
+			if (0 > fprintf(this->file, "\n"))
+				this->write_failed = true;
+		}
+	}
+	this->number_of_rows += static_cast<long long>(number_of_locations);
+}
+
+void Field_values_exporter::clear_chunk()
+{
+	for (size_t i = 0; i < this->locations.size(); ++i)
+	{
+		if (this->locations[i].node)
+			cmzn_node_destroy(&this->locations[i].node);
+	}
+	/* each element is accessed once for its first location */
+	for (size_t g = 0; g + 1 < this->group_starts.size(); ++g)
+	{
+		Field_values_location& location = this->locations[this->group_starts[g]];
+		if (location.element)
+			cmzn_element_destroy(&location.element);
+	}
+	this->locations.clear();
+	this->group_starts.clear();
+}
+
+bool Field_values_exporter::export_nodeset(cmzn_nodeset_id nodeset, int chunk_size)
+{
+	cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(nodeset);
+	Field_values_location location;
+	location.element = 0;
+	while ((!this->write_failed) && (0 != (location.node = cmzn_nodeiterator_next(iterator))))
+	{
+		this->group_starts.push_back(static_cast<int>(this->locations.size()));
+		this->locations.push_back(location);
+		if (static_cast<int>(this->locations.size()) >= chunk_size)
+		{
+			this->evaluate_chunk();
+			this->write_chunk();
+			this->clear_chunk();
+		}
+	}
+	cmzn_nodeiterator_destroy(&iterator);
+	if (0 < this->locations.size())
+	{
+		this->evaluate_chunk();
+		this->write_chunk();
+		this->clear_chunk();
+	}
+	return !this->write_failed;
+}
+
+/**
+ * @return  true if cell-centred <xi> is inside <shape_type>; points outside the
+ * simplex parts of triangles, tetrahedra and wedges are skipped.
+ */
+bool Field_values_xi_in_shape(enum cmzn_element_shape_type shape_type,
+	const double *xi)
+{
+	switch (shape_type)
+	{
+		case CMZN_ELEMENT_SHAPE_TYPE_TRIANGLE:
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE12:
+			return (xi[0] + xi[1] <= 1.0);
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE13:
+			return (xi[0] + xi[2] <= 1.0);
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE23:
+			return (xi[1] + xi[2] <= 1.0);
+		case CMZN_ELEMENT_SHAPE_TYPE_TETRAHEDRON:
+			return (xi[0] + xi[1] + xi[2] <= 1.0);
+		default:
+			break;
+	}
+	return true;
+}
+
+bool Field_values_exporter::export_mesh(cmzn_mesh_id mesh, int divisions,
+	int chunk_size)
+{
+	int number_of_grid_points = 1;
+	for (int d = 0; d < this->dimension; ++d)
+		number_of_grid_points *= divisions;
+	cmzn_elementiterator_id iterator = cmzn_mesh_create_elementiterator(mesh);
+	cmzn_element_id element;
+	while ((!this->write_failed) && (0 != (element = cmzn_elementiterator_next(iterator))))
+	{
+		const enum cmzn_element_shape_type shape_type = cmzn_element_get_shape_type(element);
+		const int group_start = static_cast<int>(this->locations.size());
+		Field_values_location location;
+		location.node = 0;
+		location.xi[0] = location.xi[1] = location.xi[2] = 0.0;
+		for (int p = 0; p < number_of_grid_points; ++p)
+		{
+			int index = p;
+			for (int d = 0; d < this->dimension; ++d)
+			{
+				location.xi[d] = ((index % divisions) + 0.5)/divisions;
+				index /= divisions;
+			}
+			if (Field_values_xi_in_shape(shape_type, location.xi))
+			{
+				location.element = element;
+				this->locations.push_back(location);
+			}
+		}
+		if (static_cast<int>(this->locations.size()) > group_start)
+		{
+			this->group_starts.push_back(group_start);
+		}
+		else
+		{
+			cmzn_element_destroy(&element);
+		}
+		if (static_cast<int>(this->locations.size()) >= chunk_size)
+		{
+			this->evaluate_chunk();
+			this->write_chunk();
+			this->clear_chunk();
+		}
+	}
+	cmzn_elementiterator_destroy(&iterator);
+	if (0 < this->locations.size())
+	{
+		this->evaluate_chunk();
+		this->write_chunk();
+		this->clear_chunk();
+	}
+	return !this->write_failed;
+}
+
+/** @return  Copy of <text> with JSON string special characters escaped. */
+std::string Field_values_json_escape(const std::string& text)
+{
+	std::string escaped;
+	for (size_t i = 0; i < text.size(); ++i)
+	{
+		const char c = text[i];
+		if ((c == '"') || (c == '\\'))
+			escaped += '\\';
+		if (static_cast<unsigned char>(c) >= 0x20)
+			escaped += c;
+	}
+	return escaped;
+}
+
+bool Field_values_exporter::finish(const char *domain_name)
+{
+	if (!this->file)
+		return false;
+	if (0 != fclose(this->file))
+		this->write_failed = true;
+	this->file = 0;
+	if (this->write_failed)
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx export field_values:  Error writing file %s", this->file_name.c_str());
+		return false;
+	}
+	if (FIELD_VALUES_EXPORT_FORMAT_BINARY == this->format)
+	{
+		const std::string header_file_name = this->file_name + ".json";
+		FILE *header_file = fopen(header_file_name.c_str(), "w");
+		if (!header_file)
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx export field_values:  Could not open file %s", header_file_name.c_str());
+			return false;
+		}
+		const unsigned int byte_order_test = 1;
+		const bool little_endian =
+			(1 == *reinterpret_cast<const unsigned char *>(&byte_order_test));
+		fprintf(header_file, "{\n");
+		fprintf(header_file, "  \"data_file\": \"%s\",\n",
+			Field_values_json_escape(this->file_name).c_str());
+		fprintf(header_file, "  \"dtype\": \"float64\",\n");
+		fprintf(header_file, "  \"byte_order\": \"%s\",\n", little_endian ? "little" : "big");
+		fprintf(header_file, "  \"domain\": \"%s\",\n", domain_name);
+		fprintf(header_file, "  \"rows\": %lld,\n", this->number_of_rows);
+		fprintf(header_file, "  \"columns\": [");
+		for (size_t i = 0; i < this->column_names.size(); ++i)
+		{
+			fprintf(header_file, "%s\"%s\"", (0 == i) ? "" : ", ",
+				Field_values_json_escape(this->column_names[i]).c_str());
+		}
+		fprintf(header_file, "]\n}\n");
+		if (0 != fclose(header_file))
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx export field_values:  Error writing file %s", header_file_name.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+} // anonymous namespace
+
+int gfx_export_field_values(struct Parse_state *state,
+	void *dummy_to_be_modified, void *root_region_void)
+{
+	int return_code;
+	USE_PARAMETER(dummy_to_be_modified);
+	cmzn_region_id root_region = reinterpret_cast<cmzn_region_id>(root_region_void);
+	if (state && root_region)
+	{
+		char *file_name = 0;
+		int chunk_size = 65536;
+		int dimension = 0;
+		int divisions = 1;
+		int number_of_threads = 1;
+		double time = 0.0;
+		Multiple_strings field_names;
+		cmzn_region_id region = cmzn_region_access(root_region);
+		cmzn_field_group_id group = 0;
+		const char *domain_strings[] = { "nodes", "datapoints", "mesh" };
+		const char *domain_string = domain_strings[0];
+		const char *format_strings[] = { "binary", "csv" };
+		const char *format_string = format_strings[0];
+
+		Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Writes the values of fields at the nodes or datapoints of a region "
+			"or group, or at a grid of divisions^dimension cell-centred points in "
+			"each element of the mesh, one row per location. The first column is "
+			"the node or element identifier, followed by xi for mesh points, then "
+			"all field components; values that cannot be evaluated are NaN. The "
+			"binary format writes rows of float64 in native byte order to the "
+			"file with a description of the columns in FILE.json; csv writes a "
+			"header line then comma-separated rows. Locations are processed "
+			"chunk_size at a time so memory use is bounded. With threads N > 1 "
+			"(0 = number of hardware threads) each chunk of nodes or datapoints is "
+			"evaluated on N threads with one field cache each, only if all fields "
+			"are node-local, i.e. depend only on node parameters and constants; "
+			"mesh points and other fields are evaluated on one thread as element "
+			"field evaluation is not safe on several. "
+			"Dimension defaults to the highest mesh dimension.");
+		Option_table_add_int_positive_entry(option_table, "chunk_size", &chunk_size);
+		Option_table_add_int_non_negative_entry(option_table, "dimension", &dimension);
+		Option_table_add_int_positive_entry(option_table, "divisions", &divisions);
+		Option_table_add_enumerator(option_table, 3, domain_strings, &domain_string);
+		Option_table_add_multiple_strings_entry(option_table, "fields",
+			&field_names, "FIELD_NAME [& FIELD_NAME [& ...]]");
+		Option_table_add_entry(option_table, "file", &file_name,
+			(void *)1, set_name);
+		Option_table_add_enumerator(option_table, 2, format_strings, &format_string);
+		Option_table_add_region_or_group_entry(option_table, "group", &region, &group);
+		Option_table_add_int_non_negative_entry(option_table, "threads", &number_of_threads);
+		Option_table_add_double_entry(option_table, "time", &time);
+		return_code = Option_table_multi_parse(option_table, state);
+		DESTROY(Option_table)(&option_table);
+		if (return_code)
+		{
+			if (!file_name)
+			{
+				display_message(ERROR_MESSAGE, "gfx export field_values:  Must specify file name");
+				return_code = 0;
+			}
+			if (0 == field_names.number_of_strings)
+			{
+				display_message(ERROR_MESSAGE, "gfx export field_values:  Must specify fields");
+				return_code = 0;
+			}
+		}
+		if (return_code)
+		{
+			const std::chrono::steady_clock::time_point start_time =
+				std::chrono::steady_clock::now();
+			cmzn_fieldmodule_id field_module = cmzn_region_get_fieldmodule(region);
+			if (0 == number_of_threads)
+				number_of_threads = cmgui_get_default_number_of_threads();
+			Field_values_exporter exporter(field_module,
+				(0 == strcmp(format_string, "csv")) ? FIELD_VALUES_EXPORT_FORMAT_CSV :
+				FIELD_VALUES_EXPORT_FORMAT_BINARY, number_of_threads, time);
+			for (int i = 0; return_code && (i < field_names.number_of_strings); ++i)
+			{
+				if (!exporter.add_field(field_names.strings[i]))
+					return_code = 0;
+			}
+			if (return_code)
+			{
+				if (0 == strcmp(domain_string, "mesh"))
+				{
+					if (0 == dimension)
+					{
+						for (dimension = 3; 0 < dimension; --dimension)
+						{
+							cmzn_mesh_id mesh = cmzn_fieldmodule_find_mesh_by_dimension(field_module, dimension);
+							const int size = cmzn_mesh_get_size(mesh);
+							cmzn_mesh_destroy(&mesh);
+							if (0 < size)
+								break;
+						}
+					}
+					cmzn_mesh_id mesh = ((1 <= dimension) && (dimension <= 3)) ?
+						cmzn_fieldmodule_find_mesh_by_dimension(field_module, dimension) : 0;
+					if (mesh && group)
+					{
+						cmzn_field_element_group_id element_group = cmzn_field_group_get_field_element_group(group, mesh);
+						cmzn_mesh_destroy(&mesh);
+						mesh = cmzn_mesh_group_base_cast(cmzn_field_element_group_get_mesh_group(element_group));
+						cmzn_field_element_group_destroy(&element_group);
+					}
+					if (mesh || (group && (1 <= dimension) && (dimension <= 3)))
+					{
+						exporter.set_domain_dimension(dimension, "element_id");
+						return_code = exporter.open(file_name);
+						/* a group without elements writes an empty file */
+						if (return_code && mesh)
+							return_code = exporter.export_mesh(mesh, divisions, chunk_size);
+						if (return_code)
+							return_code = exporter.finish("mesh");
+						cmzn_mesh_destroy(&mesh);
+					}
+					else
+					{
+						display_message(ERROR_MESSAGE,
+							"gfx export field_values:  No mesh of dimension %d", dimension);
+						return_code = 0;
+					}
+				}
+				else
+				{
+					const bool datapoints = (0 == strcmp(domain_string, "datapoints"));
+					cmzn_nodeset_id nodeset = cmzn_fieldmodule_find_nodeset_by_field_domain_type(field_module,
+						datapoints ? CMZN_FIELD_DOMAIN_TYPE_DATAPOINTS : CMZN_FIELD_DOMAIN_TYPE_NODES);
+					if (group)
+					{
+						cmzn_field_node_group_id node_group = cmzn_field_group_get_field_node_group(group, nodeset);
+						cmzn_nodeset_destroy(&nodeset);
+						nodeset = cmzn_nodeset_group_base_cast(cmzn_field_node_group_get_nodeset_group(node_group));
+						cmzn_field_node_group_destroy(&node_group);
+					}
+					exporter.set_domain_dimension(0, datapoints ? "datapoint_id" : "node_id");
+					return_code = exporter.open(file_name);
+					/* a group without nodes writes an empty file */
+					if (return_code && nodeset)
+						return_code = exporter.export_nodeset(nodeset, chunk_size);
+					if (return_code)
+						return_code = exporter.finish(domain_string);
+					cmzn_nodeset_destroy(&nodeset);
+				}
+			}
+			if (return_code)
+			{
+				const double seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start_time).count();
+				display_message(INFORMATION_MESSAGE,
+					"gfx export field_values:  %lld rows of %d columns written to %s in %g s (%g rows/s) "
+					"on %d thread(s)\n",
+					exporter.get_number_of_rows(), exporter.get_number_of_columns(), file_name,
+					seconds, (0.0 < seconds) ? exporter.get_number_of_rows()/seconds : 0.0,
+					exporter.get_number_of_evaluate_threads());
+			}
+			cmzn_fieldmodule_destroy(&field_module);
+		}
+		if (file_name)
+		{
+			DEALLOCATE(file_name);
+		}
+		cmzn_field_group_destroy(&group);
+		cmzn_region_destroy(&region);
+	}
+	else
+	{
+		display_message(ERROR_MESSAGE, "gfx_export_field_values.  Invalid argument(s)");
+		return_code = 0;
+	}
+	return (return_code);
+}
@@ -0,0 +1,21 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (EXPORT_FIELD_VALUES_APP_H)
+#define EXPORT_FIELD_VALUES_APP_H
+
+/***************************************************************************//**
+ * Executes a GFX EXPORT FIELD_VALUES command: evaluates a list of fields over
+ * the nodes or data points of a region or group, or over a regular grid of
+ * points in each element of a mesh, and writes them with node identifiers or
+ * element identifiers and xi to a CSV file or a raw float64 file with a JSON
+ * header. Locations are processed in chunks so memory use is bounded, and
+ * each chunk may be evaluated on several threads.
+ */
+int gfx_export_field_values(struct Parse_state *state,
+	void *dummy_to_be_modified, void *root_region_void);
+
+#endif /* !defined (EXPORT_FIELD_VALUES_APP_H) */
@@ -4,9 +4,383 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
-
+#include <math.h>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldfiniteelement.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/region.h"
+#include "opencmiss/zinc/status.h"
 #include "general/enumerator_private_app.h"
 #include "finite_element/finite_element_conversion_app.h"
 
 DEFINE_DEFAULT_OPTION_TABLE_ADD_ENUMERATOR_FUNCTION(Convert_finite_elements_mode)
 
+namespace {
+
+/**
+ * Number of source elements evaluated together by the hash merge conversion,
+ * bounding the memory for their values however large the mesh is.
+ */
+const int CONVERT_ELEMENTS_CHUNK_SIZE = 1024;
+
+double Convert_elements_get_elapsed_seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Merges points whose coordinates are within a tolerance into shared nodes.
+ * Points are hashed into cubic cells of the tolerance size so only the 27
+ * cells around a point need searching, making merging linear in the number
+ * of points. The first point added becomes the node, so adding points in a
+ * fixed order gives the same nodes every time.
+ */
+class Convert_elements_node_merger
+{
+	double tolerance_squared;
+	double cell_size;
+	std::unordered_map<unsigned long long, std::vector<int> > cells;
+	std::vector<double> node_coordinates;
+
+	void get_cell(const double *coordinates, long long *cell) const
+	{
+		for (int c = 0; c < 3; ++c)
+			cell[c] = static_cast<long long>(floor(coordinates[c]/this->cell_size));
+	}
+
+	static unsigned long long get_cell_key(long long i, long long j, long long k)
+	{
+		/* mixing constants from Teschner et al. spatial hashing */
+		return (static_cast<unsigned long long>(i)*73856093ULL) ^
+			(static_cast<unsigned long long>(j)*19349663ULL) ^
+			(static_cast<unsigned long long>(k)*83492791ULL);
+	}
+
+public:
+
+	Convert_elements_node_merger(double tolerance) :
+		tolerance_squared(tolerance*tolerance),
+		cell_size((tolerance > 0.0) ? tolerance : 1.0)
+	{
+	}
+
+	/** @return  Index of the node for point at <coordinates>, added if new. */
+	int add_point(const double *coordinates)
+	{
+		long long cell[3];
+		this->get_cell(coordinates, cell);
+		int node_index = -1;
+		for (long long i = cell[0] - 1; i <= cell[0] + 1; ++i)
+			for (long long j = cell[1] - 1; j <= cell[1] + 1; ++j)
+				for (long long k = cell[2] - 1; k <= cell[2] + 1; ++k)
+				{
+					std::unordered_map<unsigned long long, std::vector<int> >::const_iterator iter =
+						this->cells.find(get_cell_key(i, j, k));
+					if (iter == this->cells.end())
+						continue;
+					const std::vector<int>& cell_nodes = iter->second;
+					for (size_t n = 0; n < cell_nodes.size(); ++n)
+					{
+						/* lowest index so hash collisions cannot change the result */
+						if ((0 <= node_index) && (node_index < cell_nodes[n]))
+							continue;
+						const double *node_coordinates = this->node_coordinates.data() + 3*cell_nodes[n];
+						double distance_squared = 0.0;
+						for (int c = 0; c < 3; ++c)
+						{
+							const double delta = coordinates[c] - node_coordinates[c];
+							distance_squared += delta*delta;
+						}
+						if (distance_squared <= this->tolerance_squared)
+							node_index = cell_nodes[n];
+					}
+				}
+		if (0 <= node_index)
+			return node_index;
+		node_index = this->get_number_of_nodes();
+		for (int c = 0; c < 3; ++c)
+			this->node_coordinates.push_back(coordinates[c]);
+		this->cells[get_cell_key(cell[0], cell[1], cell[2])].push_back(node_index);
+		return node_index;
+	}
+
+	int get_number_of_nodes() const
+	{
+		return static_cast<int>(this->node_coordinates.size()/3);
+	}
+};
+
+/**
+ * Finds or creates finite element field in <destination_field_module> with the
+ * name, components and coordinate system of <source_field>.
+ * @return  Accessed field or 0 if an incompatible field of that name exists.
+ */
+cmzn_field_id Convert_elements_get_destination_field(
+	cmzn_fieldmodule_id destination_field_module, cmzn_field_id source_field)
+{
+	char *name = cmzn_field_get_name(source_field);
+	const int number_of_components = cmzn_field_get_number_of_components(source_field);
+	cmzn_field_id field = cmzn_fieldmodule_find_field_by_name(destination_field_module, name);
+	if (field)
+	{
+		cmzn_field_finite_element_id finite_element_field = cmzn_field_cast_finite_element(field);
+		if ((!finite_element_field) ||
+			(cmzn_field_get_number_of_components(field) != number_of_components))
+		{
+			display_message(ERROR_MESSAGE, "gfx convert elements.  "
+				"Destination region has incompatible field %s", name);
+			cmzn_field_destroy(&field);
+		}
+		cmzn_field_finite_element_destroy(&finite_element_field);
+	}
+	else
+	{
+		field = cmzn_fieldmodule_create_field_finite_element(destination_field_module,
+			number_of_components);
+		cmzn_field_set_name(field, name);
+		for (int c = 1; c <= number_of_components; ++c)
+		{
+			char *component_name = cmzn_field_get_component_name(source_field, c);
+			cmzn_field_set_component_name(field, c, component_name);
+			cmzn_deallocate(component_name);
+		}
+		cmzn_field_set_coordinate_system_type(field,
+			cmzn_field_get_coordinate_system_type(source_field));
+		cmzn_field_set_coordinate_system_focus(field,
+			cmzn_field_get_coordinate_system_focus(source_field));
+		cmzn_field_set_type_coordinate(field, cmzn_field_is_type_coordinate(source_field));
+		cmzn_field_set_managed(field, true);
+	}
+	cmzn_deallocate(name);
+	return field;
+}
+
+} // anonymous namespace
+
+int finite_element_conversion_hash_merge(cmzn_region_id source_region,
+	cmzn_region_id destination_region, enum Convert_finite_elements_mode mode,
+	int number_of_fields, cmzn_field_id *fields, const Element_refinement &refinement,
+	double tolerance)
+{
+	if (!(source_region && destination_region && (0 < number_of_fields) && fields &&
+		fields[0] && (3 == cmzn_field_get_number_of_components(fields[0])) &&
+		((CONVERT_TO_FINITE_ELEMENTS_TRILINEAR == mode) ||
+			(CONVERT_TO_FINITE_ELEMENTS_TRIQUADRATIC == mode)) &&
+		(0 < refinement.count[0]) && (0 < refinement.count[1]) && (0 < refinement.count[2])))
+	{
+		display_message(ERROR_MESSAGE,
+			"finite_element_conversion_hash_merge.  Invalid argument(s)");
+		return 0;
+	}
+	const int order = (CONVERT_TO_FINITE_ELEMENTS_TRILINEAR == mode) ? 1 : 2;
+	int grid_sizes[3];
+	for (int d = 0; d < 3; ++d)
+		grid_sizes[d] = refinement.count[d]*order + 1;
+	const int points_per_element = grid_sizes[0]*grid_sizes[1]*grid_sizes[2];
+	int number_of_values = 0;
+	std::vector<int> value_offsets(number_of_fields);
+	for (int f = 0; f < number_of_fields; ++f)
+	{
+		value_offsets[f] = number_of_values;
+		number_of_values += cmzn_field_get_number_of_components(fields[f]);
+	}
+
+	/* only cube elements are converted; reject others before making anything */
+	cmzn_fieldmodule_id source_field_module = cmzn_region_get_fieldmodule(source_region);
+	cmzn_mesh_id source_mesh = cmzn_fieldmodule_find_mesh_by_dimension(source_field_module, 3);
+	std::vector<cmzn_element_id> source_elements;
+	cmzn_elementiterator_id iter = cmzn_mesh_create_elementiterator(source_mesh);
+	cmzn_element_id element;
+	int return_code = 1;
+	while (0 != (element = cmzn_elementiterator_next(iter)))
+	{
+		source_elements.push_back(element);
+		if (CMZN_ELEMENT_SHAPE_TYPE_CUBE != cmzn_element_get_shape_type(element))
+		{
+			display_message(ERROR_MESSAGE, "gfx convert elements.  Element %d is not a cube; "
+				"only cube elements can be converted with hash_merge",
+				cmzn_element_get_identifier(element));
+			return_code = 0;
+			break;
+		}
+	}
+	cmzn_elementiterator_destroy(&iter);
+	const int number_of_elements = static_cast<int>(source_elements.size());
+
+	cmzn_fieldmodule_id destination_field_module = cmzn_region_get_fieldmodule(destination_region);
+	cmzn_fieldmodule_begin_change(destination_field_module);
+	std::vector<cmzn_field_id> destination_fields(number_of_fields, static_cast<cmzn_field_id>(0));
+	for (int f = 0; (f < number_of_fields) && return_code; ++f)
+	{
+		destination_fields[f] = Convert_elements_get_destination_field(destination_field_module, fields[f]);
+		if (!destination_fields[f])
+			return_code = 0;
+	}
+	double evaluate_seconds = 0.0, merge_create_seconds = 0.0;
+	int number_of_new_elements = 0;
+	Convert_elements_node_merger node_merger(tolerance);
+	std::vector<cmzn_node_id> nodes;
+	if (return_code)
+	{
+		cmzn_nodeset_id nodeset = cmzn_fieldmodule_find_nodeset_by_field_domain_type(
+			destination_field_module, CMZN_FIELD_DOMAIN_TYPE_NODES);
+		cmzn_nodetemplate_id nodetemplate = cmzn_nodeset_create_nodetemplate(nodeset);
+		for (int f = 0; f < number_of_fields; ++f)
+			cmzn_nodetemplate_define_field(nodetemplate, destination_fields[f]);
+		cmzn_fieldcache_id destination_field_cache = cmzn_fieldmodule_create_fieldcache(destination_field_module);
+		cmzn_mesh_id mesh = cmzn_fieldmodule_find_mesh_by_dimension(destination_field_module, 3);
+		cmzn_elementtemplate_id elementtemplate = cmzn_mesh_create_elementtemplate(mesh);
+		cmzn_elementtemplate_set_element_shape_type(elementtemplate, CMZN_ELEMENT_SHAPE_TYPE_CUBE);
+		const int nodes_per_element = (order + 1)*(order + 1)*(order + 1);
+		cmzn_elementtemplate_set_number_of_nodes(elementtemplate, nodes_per_element);
+		cmzn_elementbasis_id elementbasis = cmzn_fieldmodule_create_elementbasis(destination_field_module, 3,
+			(1 == order) ? CMZN_ELEMENTBASIS_FUNCTION_TYPE_LINEAR_LAGRANGE :
+			CMZN_ELEMENTBASIS_FUNCTION_TYPE_QUADRATIC_LAGRANGE);
+		std::vector<int> local_node_indexes(nodes_per_element);
+		for (int n = 0; n < nodes_per_element; ++n)
+			local_node_indexes[n] = n + 1;
+		for (int f = 0; f < number_of_fields; ++f)
+			cmzn_elementtemplate_define_field_simple_nodal(elementtemplate, destination_fields[f],
+				/*component_number*/-1, elementbasis, nodes_per_element, local_node_indexes.data());
+		cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(source_field_module);
+		std::vector<double> values(static_cast<size_t>(CONVERT_ELEMENTS_CHUNK_SIZE)*points_per_element*number_of_values);
+		std::vector<char> element_evaluated(CONVERT_ELEMENTS_CHUNK_SIZE);
+		std::vector<int> point_nodes(points_per_element);
+		for (int chunk_start = 0; (chunk_start < number_of_elements) && return_code;
+			chunk_start += CONVERT_ELEMENTS_CHUNK_SIZE)
+		{
+			const int chunk_size = ((number_of_elements - chunk_start) < CONVERT_ELEMENTS_CHUNK_SIZE) ?
+				(number_of_elements - chunk_start) : CONVERT_ELEMENTS_CHUNK_SIZE;
+
+			/* evaluate fields at the node grid of each source element in chunk */
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			double xi[3];
+			for (int e = 0; e < chunk_size; ++e)
+			{
+				element_evaluated[e] = 1;
+				double *element_values = values.data() +
+					static_cast<size_t>(e)*points_per_element*number_of_values;
+				int p = 0;
+				for (int k = 0; k < grid_sizes[2]; ++k)
+				{
+					xi[2] = static_cast<double>(k)/static_cast<double>(grid_sizes[2] - 1);
+					for (int j = 0; j < grid_sizes[1]; ++j)
+					{
+						xi[1] = static_cast<double>(j)/static_cast<double>(grid_sizes[1] - 1);
+						for (int i = 0; i < grid_sizes[0]; ++i, ++p)
+						{
+							xi[0] = static_cast<double>(i)/static_cast<double>(grid_sizes[0] - 1);
+							cmzn_fieldcache_set_mesh_location(field_cache,
+								source_elements[chunk_start + e], 3, xi);
+							for (int f = 0; f < number_of_fields; ++f)
+							{
+								if (CMZN_OK != cmzn_field_evaluate_real(fields[f], field_cache,
+									cmzn_field_get_number_of_components(fields[f]),
+									element_values + p*number_of_values + value_offsets[f]))
+								{
+									element_evaluated[e] = 0;
+								}
+							}
+						}
+					}
+				}
+			}
+			evaluate_seconds += Convert_elements_get_elapsed_seconds(start);
+
+			/* merge coincident points and create new nodes and elements in element order */
+			start = std::chrono::steady_clock::now();
+			for (int e = 0; (e < chunk_size) && return_code; ++e)
+			{
+				if (!element_evaluated[e])
+				{
+					display_message(ERROR_MESSAGE, "gfx convert elements.  "
+						"Could not evaluate fields on element %d",
+						cmzn_element_get_identifier(source_elements[chunk_start + e]));
+					return_code = 0;
+					break;
+				}
+				const double *element_values = values.data() +
+					static_cast<size_t>(e)*points_per_element*number_of_values;
+				for (int p = 0; (p < points_per_element) && return_code; ++p)
+				{
+					const double *point_values = element_values + p*number_of_values;
+					point_nodes[p] = node_merger.add_point(point_values + value_offsets[0]);
+					if (point_nodes[p] == static_cast<int>(nodes.size()))
+					{
+						cmzn_node_id node = cmzn_nodeset_create_node(nodeset, /*identifier*/-1, nodetemplate);
+						nodes.push_back(node);
+						cmzn_fieldcache_set_node(destination_field_cache, node);
+						for (int f = 0; f < number_of_fields; ++f)
+						{
+							if (CMZN_OK != cmzn_field_assign_real(destination_fields[f], destination_field_cache,
+								cmzn_field_get_number_of_components(destination_fields[f]),
+								point_values + value_offsets[f]))
+							{
+								return_code = 0;
+							}
+						}
+					}
+				}
+				for (int c = 0; (c < refinement.count[2]) && return_code; ++c)
+					for (int b = 0; (b < refinement.count[1]) && return_code; ++b)
+						for (int a = 0; (a < refinement.count[0]) && return_code; ++a)
+						{
+							int local_node = 1;
+							for (int k = 0; k <= order; ++k)
+								for (int j = 0; j <= order; ++j)
+									for (int i = 0; i <= order; ++i, ++local_node)
+									{
+										const int p = ((c*order + k)*grid_sizes[1] + (b*order + j))*grid_sizes[0] +
+											(a*order + i);
+										cmzn_elementtemplate_set_node(elementtemplate, local_node,
+											nodes[point_nodes[p]]);
+									}
+							cmzn_element_id new_element = cmzn_mesh_create_element(mesh, /*identifier*/-1, elementtemplate);
+							if (new_element)
+								++number_of_new_elements;
+							else
+								return_code = 0;
+							cmzn_element_destroy(&new_element);
+						}
+			}
+			merge_create_seconds += Convert_elements_get_elapsed_seconds(start);
+		}
+		cmzn_fieldcache_destroy(&field_cache);
+		cmzn_elementbasis_destroy(&elementbasis);
+		cmzn_elementtemplate_destroy(&elementtemplate);
+		cmzn_mesh_destroy(&mesh);
+		cmzn_fieldcache_destroy(&destination_field_cache);
+		cmzn_nodetemplate_destroy(&nodetemplate);
+		cmzn_nodeset_destroy(&nodeset);
+	}
+	const int number_of_nodes = static_cast<int>(nodes.size());
+	for (int n = 0; n < number_of_nodes; ++n)
+		cmzn_node_destroy(&nodes[n]);
+	for (int f = 0; f < number_of_fields; ++f)
+		cmzn_field_destroy(&destination_fields[f]);
+	cmzn_fieldmodule_end_change(destination_field_module);
+	cmzn_fieldmodule_destroy(&destination_field_module);
+	for (size_t e = 0; e < source_elements.size(); ++e)
+		cmzn_element_destroy(&source_elements[e]);
+	cmzn_mesh_destroy(&source_mesh);
+	cmzn_fieldmodule_destroy(&source_field_module);
+	if (!return_code)
+	{
+		display_message(ERROR_MESSAGE, "gfx convert elements.  Failed to create converted mesh");
+		return 0;
+	}
+	display_message(INFORMATION_MESSAGE, "Converted %d elements into %d elements "
+		"with %d nodes merged from %d points\n", number_of_elements,
+		number_of_new_elements, number_of_nodes, number_of_elements*points_per_element);
+	display_message(INFORMATION_MESSAGE, "  evaluate %g s, merge nodes and create %g s\n",
+		evaluate_seconds, merge_create_seconds);
+	return 1;
+}
@@ -7,6 +7,8 @@
 #if !defined (FINITE_ELEMENT_CONVERSION_APP_H_)
 #define FINITE_ELEMENT_CONVERSION_APP_H_
 
+#include "opencmiss/zinc/types/fieldid.h"
+#include "opencmiss/zinc/types/regionid.h"
 #include "general/debug.h"
 #include "general/enumerator_app.h"
 #include "general/message.h"
@@ -15,4 +17,26 @@
 
 PROTOTYPE_OPTION_TABLE_ADD_ENUMERATOR_FUNCTION(Convert_finite_elements_mode);
 
+/**
+ * Converts <fields> on the 3-D cube elements of <source_region> to trilinear or
+ * triquadratic Lagrange elements in <destination_region>, as for Zinc's
+ * finite_element_conversion but evaluating source elements in bounded chunks
+ * and merging nodes using a spatial hash with cells of the tolerance size.
+ * As in Zinc, nodes whose values of the first, 3-component coordinate field
+ * are within <tolerance> are merged, other fields take their values from the
+ * first element using each node, and nodes and elements are created in source
+ * element order with the next free identifiers. Elements are evaluated on the
+ * calling thread as element field evaluation is not safe on several. Fails without converting if any element is not a
+ * cube, and stops at the first element the fields cannot be evaluated on.
+ * The time spent evaluating, and merging nodes and creating the mesh, is
+ * reported.
+ * @param mode  CONVERT_TO_FINITE_ELEMENTS_TRILINEAR or
+ * CONVERT_TO_FINITE_ELEMENTS_TRIQUADRATIC.
+ * @return  1 on success, 0 on failure.
+ */
+int finite_element_conversion_hash_merge(cmzn_region_id source_region,
+	cmzn_region_id destination_region, enum Convert_finite_elements_mode mode,
+	int number_of_fields, cmzn_field_id *fields, const Element_refinement &refinement,
+	double tolerance);
+
 #endif
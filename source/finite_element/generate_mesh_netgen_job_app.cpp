@@ -0,0 +1,438 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if defined (ZINC_USE_NETGEN)
+
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <utility>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldfiniteelement.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/region.h"
+#include "opencmiss/zinc/status.h"
+#include "finite_element/finite_element_mesh.hpp"
+#include "finite_element/finite_element_region.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "graphics/triangle_mesh.hpp"
+#include "mesh/cmiss_element_private.hpp"
+#include "region/cmiss_region.hpp"
+#include "finite_element/generate_mesh_netgen_job_app.hpp"
+
+namespace nglib {
+#include "nglib.h"
+}
+
+/** Input and output of one netgen run, only accessed by the worker until finished. */
+struct Generate_netgen_mesh_data
+{
+	/* surface vertex coordinates, 3 per vertex */
+	std::vector<double> surface_points;
+	/* surface triangle vertex numbers from 1, 3 per triangle */
+	std::vector<int> surface_triangles;
+	double maxh, fineness;
+	int secondorder;
+	std::string meshsize_file;
+	/* generated node coordinates, 3 per node */
+	std::vector<double> points;
+	/* generated element node numbers from 1, nodes_per_element per element */
+	std::vector<int> elements;
+	int nodes_per_element;
+	bool succeeded;
+	std::atomic<bool> finished;
+	std::chrono::steady_clock::time_point end_time;
+
+	Generate_netgen_mesh_data() :
+		maxh(0.0),
+		fineness(0.0),
+		secondorder(0),
+		nodes_per_element(4),
+		succeeded(false),
+		finished(false)
+	{
+	}
+};
+
+namespace {
+
+/* netgen has global state so only one mesher may run at a time in the process,
+ * including one still running for a cancelled job */
+std::atomic<bool> Generate_netgen_mesher_running(false);
+
+/**
+ * Runs netgen on the surface in <data>, storing the nodes and tetrahedra
+ * generated. Uses only the arrays in <data> so it is safe on a worker thread.
+ */
+void Generate_netgen_mesh_arrays(Generate_netgen_mesh_data &data)
+{
+	using namespace nglib;
+	Ng_Init();
+	Ng_Mesh *mesh = Ng_NewMesh();
+	const int number_of_surface_points = static_cast<int>(data.surface_points.size()/3);
+	for (int i = 0; i < number_of_surface_points; ++i)
+		Ng_AddPoint(mesh, &data.surface_points[static_cast<size_t>(i)*3]);
+	const int number_of_surface_triangles = static_cast<int>(data.surface_triangles.size()/3);
+	for (int i = 0; i < number_of_surface_triangles; ++i)
+		Ng_AddSurfaceElement(mesh, NG_TRIG, &data.surface_triangles[static_cast<size_t>(i)*3]);
+	Ng_Meshing_Parameters parameters;
+	parameters.maxh = data.maxh;
+	parameters.fineness = data.fineness;
+	parameters.second_order = data.secondorder;
+	if (!data.meshsize_file.empty())
+		parameters.meshsize_filename = const_cast<char *>(data.meshsize_file.c_str());
+	data.succeeded = (NG_OK == Ng_GenerateVolumeMesh(mesh, &parameters));
+	if (data.succeeded)
+	{
+		if (data.secondorder)
+			Ng_Generate_SecondOrder(mesh);
+		const int number_of_points = Ng_GetNP(mesh);
+		data.points.resize(static_cast<size_t>(number_of_points)*3);
+		for (int i = 0; i < number_of_points; ++i)
+			Ng_GetPoint(mesh, i + 1, &data.points[static_cast<size_t>(i)*3]);
+		const int number_of_elements = Ng_GetNE(mesh);
+		data.nodes_per_element = (data.secondorder) ? 10 : 4;
+		data.elements.resize(static_cast<size_t>(number_of_elements)*data.nodes_per_element);
+		int element_nodes[10];
+		for (int i = 0; (i < number_of_elements) && data.succeeded; ++i)
+		{
+			const Ng_Volume_Element_Type type = Ng_GetVolumeElement(mesh, i + 1, element_nodes);
+			if (type != ((data.secondorder) ? NG_TET10 : NG_TET))
+			{
+				data.succeeded = false;
+				break;
+			}
+			for (int n = 0; n < data.nodes_per_element; ++n)
+				data.elements[static_cast<size_t>(i)*data.nodes_per_element + n] = element_nodes[n];
+		}
+	}
+	Ng_DeleteMesh(mesh);
+	Ng_Exit();
+	data.end_time = std::chrono::steady_clock::now();
+	data.finished = true;
+	Generate_netgen_mesher_running = false;
+}
+
+/** @return  Highest node identifier in <nodeset>, or 0 if empty. */
+int Generate_netgen_get_maximum_node_identifier(cmzn_nodeset_id nodeset)
+{
+	int maximum_identifier = 0;
+	cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(nodeset);
+	cmzn_node_id node;
+	while (0 != (node = cmzn_nodeiterator_next(iterator)))
+	{
+		maximum_identifier = cmzn_node_get_identifier(node);
+		cmzn_node_destroy(&node);
+	}
+	cmzn_nodeiterator_destroy(&iterator);
+	return maximum_identifier;
+}
+
+/** @return  Highest element identifier in <mesh>, or 0 if empty. */
+int Generate_netgen_get_maximum_element_identifier(cmzn_mesh_id mesh)
+{
+	int maximum_identifier = 0;
+	cmzn_elementiterator_id iterator = cmzn_mesh_create_elementiterator(mesh);
+	cmzn_element_id element;
+	while (0 != (element = cmzn_elementiterator_next(iterator)))
+	{
+		maximum_identifier = cmzn_element_get_identifier(element);
+		cmzn_element_destroy(&element);
+	}
+	cmzn_elementiterator_destroy(&iterator);
+	return maximum_identifier;
+}
+
+/**
+ * @return  Accessed 3 component rectangular cartesian finite element field
+ * "coordinates" in <fieldmodule>, created if there is no such field.
+ */
+cmzn_field_id Generate_netgen_get_coordinate_field(cmzn_fieldmodule_id fieldmodule)
+{
+	cmzn_field_id coordinate_field = cmzn_fieldmodule_find_field_by_name(fieldmodule, "coordinates");
+	if (coordinate_field)
+	{
+		cmzn_field_finite_element_id fe_field = cmzn_field_cast_finite_element(coordinate_field);
+		if ((!fe_field) ||
+			(3 != cmzn_field_get_number_of_components(coordinate_field)) ||
+			(!cmzn_field_is_type_coordinate(coordinate_field)) ||
+			(CMZN_FIELD_COORDINATE_SYSTEM_TYPE_RECTANGULAR_CARTESIAN !=
+				cmzn_field_get_coordinate_system_type(coordinate_field)))
+		{
+			cmzn_field_destroy(&coordinate_field);
+		}
+		cmzn_field_finite_element_destroy(&fe_field);
+	}
+	if (!coordinate_field)
+	{
+		coordinate_field = cmzn_fieldmodule_create_field_finite_element(fieldmodule, 3);
+		cmzn_field_set_name(coordinate_field, "coordinates");
+		cmzn_field_set_component_name(coordinate_field, 1, "x");
+		cmzn_field_set_component_name(coordinate_field, 2, "y");
+		cmzn_field_set_component_name(coordinate_field, 3, "z");
+		cmzn_field_set_managed(coordinate_field, true);
+		cmzn_field_set_type_coordinate(coordinate_field, true);
+	}
+	return coordinate_field;
+}
+
+}
+
+Generate_netgen_job::Generate_netgen_job(cmzn_region_id region,
+	const Triangle_mesh &triangle_mesh, double maxh, double fineness,
+	int secondorder, const char *meshsize_file, bool clear_region) :
+	region(cmzn_region_access(region)),
+	data(std::make_shared<Generate_netgen_mesh_data>()),
+	clear_region(clear_region),
+	cancelled(false),
+	start_time(std::chrono::steady_clock::now())
+{
+	this->data->maxh = maxh;
+	this->data->fineness = fineness;
+	this->data->secondorder = secondorder;
+	if (meshsize_file)
+		this->data->meshsize_file = meshsize_file;
+	/* number vertices from 1 in set order as netgen expects */
+	std::map<int, int> vertex_numbers;
+	double coordinates[3];
+	const Triangle_vertex_set vertex_set = triangle_mesh.get_vertex_set();
+	for (Triangle_vertex_set_const_iterator vertex_iter = vertex_set.begin(); vertex_iter != vertex_set.end(); ++vertex_iter)
+	{
+		(*vertex_iter)->get_coordinates(coordinates);
+		this->data->surface_points.insert(this->data->surface_points.end(), coordinates, coordinates + 3);
+		vertex_numbers[(*vertex_iter)->get_identifier()] = static_cast<int>(vertex_numbers.size()) + 1;
+	}
+	const Triangle_vertex *vertex[3];
+	const Mesh_triangle_list triangle_list = triangle_mesh.get_triangle_list();
+	for (Mesh_triangle_list_const_iterator triangle_iter = triangle_list.begin(); triangle_iter != triangle_list.end(); ++triangle_iter)
+	{
+		(*triangle_iter)->get_vertexes(&(vertex[0]), &(vertex[1]), &(vertex[2]));
+		for (int i = 0; i < 3; ++i)
+			this->data->surface_triangles.push_back(vertex_numbers[vertex[i]->get_identifier()]);
+	}
+}
+
+Generate_netgen_job::~Generate_netgen_job()
+{
+	if (this->worker.joinable())
+		this->worker.join();
+	cmzn_region_destroy(&this->region);
+}
+
+int Generate_netgen_job::start()
+{
+	if (!((this->region) && (0 < this->data->surface_triangles.size())) ||
+		this->worker.joinable())
+	{
+		display_message(ERROR_MESSAGE, "Generate_netgen_job::start.  Invalid arguments");
+		return 0;
+	}
+	bool mesher_running = false;
+	if (!Generate_netgen_mesher_running.compare_exchange_strong(mesher_running, true))
+	{
+		display_message(ERROR_MESSAGE, "Generate_netgen_job::start.  "
+			"A cancelled mesher is still running; try again when it has finished");
+		return 0;
+	}
+	this->start_time = std::chrono::steady_clock::now();
+	std::shared_ptr<Generate_netgen_mesh_data> worker_data = this->data;
+	this->worker = std::thread([worker_data]()
+	{
+		Generate_netgen_mesh_arrays(*worker_data);
+	});
+	return 1;
+}
+
+bool Generate_netgen_job::isFinished() const
+{
+	return this->data->finished;
+}
+
+double Generate_netgen_job::getElapsedTime() const
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - this->start_time).count();
+}
+
+int Generate_netgen_job::wait(double progress_interval)
+{
+	while (!this->data->finished)
+	{
+		const double elapsed_time = this->getElapsedTime();
+		if (0.0 < progress_interval)
+		{
+			const double sleep_time = progress_interval*(floor(elapsed_time/progress_interval) + 1.0) - elapsed_time;
+			std::this_thread::sleep_for(std::chrono::duration<double>(sleep_time));
+			if (!this->data->finished)
+				display_message(INFORMATION_MESSAGE,
+					"Tetrahedral meshing: %g s elapsed\n", floor(this->getElapsedTime() + 0.5));
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+	}
+	return this->finish();
+}
+
+/**
+ * Creates the nodes and elements generated by netgen in the region, with
+ * linear or quadratic simplex coordinates, numbered after those already there.
+ * Tetrahedra are made right-handed in xi.
+ * @return  1 on success, 0 on failure.
+ */
+int Generate_netgen_job::create_mesh()
+{
+	const Generate_netgen_mesh_data &mesh_data = *(this->data);
+	const int number_of_nodes = static_cast<int>(mesh_data.points.size()/3);
+	const int nodes_per_element = mesh_data.nodes_per_element;
+	const int number_of_elements = static_cast<int>(mesh_data.elements.size()/nodes_per_element);
+	int return_code = 1;
+	cmzn_fieldmodule_id fieldmodule = cmzn_region_get_fieldmodule(this->region);
+	cmzn_fieldmodule_begin_change(fieldmodule);
+	if (this->clear_region)
+		cmzn_region_clear_finite_elements(this->region);
+	cmzn_field_id coordinate_field = Generate_netgen_get_coordinate_field(fieldmodule);
+	cmzn_nodeset_id nodeset = cmzn_fieldmodule_find_nodeset_by_field_domain_type(
+		fieldmodule, CMZN_FIELD_DOMAIN_TYPE_NODES);
+	cmzn_mesh_id mesh = cmzn_fieldmodule_find_mesh_by_dimension(fieldmodule, 3);
+	const int node_offset = Generate_netgen_get_maximum_node_identifier(nodeset);
+	const int element_offset = Generate_netgen_get_maximum_element_identifier(mesh);
+	cmzn_nodetemplate_id nodetemplate = cmzn_nodeset_create_nodetemplate(nodeset);
+	cmzn_nodetemplate_define_field(nodetemplate, coordinate_field);
+	cmzn_fieldcache_id cache = cmzn_fieldmodule_create_fieldcache(fieldmodule);
+	std::vector<cmzn_node_id> nodes(number_of_nodes, static_cast<cmzn_node_id>(0));
+	for (int n = 0; (n < number_of_nodes) && return_code; ++n)
+	{
+		nodes[n] = cmzn_nodeset_create_node(nodeset, node_offset + n + 1, nodetemplate);
+		if ((!nodes[n]) ||
+			(CMZN_OK != cmzn_fieldcache_set_node(cache, nodes[n])) ||
+			(CMZN_OK != cmzn_field_assign_real(coordinate_field, cache, 3, &mesh_data.points[static_cast<size_t>(n)*3])))
+			return_code = 0;
+	}
+	cmzn_fieldcache_destroy(&cache);
+	cmzn_nodetemplate_destroy(&nodetemplate);
+	// establish mode which enables creation of shared faces with defineElementFaces, below
+	FE_region_begin_define_faces(cmzn_region_get_FE_region(this->region));
+	FE_mesh *fe_mesh = cmzn_mesh_get_FE_mesh_internal(mesh);
+	cmzn_elementtemplate_id elementtemplate = cmzn_mesh_create_elementtemplate(mesh);
+	cmzn_elementtemplate_set_element_shape_type(elementtemplate, CMZN_ELEMENT_SHAPE_TYPE_TETRAHEDRON);
+	cmzn_elementtemplate_set_number_of_nodes(elementtemplate, nodes_per_element);
+	cmzn_elementbasis_id elementbasis = cmzn_fieldmodule_create_elementbasis(fieldmodule, 3,
+		(10 == nodes_per_element) ? CMZN_ELEMENTBASIS_FUNCTION_TYPE_QUADRATIC_SIMPLEX :
+		CMZN_ELEMENTBASIS_FUNCTION_TYPE_LINEAR_SIMPLEX);
+	int local_node_indexes[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	cmzn_elementtemplate_define_field_simple_nodal(elementtemplate, coordinate_field,
+		/*component_number*/-1, elementbasis, nodes_per_element, local_node_indexes);
+	/* netgen orders vertices then edges 12 13 14 23 24 34; zinc simplex nodes
+	 * are in xi order: v1 e12 v2 e13 e23 v3 e14 e24 e34 v4 */
+	const int quadratic_netgen_node[10] = { 0, 4, 1, 5, 7, 2, 6, 8, 9, 3 };
+	int element_nodes[10];
+	for (int e = 0; (e < number_of_elements) && return_code; ++e)
+	{
+		for (int n = 0; n < nodes_per_element; ++n)
+			element_nodes[n] = mesh_data.elements[static_cast<size_t>(e)*nodes_per_element + n] - 1;
+		/* swap vertices 2 and 3 and their edges if left-handed */
+		const double *x0 = &mesh_data.points[static_cast<size_t>(element_nodes[0])*3];
+		double a[3][3];
+		for (int v = 0; v < 3; ++v)
+		{
+			const double *x = &mesh_data.points[static_cast<size_t>(element_nodes[v + 1])*3];
+			for (int c = 0; c < 3; ++c)
+				a[v][c] = x[c] - x0[c];
+		}
+		const double volume = a[0][0]*(a[1][1]*a[2][2] - a[1][2]*a[2][1]) -
+			a[0][1]*(a[1][0]*a[2][2] - a[1][2]*a[2][0]) + a[0][2]*(a[1][0]*a[2][1] - a[1][1]*a[2][0]);
+		if (volume < 0.0)
+		{
+			std::swap(element_nodes[1], element_nodes[2]);
+			if (10 == nodes_per_element)
+			{
+				std::swap(element_nodes[4], element_nodes[5]);
+				std::swap(element_nodes[8], element_nodes[9]);
+			}
+		}
+		for (int n = 0; n < nodes_per_element; ++n)
+		{
+			const int node_index = element_nodes[(10 == nodes_per_element) ? quadratic_netgen_node[n] : n];
+			if ((node_index < 0) || (node_index >= number_of_nodes) ||
+				(CMZN_OK != cmzn_elementtemplate_set_node(elementtemplate, n + 1, nodes[node_index])))
+			{
+				return_code = 0;
+				break;
+			}
+		}
+		if (return_code)
+		{
+			cmzn_element_id element = cmzn_mesh_create_element(mesh, element_offset + e + 1, elementtemplate);
+			if (element)
+				fe_mesh->defineElementFaces(element->getIndex());
+			else
+				return_code = 0;
+			cmzn_element_destroy(&element);
+		}
+	}
+	cmzn_elementbasis_destroy(&elementbasis);
+	cmzn_elementtemplate_destroy(&elementtemplate);
+	FE_region_end_define_faces(cmzn_region_get_FE_region(this->region));
+	for (int n = 0; n < number_of_nodes; ++n)
+		cmzn_node_destroy(&nodes[n]);
+	cmzn_mesh_destroy(&mesh);
+	cmzn_nodeset_destroy(&nodeset);
+	cmzn_field_destroy(&coordinate_field);
+	cmzn_fieldmodule_end_change(fieldmodule);
+	cmzn_fieldmodule_destroy(&fieldmodule);
+	if (!return_code)
+	{
+		display_message(ERROR_MESSAGE,
+			"Generate_netgen_job::create_mesh.  Could not create generated mesh in region");
+	}
+	return return_code;
+}
+
+int Generate_netgen_job::finish()
+{
+	if (!this->data->finished)
+	{
+		display_message(ERROR_MESSAGE, "Generate_netgen_job::finish.  Mesher has not finished");
+		return 0;
+	}
+	if (this->worker.joinable())
+		this->worker.join();
+	const double mesh_time = std::chrono::duration<double>(
+		this->data->end_time - this->start_time).count();
+	if (this->cancelled)
+	{
+		display_message(INFORMATION_MESSAGE,
+			"Tetrahedral meshing cancelled; result discarded after %g s\n", mesh_time);
+		return 1;
+	}
+	if (!this->data->succeeded)
+	{
+		display_message(ERROR_MESSAGE,
+			"Tetrahedral meshing:  Netgen failed to mesh the surface after %g s", mesh_time);
+		return 0;
+	}
+	const auto create_start = std::chrono::steady_clock::now();
+	const int return_code = this->create_mesh();
+	if (return_code)
+	{
+		display_message(INFORMATION_MESSAGE,
+			"Tetrahedral meshing: %d nodes, %d elements; meshed in %g s, created in %g s\n",
+			static_cast<int>(this->data->points.size()/3),
+			static_cast<int>(this->data->elements.size()/this->data->nodes_per_element), mesh_time,
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - create_start).count());
+	}
+	return return_code;
+}
+
+#endif /* defined (ZINC_USE_NETGEN) */
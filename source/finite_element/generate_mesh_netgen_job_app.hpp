@@ -0,0 +1,107 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (GENERATE_MESH_NETGEN_JOB_APP_HPP)
+#define GENERATE_MESH_NETGEN_JOB_APP_HPP
+
+#if defined (ZINC_USE_NETGEN)
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "opencmiss/zinc/types/regionid.h"
+
+class Triangle_mesh;
+struct Generate_netgen_mesh_data;
+
+/**
+ * Tetrahedral meshing of a triangulated surface by netgen on a worker thread.
+ * The surface is copied into plain arrays on the main thread and the worker
+ * only runs netgen on those, returning the tetrahedra as plain arrays, so it
+ * never touches Zinc objects. The nodes and elements are created in the target
+ * region by finish(), which must be called on the main thread.
+ * Netgen keeps global state and cannot be interrupted: a cancelled mesher
+ * runs to completion on its thread and no other job can start until it has
+ * finished. The job is not destroyed until then, so its worker is always
+ * joined.
+ */
+class Generate_netgen_job
+{
+	cmzn_region_id region;
+	/* shared with the worker thread */
+	std::shared_ptr<Generate_netgen_mesh_data> data;
+	bool clear_region;
+	bool cancelled;
+	std::thread worker;
+	std::chrono::steady_clock::time_point start_time;
+
+	int create_mesh();
+
+public:
+
+	/**
+	 * Copies the vertices and triangles of <triangle_mesh>, which need not
+	 * outlive the job. If <clear_region> is set, finite elements in <region> are
+	 * cleared at the same time as the new mesh is created in it.
+	 */
+	Generate_netgen_job(cmzn_region_id region, const Triangle_mesh &triangle_mesh,
+		double maxh, double fineness, int secondorder, const char *meshsize_file,
+		bool clear_region);
+
+	/**
+	 * Discards any result not yet created. Blocks until a mesher still running
+	 * has finished and joins its thread, as netgen cannot be interrupted.
+	 */
+	~Generate_netgen_job();
+
+	/**
+	 * Starts the mesher on the worker thread.
+	 * @return  1 on success, 0 if not, including if a previous mesher is still
+	 * running.
+	 */
+	int start();
+
+	/** @return  True if the mesher has finished. */
+	bool isFinished() const;
+
+	bool isCancelled() const
+	{
+		return this->cancelled;
+	}
+
+	/**
+	 * Marks the job as cancelled so its result is discarded. The mesher itself
+	 * cannot be interrupted and runs to completion on the worker thread.
+	 */
+	void cancel()
+	{
+		this->cancelled = true;
+	}
+
+	/** @return  Seconds since the job was started. */
+	double getElapsedTime() const;
+
+	/**
+	 * Blocks until the mesher has finished, reporting the elapsed time every
+	 * <progress_interval> seconds if positive, then calls finish().
+	 * @return  Result of finish().
+	 */
+	int wait(double progress_interval);
+
+	/**
+	 * Joins the finished worker thread and, unless cancelled, creates the
+	 * generated nodes and elements in the region in one change, numbering them
+	 * after those already in the region, and reports the counts and time taken.
+	 * @return  1 on success or if cancelled, 0 on failure.
+	 */
+	int finish();
+};
+
+#endif /* defined (ZINC_USE_NETGEN) */
+
+#endif /* !defined (GENERATE_MESH_NETGEN_JOB_APP_HPP) */
@@ -0,0 +1,1341 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <list>
+#include <vector>
+#include "opencmiss/zinc/differentialoperator.h"
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldfiniteelement.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/region.h"
+#include "opencmiss/zinc/status.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "general/parallel_app.hpp"
+#include "command/parser.h"
+#include "region/cmiss_region_app.h"
+#include "finite_element/mesh_location_index_app.h"
+
+namespace {
+
+/* maximum number of elements in a leaf of the hierarchy */
+const int MESH_LOCATION_INDEX_LEAF_SIZE = 4;
+
+/* maximum number of indexes kept in the cache */
+const size_t MESH_LOCATION_INDEX_CACHE_SIZE = 8;
+
+/* Gauss-Newton iteration limits for finding xi in one element */
+const int MESH_LOCATION_MAXIMUM_ITERATIONS = 20;
+const double MESH_LOCATION_XI_TOLERANCE = 1.0E-10;
+
+/* relative to the size of the mesh */
+const double MESH_LOCATION_DISTANCE_TOLERANCE = 1.0E-6;
+
+struct Mesh_location_box
+{
+	double min[3], max[3];
+};
+
+/** Internal node if left >= 0, otherwise leaf for element_order[begin, end). */
+struct Mesh_location_bvh_node
+{
+	Mesh_location_box box;
+	int left, right;
+	int begin, end;
+};
+
+/** Best location found for a point; element_index is -1 if none. */
+struct Mesh_location_result
+{
+	int element_index;
+	double xi[3];
+	double distance_squared;
+};
+
+inline double Mesh_location_box_minimum_distance_squared(
+	const Mesh_location_box& box, const double *x, int number_of_components)
+{
+	double distance_squared = 0.0;
+	for (int c = 0; c < number_of_components; ++c)
+	{
+		const double delta = (x[c] < box.min[c]) ? (box.min[c] - x[c]) :
+			((x[c] > box.max[c]) ? (x[c] - box.max[c]) : 0.0);
+		distance_squared += delta*delta;
+	}
+	return distance_squared;
+}
+
+inline double Mesh_location_box_maximum_distance_squared(
+	const Mesh_location_box& box, const double *x, int number_of_components)
+{
+	double distance_squared = 0.0;
+	for (int c = 0; c < number_of_components; ++c)
+	{
+		const double delta = std::max(fabs(x[c] - box.min[c]), fabs(box.max[c] - x[c]));
+		distance_squared += delta*delta;
+	}
+	return distance_squared;
+}
+
+inline bool Mesh_location_box_contains(const Mesh_location_box& box,
+	const double *x, int number_of_components)
+{
+	for (int c = 0; c < number_of_components; ++c)
+	{
+		if ((x[c] < box.min[c]) || (x[c] > box.max[c]))
+			return false;
+	}
+	return true;
+}
+
+/** Reduces xi so that the sum of the <count> indexed components is at most 1. */
+void Mesh_location_clamp_simplex_xi(double *xi, int index1, int index2, int index3)
+{
+	const int indexes[3] = { index1, index2, index3 };
+	const int count = (index3 < 0) ? 2 : 3;
+	for (int pass = 0; pass < count; ++pass)
+	{
+		double sum = 0.0;
+		int positive_count = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			sum += xi[indexes[i]];
+			if (0.0 < xi[indexes[i]])
+				++positive_count;
+		}
+		if ((sum <= 1.0) || (0 == positive_count))
+			break;
+		const double excess = (sum - 1.0)/positive_count;
+		for (int i = 0; i < count; ++i)
+		{
+			if (0.0 < xi[indexes[i]])
+				xi[indexes[i]] = std::max(0.0, xi[indexes[i]] - excess);
+		}
+	}
+}
+
+/** Limits xi to the unit cube, then to the simplex part of <shape_type>. */
+void Mesh_location_clamp_xi(enum cmzn_element_shape_type shape_type,
+	int dimension, double *xi)
+{
+	for (int d = 0; d < dimension; ++d)
+	{
+		if (xi[d] < 0.0)
+			xi[d] = 0.0;
+		else if (xi[d] > 1.0)
+			xi[d] = 1.0;
+	}
+	switch (shape_type)
+	{
+		case CMZN_ELEMENT_SHAPE_TYPE_TRIANGLE:
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE12:
+			Mesh_location_clamp_simplex_xi(xi, 0, 1, -1);
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE13:
+			Mesh_location_clamp_simplex_xi(xi, 0, 2, -1);
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE23:
+			Mesh_location_clamp_simplex_xi(xi, 1, 2, -1);
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_TETRAHEDRON:
+			Mesh_location_clamp_simplex_xi(xi, 0, 1, 2);
+			break;
+		default:
+			break;
+	}
+}
+
+/** Sets xi to the centroid of <shape_type>. */
+void Mesh_location_get_centre_xi(enum cmzn_element_shape_type shape_type,
+	int dimension, double *xi)
+{
+	for (int d = 0; d < dimension; ++d)
+		xi[d] = 0.5;
+	switch (shape_type)
+	{
+		case CMZN_ELEMENT_SHAPE_TYPE_TRIANGLE:
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE12:
+			xi[0] = xi[1] = 1.0/3.0;
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE13:
+			xi[0] = xi[2] = 1.0/3.0;
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_WEDGE23:
+			xi[1] = xi[2] = 1.0/3.0;
+			break;
+		case CMZN_ELEMENT_SHAPE_TYPE_TETRAHEDRON:
+			xi[0] = xi[1] = xi[2] = 0.25;
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Solves the <size> x <size> system a.x = b in place by Gaussian elimination
+ * with partial pivoting; b is replaced by x.
+ * @return  false if the matrix is singular.
+ */
+bool Mesh_location_solve_linear_system(int size, double a[3][3], double *b)
+{
+	for (int k = 0; k < size; ++k)
+	{
+		int pivot = k;
+		for (int i = k + 1; i < size; ++i)
+		{
+			if (fabs(a[i][k]) > fabs(a[pivot][k]))
+				pivot = i;
+		}
+		if (fabs(a[pivot][k]) < 1.0E-300)
+			return false;
+		if (pivot != k)
+		{
+			for (int j = 0; j < size; ++j)
+				std::swap(a[k][j], a[pivot][j]);
+			std::swap(b[k], b[pivot]);
+		}
+		for (int i = k + 1; i < size; ++i)
+		{
+			const double factor = a[i][k]/a[k][k];
+			for (int j = k; j < size; ++j)
+				a[i][j] -= factor*a[k][j];
+			b[i] -= factor*b[k];
+		}
+	}
+	for (int k = size - 1; 0 <= k; --k)
+	{
+		for (int j = k + 1; j < size; ++j)
+			b[k] -= a[k][j]*b[j];
+		b[k] /= a[k][k];
+	}
+	return true;
+}
+
+/**
+ * Field cache and chart derivative operators for evaluating the mesh field in
+ * elements on one thread. Must be created and destroyed on the main thread.
+ */
+class Mesh_location_solver
+{
+	cmzn_fieldcache_id field_cache;
+	cmzn_field_id mesh_field;
+	cmzn_differentialoperator_id derivative_operators[3];
+	int mesh_dimension, number_of_components;
+
+public:
+
+	Mesh_location_solver(cmzn_fieldmodule_id field_module, cmzn_mesh_id mesh,
+		cmzn_field_id mesh_fieldIn, double time) :
+		field_cache(cmzn_fieldmodule_create_fieldcache(field_module)),
+		mesh_field(cmzn_field_access(mesh_fieldIn)),
+		mesh_dimension(cmzn_mesh_get_dimension(mesh)),
+		number_of_components(cmzn_field_get_number_of_components(mesh_fieldIn))
+	{
+		cmzn_fieldcache_set_time(this->field_cache, time);
+		for (int d = 0; d < 3; ++d)
+		{
+			this->derivative_operators[d] = (d < this->mesh_dimension) ?
+				cmzn_mesh_get_chart_differentialoperator(mesh, /*order*/1, /*term*/d + 1) : 0;
+		}
+	}
+
+	~Mesh_location_solver()
+	{
+		for (int d = 0; d < 3; ++d)
+			cmzn_differentialoperator_destroy(&this->derivative_operators[d]);
+		cmzn_field_destroy(&this->mesh_field);
+		cmzn_fieldcache_destroy(&this->field_cache);
+	}
+
+	cmzn_fieldcache_id get_field_cache() const
+	{
+		return this->field_cache;
+	}
+
+	/** @return  true if mesh field evaluated at element xi into values. */
+	bool evaluate(cmzn_element_id element, const double *xi, double *values)
+	{
+		return (CMZN_OK == cmzn_fieldcache_set_mesh_location(this->field_cache,
+				element, this->mesh_dimension, xi)) &&
+			(CMZN_OK == cmzn_field_evaluate_real(this->mesh_field, this->field_cache,
+				this->number_of_components, values));
+	}
+
+	/**
+	 * Finds xi in <element> minimising the distance from the mesh field to
+	 * <target> by Gauss-Newton iteration from the element centre, limiting xi
+	 * to the element shape.
+	 * @return  Squared distance at the final xi, or -1 if evaluation fails.
+	 */
+	double solve(cmzn_element_id element, enum cmzn_element_shape_type shape_type,
+		const double *target, double *xi);
+};
+
+double Mesh_location_solver::solve(cmzn_element_id element,
+	enum cmzn_element_shape_type shape_type, const double *target, double *xi)
+{
+	const int dimension = this->mesh_dimension;
+	const int components = this->number_of_components;
+	double values[3], derivatives[3][3];
+	Mesh_location_get_centre_xi(shape_type, dimension, xi);
+	for (int iteration = 0; iteration < MESH_LOCATION_MAXIMUM_ITERATIONS; ++iteration)
+	{
+		if (!this->evaluate(element, xi, values))
+			return -1.0;
+		for (int d = 0; d < dimension; ++d)
+		{
+			if (CMZN_OK != cmzn_field_evaluate_derivative(this->mesh_field,
+				this->derivative_operators[d], this->field_cache, components, derivatives[d]))
+				return -1.0;
+		}
+		/* normal equations J^T.J dxi = J^T.(target - values) */
+		double a[3][3], b[3];
+		for (int i = 0; i < dimension; ++i)
+		{
+			b[i] = 0.0;
+			for (int c = 0; c < components; ++c)
+				b[i] += derivatives[i][c]*(target[c] - values[c]);
+			for (int j = 0; j < dimension; ++j)
+			{
+				a[i][j] = 0.0;
+				for (int c = 0; c < components; ++c)
+					a[i][j] += derivatives[i][c]*derivatives[j][c];
+			}
+		}
+		if (!Mesh_location_solve_linear_system(dimension, a, b))
+			break;
+		double new_xi[3];
+		for (int d = 0; d < dimension; ++d)
+			new_xi[d] = xi[d] + b[d];
+		Mesh_location_clamp_xi(shape_type, dimension, new_xi);
+		double step = 0.0;
+		for (int d = 0; d < dimension; ++d)
+		{
+			step = std::max(step, fabs(new_xi[d] - xi[d]));
+			xi[d] = new_xi[d];
+		}
+		if (step < MESH_LOCATION_XI_TOLERANCE)
+			break;
+	}
+	if (!this->evaluate(element, xi, values))
+		return -1.0;
+	double distance_squared = 0.0;
+	for (int c = 0; c < components; ++c)
+		distance_squared += (target[c] - values[c])*(target[c] - values[c]);
+	return distance_squared;
+}
+
+/**
+ * Bounding volume hierarchy over the elements of a mesh in the space of a
+ * mesh_field with 1 to 3 components. Element boxes are found by sampling the
+ * field on a grid including the element boundaries, then padded to allow for
+ * curvature between samples. A field module notifier clears the index,
+ * releasing its elements, when the mesh_field or the mesh change.
+ */
+class Mesh_location_index
+{
+	cmzn_fieldmodule_id field_module;
+	cmzn_mesh_id mesh;
+	cmzn_field_id mesh_field;
+	cmzn_field_id mesh_group_field; /* element group field if mesh is a group */
+	cmzn_fieldmodulenotifier_id notifier;
+	double time;
+	int sample_divisions;
+	bool valid;
+	int mesh_dimension, number_of_components;
+	double distance_tolerance;
+	std::vector<cmzn_element_id> elements;
+	std::vector<enum cmzn_element_shape_type> shape_types;
+	std::vector<Mesh_location_box> element_boxes;
+	std::vector<int> element_order;
+	std::vector<Mesh_location_bvh_node> nodes;
+
+	static void field_module_callback(cmzn_fieldmoduleevent_id event,
+		void *index_void);
+
+	void clear();
+
+	int build_node(int begin, int end);
+
+	void find_exact_candidates(const double *x, std::vector<int>& candidates) const;
+
+	void find_nearest_candidates(const double *x, std::vector<int>& candidates) const;
+
+public:
+
+	Mesh_location_index(cmzn_fieldmodule_id field_moduleIn, cmzn_mesh_id meshIn,
+		cmzn_field_id mesh_fieldIn, double timeIn, int sample_divisionsIn);
+
+	~Mesh_location_index();
+
+	/** Fields belong to one region, so matching mesh_field implies the region. */
+	bool matches(cmzn_mesh_id meshIn, cmzn_field_id mesh_fieldIn, double timeIn,
+		int sample_divisionsIn) const
+	{
+		return (this->mesh_field == mesh_fieldIn) && (this->time == timeIn) &&
+			(this->sample_divisions == sample_divisionsIn) &&
+			cmzn_mesh_match(this->mesh, meshIn);
+	}
+
+	bool is_valid() const
+	{
+		return this->valid;
+	}
+
+	/** @return  True if the index's region is <root_region> or in its tree. */
+	bool is_in_region_tree(cmzn_region_id root_region) const
+	{
+		cmzn_region_id region = cmzn_fieldmodule_get_region(this->field_module);
+		const bool result = cmzn_region_contains_subregion(root_region, region);
+		cmzn_region_destroy(&region);
+		return result;
+	}
+
+	/** Samples element boxes on <number_of_threads> and builds the hierarchy. */
+	bool build(int number_of_threads);
+
+	int get_number_of_elements() const
+	{
+		return static_cast<int>(this->elements.size());
+	}
+
+	int get_mesh_dimension() const
+	{
+		return this->mesh_dimension;
+	}
+
+	double get_distance_tolerance() const
+	{
+		return this->distance_tolerance;
+	}
+
+	cmzn_element_id get_element(int element_index) const
+	{
+		return this->elements[element_index];
+	}
+
+	enum cmzn_element_shape_type get_shape_type(int element_index) const
+	{
+		return this->shape_types[element_index];
+	}
+
+	/**
+	 * Gets indexes of elements which may contain the location of <x>. For exact
+	 * search these are elements whose boxes contain x; for nearest search these
+	 * are all elements whose boxes are no further away than the furthest point
+	 * of the nearest box. Safe to call from several threads.
+	 */
+	void find_candidates(const double *x, bool find_nearest,
+		std::vector<int>& candidates) const
+	{
+		candidates.clear();
+		if (this->nodes.empty())
+			return;
+		if (find_nearest)
+			this->find_nearest_candidates(x, candidates);
+		else
+			this->find_exact_candidates(x, candidates);
+	}
+};
+
+Mesh_location_index::Mesh_location_index(cmzn_fieldmodule_id field_moduleIn,
+	cmzn_mesh_id meshIn, cmzn_field_id mesh_fieldIn, double timeIn,
+	int sample_divisionsIn) :
+	field_module(cmzn_fieldmodule_access(field_moduleIn)),
+	mesh(cmzn_mesh_access(meshIn)),
+	mesh_field(cmzn_field_access(mesh_fieldIn)),
+	mesh_group_field(0),
+	notifier(cmzn_fieldmodule_create_fieldmodulenotifier(field_moduleIn)),
+	time(timeIn),
+	sample_divisions(sample_divisionsIn),
+	valid(false),
+	mesh_dimension(cmzn_mesh_get_dimension(meshIn)),
+	number_of_components(cmzn_field_get_number_of_components(mesh_fieldIn)),
+	distance_tolerance(0.0)
+{
+	cmzn_mesh_group_id mesh_group = cmzn_mesh_cast_group(meshIn);
+	if (mesh_group)
+	{
+		/* element group fields are named after their mesh e.g. GROUP.mesh2d */
+		char *mesh_name = cmzn_mesh_get_name(meshIn);
+		this->mesh_group_field = cmzn_fieldmodule_find_field_by_name(field_moduleIn, mesh_name);
+		cmzn_deallocate(mesh_name);
+		cmzn_mesh_group_destroy(&mesh_group);
+	}
+	cmzn_fieldmodulenotifier_set_callback(this->notifier,
+		Mesh_location_index::field_module_callback, static_cast<void *>(this));
+}
+
+Mesh_location_index::~Mesh_location_index()
+{
+	this->clear();
+	cmzn_fieldmodulenotifier_clear_callback(this->notifier);
+	cmzn_fieldmodulenotifier_destroy(&this->notifier);
+	cmzn_field_destroy(&this->mesh_group_field);
+	cmzn_field_destroy(&this->mesh_field);
+	cmzn_mesh_destroy(&this->mesh);
+	cmzn_fieldmodule_destroy(&this->field_module);
+}
+
+void Mesh_location_index::field_module_callback(cmzn_fieldmoduleevent_id event,
+	void *index_void)
+{
+	Mesh_location_index *index = static_cast<Mesh_location_index *>(index_void);
+	if (!(event && index && index->valid))
+		return;
+	const cmzn_field_change_flags field_change_flags = CMZN_FIELD_CHANGE_FLAG_DEFINITION |
+		CMZN_FIELD_CHANGE_FLAG_RESULT | CMZN_FIELD_CHANGE_FLAG_REMOVE;
+	if ((cmzn_fieldmoduleevent_get_field_change_flags(event, index->mesh_field) & field_change_flags) ||
+		(index->mesh_group_field &&
+			(cmzn_fieldmoduleevent_get_field_change_flags(event, index->mesh_group_field) & field_change_flags)))
+	{
+		index->clear();
+		return;
+	}
+	cmzn_mesh_id master_mesh = cmzn_mesh_get_master_mesh(index->mesh);
+	cmzn_meshchanges_id meshchanges = cmzn_fieldmoduleevent_get_meshchanges(event, master_mesh);
+	if (meshchanges)
+	{
+		if (cmzn_meshchanges_get_summary(meshchanges) & (CMZN_ELEMENT_CHANGE_FLAG_ADD |
+			CMZN_ELEMENT_CHANGE_FLAG_REMOVE | CMZN_ELEMENT_CHANGE_FLAG_DEFINITION))
+			index->clear();
+		cmzn_meshchanges_destroy(&meshchanges);
+	}
+	cmzn_mesh_destroy(&master_mesh);
+}
+
+void Mesh_location_index::clear()
+{
+	for (size_t i = 0; i < this->elements.size(); ++i)
+		cmzn_element_destroy(&this->elements[i]);
+	this->elements.clear();
+	this->shape_types.clear();
+	this->element_boxes.clear();
+	this->element_order.clear();
+	this->nodes.clear();
+	this->valid = false;
+}
+
+int Mesh_location_index::build_node(int begin, int end)
+{
+	const int node_index = static_cast<int>(this->nodes.size());
+	this->nodes.push_back(Mesh_location_bvh_node());
+	Mesh_location_bvh_node node;
+	node.left = node.right = -1;
+	node.begin = begin;
+	node.end = end;
+	double centre_min[3], centre_max[3];
+	for (int c = 0; c < this->number_of_components; ++c)
+	{
+		node.box.min[c] = centre_min[c] = std::numeric_limits<double>::max();
+		node.box.max[c] = centre_max[c] = -std::numeric_limits<double>::max();
+	}
+	for (int i = begin; i < end; ++i)
+	{
+		const Mesh_location_box& box = this->element_boxes[this->element_order[i]];
+		for (int c = 0; c < this->number_of_components; ++c)
+		{
+			node.box.min[c] = std::min(node.box.min[c], box.min[c]);
+			node.box.max[c] = std::max(node.box.max[c], box.max[c]);
+			const double centre = 0.5*(box.min[c] + box.max[c]);
+			centre_min[c] = std::min(centre_min[c], centre);
+			centre_max[c] = std::max(centre_max[c], centre);
+		}
+	}
+	if ((end - begin) > MESH_LOCATION_INDEX_LEAF_SIZE)
+	{
+		/* median split on the axis with the widest spread of box centres */
+		int axis = 0;
+		for (int c = 1; c < this->number_of_components; ++c)
+		{
+			if ((centre_max[c] - centre_min[c]) > (centre_max[axis] - centre_min[axis]))
+				axis = c;
+		}
+		const int middle = (begin + end)/2;
+		const std::vector<Mesh_location_box>& boxes = this->element_boxes;
+		std::nth_element(this->element_order.begin() + begin,
+			this->element_order.begin() + middle, this->element_order.begin() + end,
+			[&boxes, axis](int a, int b)
+		{
+			return (boxes[a].min[axis] + boxes[a].max[axis]) < (boxes[b].min[axis] + boxes[b].max[axis]);
+		});
+		node.left = this->build_node(begin, middle);
+		node.right = this->build_node(middle, end);
+	}
+	this->nodes[node_index] = node;
+	return node_index;
+}
+
+bool Mesh_location_index::build(int number_of_threads)
+{
+	this->clear();
+	if ((this->mesh_dimension < 1) || (3 < this->mesh_dimension) ||
+		(this->number_of_components < 1) || (3 < this->number_of_components))
+	{
+		display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  "
+			"Mesh field must have 1 to 3 components, and mesh dimension 1 to 3");
+		return false;
+	}
+	cmzn_elementiterator_id iterator = cmzn_mesh_create_elementiterator(this->mesh);
+	cmzn_element_id element;
+	while (0 != (element = cmzn_elementiterator_next(iterator)))
+	{
+		this->elements.push_back(element);
+		this->shape_types.push_back(cmzn_element_get_shape_type(element));
+	}
+	cmzn_elementiterator_destroy(&iterator);
+	const int number_of_elements = static_cast<int>(this->elements.size());
+	this->element_boxes.resize(number_of_elements);
+	std::vector<char> element_evaluated(number_of_elements, 0);
+	number_of_threads = cmgui_get_number_of_threads_for_items(number_of_threads, number_of_elements);
+	std::vector<Mesh_location_solver *> solvers(number_of_threads);
+	for (int t = 0; t < number_of_threads; ++t)
+		solvers[t] = new Mesh_location_solver(this->field_module, this->mesh, this->mesh_field, this->time);
+	/* each element is evaluated on only one thread */
+	cmgui_parallel_for_ranges(number_of_elements, number_of_threads,
+		[this, &solvers, &element_evaluated](int thread_index, int begin, int end)
+	{
+		Mesh_location_solver& solver = *(solvers[thread_index]);
+		const int divisions = this->sample_divisions;
+		int number_of_samples = 1;
+		for (int d = 0; d < this->mesh_dimension; ++d)
+			number_of_samples *= (divisions + 1);
+		for (int e = begin; e < end; ++e)
+		{
+			Mesh_location_box& box = this->element_boxes[e];
+			for (int c = 0; c < this->number_of_components; ++c)
+			{
+				box.min[c] = std::numeric_limits<double>::max();
+				box.max[c] = -std::numeric_limits<double>::max();
+			}
+			bool evaluated = false;
+			double xi[3] = { 0.0, 0.0, 0.0 }, values[3];
+			for (int s = 0; s < number_of_samples; ++s)
+			{
+				int index = s;
+				for (int d = 0; d < this->mesh_dimension; ++d)
+				{
+					xi[d] = static_cast<double>(index % (divisions + 1))/divisions;
+					index /= (divisions + 1);
+				}
+				Mesh_location_clamp_xi(this->shape_types[e], this->mesh_dimension, xi);
+				if (solver.evaluate(this->elements[e], xi, values))
+				{
+					evaluated = true;
+					for (int c = 0; c < this->number_of_components; ++c)
+					{
+						box.min[c] = std::min(box.min[c], values[c]);
+						box.max[c] = std::max(box.max[c], values[c]);
+					}
+				}
+			}
+			if (evaluated)
+			{
+				/* pad by one sample spacing of the largest side for curvature */
+				double size = 0.0;
+				for (int c = 0; c < this->number_of_components; ++c)
+					size = std::max(size, box.max[c] - box.min[c]);
+				const double padding = size/divisions;
+				for (int c = 0; c < this->number_of_components; ++c)
+				{
+					box.min[c] -= padding;
+					box.max[c] += padding;
+				}
+				element_evaluated[e] = 1;
+			}
+		}
+	});
+	for (int t = 0; t < number_of_threads; ++t)
+		delete solvers[t];
+	/* elements where the mesh field is not defined are never found */
+	for (int e = 0; e < number_of_elements; ++e)
+	{
+		if (element_evaluated[e])
+			this->element_order.push_back(e);
+	}
+	if (!this->element_order.empty())
+	{
+		this->build_node(0, static_cast<int>(this->element_order.size()));
+		const Mesh_location_box& root_box = this->nodes[0].box;
+		double size = 0.0;
+		for (int c = 0; c < this->number_of_components; ++c)
+			size = std::max(size, root_box.max[c] - root_box.min[c]);
+		this->distance_tolerance = MESH_LOCATION_DISTANCE_TOLERANCE*size;
+	}
+	this->valid = true;
+	return true;
+}
+
+void Mesh_location_index::find_exact_candidates(const double *x,
+	std::vector<int>& candidates) const
+{
+	int stack[64];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+	while (0 < stack_size)
+	{
+		const Mesh_location_bvh_node& node = this->nodes[stack[--stack_size]];
+		if (!Mesh_location_box_contains(node.box, x, this->number_of_components))
+			continue;
+		if (node.left < 0)
+		{
+			for (int i = node.begin; i < node.end; ++i)
+			{
+				const int element_index = this->element_order[i];
+				if (Mesh_location_box_contains(this->element_boxes[element_index], x, this->number_of_components))
+					candidates.push_back(element_index);
+			}
+		}
+		else
+		{
+			stack[stack_size++] = node.right;
+			stack[stack_size++] = node.left;
+		}
+	}
+}
+
+void Mesh_location_index::find_nearest_candidates(const double *x,
+	std::vector<int>& candidates) const
+{
+	/* the nearest location is no further than the furthest corner of any box,
+	 * so the least such bound prunes boxes which are entirely further away */
+	double bound = std::numeric_limits<double>::max();
+	int stack[64];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+	while (0 < stack_size)
+	{
+		const Mesh_location_bvh_node& node = this->nodes[stack[--stack_size]];
+		if (Mesh_location_box_minimum_distance_squared(node.box, x, this->number_of_components) > bound)
+			continue;
+		if (node.left < 0)
+		{
+			for (int i = node.begin; i < node.end; ++i)
+			{
+				const int element_index = this->element_order[i];
+				const Mesh_location_box& box = this->element_boxes[element_index];
+				if (Mesh_location_box_minimum_distance_squared(box, x, this->number_of_components) <= bound)
+				{
+					candidates.push_back(element_index);
+					bound = std::min(bound,
+						Mesh_location_box_maximum_distance_squared(box, x, this->number_of_components));
+				}
+			}
+		}
+		else
+		{
+			/* visit the nearer child first to tighten the bound sooner */
+			const double left_distance = Mesh_location_box_minimum_distance_squared(
+				this->nodes[node.left].box, x, this->number_of_components);
+			const double right_distance = Mesh_location_box_minimum_distance_squared(
+				this->nodes[node.right].box, x, this->number_of_components);
+			if (left_distance <= right_distance)
+			{
+				stack[stack_size++] = node.right;
+				stack[stack_size++] = node.left;
+			}
+			else
+			{
+				stack[stack_size++] = node.left;
+				stack[stack_size++] = node.right;
+			}
+		}
+	}
+	/* remove candidates added before the bound was tightened */
+	size_t kept = 0;
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		if (Mesh_location_box_minimum_distance_squared(this->element_boxes[candidates[i]],
+			x, this->number_of_components) <= bound)
+			candidates[kept++] = candidates[i];
+	}
+	candidates.resize(kept);
+}
+
+/**
+ * Finds locations for <number_of_points> target values of <index> number of
+ * components, in chunks. Candidate elements are found for each point on
+ * several threads, then the (point, element) pairs are grouped by element so
+ * that every element is only evaluated on one thread, since element and field
+ * cache access counts are not thread-safe. Ties go to the lowest element in
+ * iteration order, as in the unindexed search.
+ */
+void Mesh_location_index_find_locations(const Mesh_location_index& index,
+	std::vector<Mesh_location_solver *>& solvers, const std::vector<double>& targets,
+	int number_of_components, int number_of_points, bool find_nearest, int chunk_size,
+	std::vector<Mesh_location_result>& results)
+{
+	const int number_of_threads = static_cast<int>(solvers.size());
+	const int number_of_elements = index.get_number_of_elements();
+	const int dimension = index.get_mesh_dimension();
+	const double tolerance_squared = index.get_distance_tolerance()*index.get_distance_tolerance();
+	results.resize(number_of_points);
+	std::vector<std::vector<int> > thread_pairs(number_of_threads);
+	std::vector<int> element_starts, pair_points;
+	std::vector<double> pair_xi, pair_distances;
+	for (int chunk_start = 0; chunk_start < number_of_points; chunk_start += chunk_size)
+	{
+		const int chunk_end = std::min(number_of_points, chunk_start + chunk_size);
+		/* pairs stored flat as element index, point index */
+		cmgui_parallel_for_ranges(chunk_end - chunk_start,
+			cmgui_get_number_of_threads_for_items(number_of_threads, chunk_end - chunk_start),
+			[&](int thread_index, int begin, int end)
+		{
+			std::vector<int>& pairs = thread_pairs[thread_index];
+			pairs.clear();
+			std::vector<int> candidates;
+			for (int p = chunk_start + begin; p < chunk_start + end; ++p)
+			{
+				results[p].element_index = -1;
+				results[p].distance_squared = std::numeric_limits<double>::max();
+				index.find_candidates(&(targets[static_cast<size_t>(p)*number_of_components]),
+					find_nearest, candidates);
+				for (size_t i = 0; i < candidates.size(); ++i)
+				{
+					pairs.push_back(candidates[i]);
+					pairs.push_back(p);
+				}
+			}
+		});
+		/* counting sort of pairs by element, keeping point order within each */
+		element_starts.assign(number_of_elements + 1, 0);
+		for (int t = 0; t < number_of_threads; ++t)
+		{
+			const std::vector<int>& pairs = thread_pairs[t];
+			for (size_t i = 0; i < pairs.size(); i += 2)
+				++element_starts[pairs[i] + 1];
+		}
+		for (int e = 0; e < number_of_elements; ++e)
+			element_starts[e + 1] += element_starts[e];
+		const int number_of_pairs = element_starts[number_of_elements];
+		pair_points.resize(number_of_pairs);
+		std::vector<int> next(element_starts.begin(), element_starts.end() - 1);
+		for (int t = 0; t < number_of_threads; ++t)
+		{
+			const std::vector<int>& pairs = thread_pairs[t];
+			for (size_t i = 0; i < pairs.size(); i += 2)
+				pair_points[next[pairs[i]]++] = pairs[i + 1];
+		}
+		std::vector<int> active_elements;
+		for (int e = 0; e < number_of_elements; ++e)
+		{
+			if (element_starts[e + 1] > element_starts[e])
+				active_elements.push_back(e);
+		}
+		pair_xi.resize(static_cast<size_t>(number_of_pairs)*3);
+		pair_distances.resize(number_of_pairs);
+		const int number_of_active_elements = static_cast<int>(active_elements.size());
+		cmgui_parallel_for_ranges(number_of_active_elements,
+			cmgui_get_number_of_threads_for_items(number_of_threads, number_of_active_elements),
+			[&](int thread_index, int begin, int end)
+		{
+			Mesh_location_solver& solver = *(solvers[thread_index]);
+			for (int a = begin; a < end; ++a)
+			{
+				const int e = active_elements[a];
+				cmzn_element_id element = index.get_element(e);
+				const enum cmzn_element_shape_type shape_type = index.get_shape_type(e);
+				for (int i = element_starts[e]; i < element_starts[e + 1]; ++i)
+				{
+					pair_distances[i] = solver.solve(element, shape_type,
+						&(targets[static_cast<size_t>(pair_points[i])*number_of_components]),
+						&(pair_xi[static_cast<size_t>(i)*3]));
+				}
+			}
+		});
+		for (int a = 0; a < number_of_active_elements; ++a)
+		{
+			const int e = active_elements[a];
+			for (int i = element_starts[e]; i < element_starts[e + 1]; ++i)
+			{
+				const double distance_squared = pair_distances[i];
+				if (distance_squared < 0.0)
+					continue;
+				Mesh_location_result& result = results[pair_points[i]];
+				if (find_nearest ? (distance_squared < result.distance_squared) :
+					((result.element_index < 0) && (distance_squared <= tolerance_squared)))
+				{
+					result.element_index = e;
+					for (int d = 0; d < dimension; ++d)
+						result.xi[d] = pair_xi[static_cast<size_t>(i)*3 + d];
+					result.distance_squared = distance_squared;
+				}
+			}
+		}
+	}
+}
+
+} // anonymous namespace
+
+struct Mesh_location_index_cache
+{
+	cmzn_region_id root_region;
+	cmzn_regionnotifier_id regionnotifier; /* from root_region */
+	std::list<Mesh_location_index *> indexes; /* most recently used first */
+
+	Mesh_location_index_cache(cmzn_region_id root_regionIn) :
+		root_region(cmzn_region_access(root_regionIn)),
+		regionnotifier(cmzn_region_create_regionnotifier(root_regionIn))
+	{
+		cmzn_regionnotifier_set_callback(this->regionnotifier,
+			Mesh_location_index_cache::region_change, static_cast<void *>(this));
+	}
+
+	~Mesh_location_index_cache()
+	{
+		cmzn_regionnotifier_clear_callback(this->regionnotifier);
+		cmzn_regionnotifier_destroy(&this->regionnotifier);
+		for (std::list<Mesh_location_index *>::iterator iter = this->indexes.begin();
+			iter != this->indexes.end(); ++iter)
+		{
+			delete *iter;
+		}
+		cmzn_region_destroy(&this->root_region);
+	}
+
+	/** Region tree has changed: release indexes of regions no longer in it. */
+	static void region_change(cmzn_regionevent_id regionevent, void *cache_void)
+	{
+		USE_PARAMETER(regionevent);
+		Mesh_location_index_cache *cache = static_cast<Mesh_location_index_cache *>(cache_void);
+		std::list<Mesh_location_index *>::iterator iter = cache->indexes.begin();
+		while (iter != cache->indexes.end())
+		{
+			if ((*iter)->is_in_region_tree(cache->root_region))
+				++iter;
+			else
+			{
+				delete *iter;
+				iter = cache->indexes.erase(iter);
+			}
+		}
+	}
+
+	/** @return  Cached index for the arguments moved to the front, or 0 if none. */
+	Mesh_location_index *find(cmzn_mesh_id mesh, cmzn_field_id mesh_field,
+		double time, int sample_divisions)
+	{
+		for (std::list<Mesh_location_index *>::iterator iter = this->indexes.begin();
+			iter != this->indexes.end(); ++iter)
+		{
+			if ((*iter)->matches(mesh, mesh_field, time, sample_divisions))
+			{
+				Mesh_location_index *index = *iter;
+				this->indexes.erase(iter);
+				this->indexes.push_front(index);
+				return index;
+			}
+		}
+		return 0;
+	}
+
+	/** Takes ownership of <index>, discarding the least recently used. */
+	void add(Mesh_location_index *index)
+	{
+		this->indexes.push_front(index);
+		while (this->indexes.size() > MESH_LOCATION_INDEX_CACHE_SIZE)
+		{
+			delete this->indexes.back();
+			this->indexes.pop_back();
+		}
+	}
+};
+
+struct Mesh_location_index_cache *Mesh_location_index_cache_create(
+	cmzn_region_id root_region)
+{
+	if (!root_region)
+	{
+		display_message(ERROR_MESSAGE, "Mesh_location_index_cache_create.  Invalid argument(s)");
+		return 0;
+	}
+	return new Mesh_location_index_cache(root_region);
+}
+
+int Mesh_location_index_cache_destroy(
+	struct Mesh_location_index_cache **cache_address)
+{
+	if (!cache_address)
+		return 0;
+	delete *cache_address;
+	*cache_address = 0;
+	return 1;
+}
+
+int gfx_find_mesh_locations(struct Parse_state *state,
+	void *dummy_to_be_modified, void *index_cache_void)
+{
+	int return_code;
+	USE_PARAMETER(dummy_to_be_modified);
+	Mesh_location_index_cache *index_cache =
+		static_cast<Mesh_location_index_cache *>(index_cache_void);
+	if (state && index_cache)
+	{
+		char benchmark_flag = 0;
+		int chunk_size = 65536;
+		int find_nearest_flag = 0;
+		int keep_index_flag = 1;
+		char *mesh_name = 0;
+		char *mesh_field_name = 0;
+		char *mesh_location_field_name = 0;
+		char *nodeset_name = 0;
+		int number_of_threads = 1;
+		int sample_divisions = 4;
+		char *source_field_name = 0;
+		double time = 0.0;
+		cmzn_region_id region = cmzn_region_access(index_cache->root_region);
+
+		Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Finds the location in the mesh where the mesh_field equals the "
+			"source_field evaluated at each point of the nodeset, which defaults to "
+			"datapoints, and stores it in the stored mesh location field "
+			"mesh_location_field if given, defining it where needed. Option "
+			"find_exact only finds points inside the mesh; find_nearest finds the "
+			"nearest location on it. The search uses a bounding volume hierarchy "
+			"over the element extents of the mesh_field, found by sampling "
+			"sample_divisions intervals per element dimension. With keep_index "
+			"the hierarchy is kept for later commands until the mesh or mesh_field "
+			"change. Points are processed chunk_size at a time on threads N "
+			"(0 = number of hardware threads). Option benchmark repeats the search "
+			"with an unindexed find_mesh_location field and reports the time and "
+			"the number of points with matching results. The source_field "
+			"defaults to the mesh_field.");
+		Option_table_add_char_flag_entry(option_table, "benchmark", &benchmark_flag);
+		Option_table_add_int_positive_entry(option_table, "chunk_size", &chunk_size);
+		Option_table_add_switch(option_table, "find_nearest", "find_exact", &find_nearest_flag);
+		Option_table_add_switch(option_table, "keep_index", "no_keep_index", &keep_index_flag);
+		Option_table_add_string_entry(option_table, "mesh", &mesh_name,
+			" ELEMENT_GROUP_FIELD_NAME|[GROUP_REGION_NAME.]mesh1d|mesh2d|mesh3d");
+		Option_table_add_string_entry(option_table, "mesh_field", &mesh_field_name,
+			" FIELD_NAME");
+		Option_table_add_string_entry(option_table, "mesh_location_field",
+			&mesh_location_field_name, " FIELD_NAME");
+		Option_table_add_string_entry(option_table, "nodeset", &nodeset_name,
+			" NODE_GROUP_FIELD_NAME|[GROUP_REGION_NAME.]nodes|datapoints");
+		Option_table_add_set_cmzn_region(option_table, "region", index_cache->root_region, &region);
+		Option_table_add_int_positive_entry(option_table, "sample_divisions", &sample_divisions);
+		Option_table_add_string_entry(option_table, "source_field", &source_field_name,
+			" FIELD_NAME");
+		Option_table_add_int_non_negative_entry(option_table, "threads", &number_of_threads);
+		Option_table_add_double_entry(option_table, "time", &time);
+		return_code = Option_table_multi_parse(option_table, state);
+		DESTROY(Option_table)(&option_table);
+		cmzn_fieldmodule_id field_module = 0;
+		cmzn_mesh_id mesh = 0;
+		cmzn_field_id mesh_field = 0;
+		cmzn_field_id source_field = 0;
+		cmzn_field_stored_mesh_location_id mesh_location_field = 0;
+		cmzn_nodeset_id nodeset = 0;
+		if (return_code)
+		{
+			field_module = cmzn_region_get_fieldmodule(region);
+			if (mesh_name)
+			{
+				mesh = cmzn_fieldmodule_find_mesh_by_name(field_module, mesh_name);
+				if (!mesh)
+				{
+					display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  Unknown mesh %s", mesh_name);
+					return_code = 0;
+				}
+			}
+			else
+			{
+				display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  Must specify mesh");
+				return_code = 0;
+			}
+			if (mesh_field_name)
+			{
+				mesh_field = cmzn_fieldmodule_find_field_by_name(field_module, mesh_field_name);
+				if (!mesh_field)
+				{
+					display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  Unknown field %s", mesh_field_name);
+					return_code = 0;
+				}
+			}
+			else
+			{
+				display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  Must specify mesh_field");
+				return_code = 0;
+			}
+			if (source_field_name)
+			{
+				source_field = cmzn_fieldmodule_find_field_by_name(field_module, source_field_name);
+				if (!source_field)
+				{
+					display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  Unknown field %s", source_field_name);
+					return_code = 0;
+				}
+			}
+			else if (mesh_field)
+			{
+				source_field = cmzn_field_access(mesh_field);
+			}
+			if (mesh_field && source_field && (cmzn_field_get_number_of_components(mesh_field) !=
+				cmzn_field_get_number_of_components(source_field)))
+			{
+				display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  "
+					"source_field and mesh_field must have the same number of components");
+				return_code = 0;
+			}
+			const char *use_nodeset_name = (nodeset_name) ? nodeset_name : "datapoints";
+			nodeset = cmzn_fieldmodule_find_nodeset_by_name(field_module, use_nodeset_name);
+			if (!nodeset)
+			{
+				display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  Unknown nodeset %s", use_nodeset_name);
+				return_code = 0;
+			}
+			if (return_code && mesh_location_field_name)
+			{
+				cmzn_field_id field = cmzn_fieldmodule_find_field_by_name(field_module, mesh_location_field_name);
+				if (field)
+				{
+					mesh_location_field = cmzn_field_cast_stored_mesh_location(field);
+					if (!mesh_location_field)
+					{
+						display_message(ERROR_MESSAGE, "gfx find_mesh_locations:  "
+							"Field %s is not a stored mesh location field", mesh_location_field_name);
+						return_code = 0;
+					}
+				}
+				else
+				{
+					cmzn_mesh_id master_mesh = cmzn_mesh_get_master_mesh(mesh);
+					field = cmzn_fieldmodule_create_field_stored_mesh_location(field_module, master_mesh);
+					cmzn_mesh_destroy(&master_mesh);
+					cmzn_field_set_name(field, mesh_location_field_name);
+					cmzn_field_set_managed(field, true);
+					mesh_location_field = cmzn_field_cast_stored_mesh_location(field);
+				}
+				cmzn_field_destroy(&field);
+			}
+		}
+		if (return_code)
+		{
+			const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+			if (0 == number_of_threads)
+				number_of_threads = cmgui_get_default_number_of_threads();
+			Mesh_location_index *index = index_cache->find(mesh, mesh_field, time, sample_divisions);
+			Mesh_location_index *temporary_index = 0;
+			if (!index)
+			{
+				index = new Mesh_location_index(field_module, mesh, mesh_field, time, sample_divisions);
+				if (keep_index_flag)
+					index_cache->add(index);
+				else
+					temporary_index = index;
+			}
+			if (!index->is_valid())
+			{
+				if (index->build(number_of_threads))
+				{
+					const double seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - start_time).count();
+					display_message(INFORMATION_MESSAGE,
+						"gfx find_mesh_locations:  Built index of %d elements in %g s\n",
+						index->get_number_of_elements(), seconds);
+				}
+				else
+				{
+					return_code = 0;
+				}
+			}
+			if (return_code)
+			{
+				const std::chrono::steady_clock::time_point find_start_time = std::chrono::steady_clock::now();
+				std::vector<cmzn_node_id> nodes;
+				cmzn_nodeiterator_id iterator = cmzn_nodeset_create_nodeiterator(nodeset);
+				cmzn_node_id node;
+				while (0 != (node = cmzn_nodeiterator_next(iterator)))
+					nodes.push_back(node);
+				cmzn_nodeiterator_destroy(&iterator);
+				const int number_of_points = static_cast<int>(nodes.size());
+				const int number_of_components = cmzn_field_get_number_of_components(source_field);
+				const int dimension = index->get_mesh_dimension();
+				std::vector<Mesh_location_solver *> solvers(
+					cmgui_get_number_of_threads_for_items(number_of_threads, number_of_points));
+				for (size_t t = 0; t < solvers.size(); ++t)
+					solvers[t] = new Mesh_location_solver(field_module, mesh, mesh_field, time);
+				/* evaluate source values; each node is only used on one thread */
+				std::vector<double> targets(static_cast<size_t>(number_of_points)*number_of_components);
+				std::vector<char> target_evaluated(number_of_points, 0);
+				cmgui_parallel_for_ranges(number_of_points, static_cast<int>(solvers.size()),
+					[&](int thread_index, int begin, int end)
+				{
+					cmzn_fieldcache_id field_cache = solvers[thread_index]->get_field_cache();
+					for (int p = begin; p < end; ++p)
+					{
+						cmzn_fieldcache_set_node(field_cache, nodes[p]);
+						target_evaluated[p] = (CMZN_OK == cmzn_field_evaluate_real(source_field,
+							field_cache, number_of_components, &(targets[static_cast<size_t>(p)*number_of_components])));
+					}
+				});
+				std::vector<Mesh_location_result> results;
+				Mesh_location_index_find_locations(*index, solvers, targets, number_of_components,
+					number_of_points, (0 != find_nearest_flag), chunk_size, results);
+				for (size_t t = 0; t < solvers.size(); ++t)
+					delete solvers[t];
+				int number_found = 0;
+				for (int p = 0; p < number_of_points; ++p)
+				{
+					if (!target_evaluated[p])
+						results[p].element_index = -1;
+					if (0 <= results[p].element_index)
+						++number_found;
+				}
+				const double find_seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - find_start_time).count();
+				display_message(INFORMATION_MESSAGE,
+					"gfx find_mesh_locations:  %d of %d points located in %g s (%g points/s)\n",
+					number_found, number_of_points, find_seconds,
+					(0.0 < find_seconds) ? number_of_points/find_seconds : 0.0);
+				cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+				cmzn_fieldcache_set_time(field_cache, time);
+				if (mesh_location_field)
+				{
+					cmzn_field_id field = cmzn_field_stored_mesh_location_base_cast(mesh_location_field);
+					cmzn_nodeset_id master_nodeset = cmzn_nodeset_get_master_nodeset(nodeset);
+					cmzn_nodetemplate_id nodetemplate = cmzn_nodeset_create_nodetemplate(master_nodeset);
+					cmzn_nodetemplate_define_field(nodetemplate, field);
+					int number_failed = 0;
+					cmzn_fieldmodule_begin_change(field_module);
+					for (int p = 0; p < number_of_points; ++p)
+					{
+						if (0 <= results[p].element_index)
+						{
+							cmzn_fieldcache_set_node(field_cache, nodes[p]);
+							if (!cmzn_field_is_defined_at_location(field, field_cache))
+							{
+								cmzn_node_merge(nodes[p], nodetemplate);
+								cmzn_fieldcache_set_node(field_cache, nodes[p]);
+							}
+							if (CMZN_OK != cmzn_field_assign_mesh_location(field, field_cache,
+								index->get_element(results[p].element_index), dimension, results[p].xi))
+								++number_failed;
+						}
+					}
+					cmzn_fieldmodule_end_change(field_module);
+					if (0 < number_failed)
+					{
+						display_message(WARNING_MESSAGE, "gfx find_mesh_locations:  "
+							"Could not store %d locations in field %s", number_failed, mesh_location_field_name);
+					}
+					cmzn_nodetemplate_destroy(&nodetemplate);
+					cmzn_nodeset_destroy(&master_nodeset);
+				}
+				if (benchmark_flag)
+				{
+					/* unindexed search is serial as it shares one field cache */
+					cmzn_field_id find_field = cmzn_fieldmodule_create_field_find_mesh_location(
+						field_module, source_field, mesh_field, mesh);
+					cmzn_field_find_mesh_location_id find_mesh_location_field =
+						cmzn_field_cast_find_mesh_location(find_field);
+					cmzn_field_find_mesh_location_set_search_mode(find_mesh_location_field,
+						find_nearest_flag ? CMZN_FIELD_FIND_MESH_LOCATION_SEARCH_MODE_NEAREST :
+						CMZN_FIELD_FIND_MESH_LOCATION_SEARCH_MODE_EXACT);
+					cmzn_field_find_mesh_location_destroy(&find_mesh_location_field);
+					std::vector<cmzn_element_id> unindexed_elements(number_of_points, (cmzn_element_id)0);
+					std::vector<double> unindexed_xi(static_cast<size_t>(number_of_points)*3, 0.0);
+					const std::chrono::steady_clock::time_point unindexed_start_time = std::chrono::steady_clock::now();
+					for (int p = 0; p < number_of_points; ++p)
+					{
+						cmzn_fieldcache_set_node(field_cache, nodes[p]);
+						unindexed_elements[p] = cmzn_field_evaluate_mesh_location(find_field, field_cache,
+							dimension, &(unindexed_xi[static_cast<size_t>(p)*3]));
+					}
+					const double unindexed_seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - unindexed_start_time).count();
+					cmzn_field_destroy(&find_field);
+					/* results agree if both are missing, or both are the same distance
+					 * from the point within tolerance, as ties between elements sharing
+					 * a face or points equidistant from two elements may differ */
+					const double tolerance = std::max(index->get_distance_tolerance(), 1.0E-12);
+					int number_agreeing = 0;
+					double maximum_excess_distance = 0.0;
+					std::vector<double> values(number_of_components);
+					for (int p = 0; p < number_of_points; ++p)
+					{
+						const Mesh_location_result& result = results[p];
+						if ((result.element_index < 0) || (!unindexed_elements[p]))
+						{
+							if ((result.element_index < 0) && (!unindexed_elements[p]))
+								++number_agreeing;
+							continue;
+						}
+						const double indexed_distance = sqrt(result.distance_squared);
+						double unindexed_distance_squared = 0.0;
+						cmzn_fieldcache_set_mesh_location(field_cache, unindexed_elements[p],
+							dimension, &(unindexed_xi[static_cast<size_t>(p)*3]));
+						if (CMZN_OK == cmzn_field_evaluate_real(mesh_field, field_cache,
+							number_of_components, values.data()))
+						{
+							for (int c = 0; c < number_of_components; ++c)
+							{
+								const double delta = values[c] - targets[static_cast<size_t>(p)*number_of_components + c];
+								unindexed_distance_squared += delta*delta;
+							}
+						}
+						const double excess_distance = indexed_distance - sqrt(unindexed_distance_squared);
+						if (fabs(excess_distance) <= tolerance)
+							++number_agreeing;
+						if (excess_distance > maximum_excess_distance)
+							maximum_excess_distance = excess_distance;
+					}
+					display_message(INFORMATION_MESSAGE,
+						"gfx find_mesh_locations:  Unindexed search took %g s (%g points/s), "
+						"%g times the indexed search. %d of %d points agree; "
+						"indexed locations are at most %g further away.\n",
+						unindexed_seconds, (0.0 < unindexed_seconds) ? number_of_points/unindexed_seconds : 0.0,
+						(0.0 < find_seconds) ? unindexed_seconds/find_seconds : 0.0,
+						number_agreeing, number_of_points, maximum_excess_distance);
+					for (int p = 0; p < number_of_points; ++p)
+					{
+						if (unindexed_elements[p])
+							cmzn_element_destroy(&unindexed_elements[p]);
+					}
+				}
+				cmzn_fieldcache_destroy(&field_cache);
+				for (int p = 0; p < number_of_points; ++p)
+					cmzn_node_destroy(&nodes[p]);
+			}
+			delete temporary_index;
+		}
+		cmzn_nodeset_destroy(&nodeset);
+		cmzn_field_stored_mesh_location_destroy(&mesh_location_field);
+		cmzn_field_destroy(&source_field);
+		cmzn_field_destroy(&mesh_field);
+		cmzn_mesh_destroy(&mesh);
+		cmzn_fieldmodule_destroy(&field_module);
+		if (mesh_name)
+			DEALLOCATE(mesh_name);
+		if (mesh_field_name)
+			DEALLOCATE(mesh_field_name);
+		if (mesh_location_field_name)
+			DEALLOCATE(mesh_location_field_name);
+		if (nodeset_name)
+			DEALLOCATE(nodeset_name);
+		if (source_field_name)
+			DEALLOCATE(source_field_name);
+		cmzn_region_destroy(&region);
+	}
+	else
+	{
+		display_message(ERROR_MESSAGE, "gfx_find_mesh_locations.  Invalid argument(s)");
+		return_code = 0;
+	}
+	return (return_code);
+}
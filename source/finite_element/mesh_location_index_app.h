@@ -0,0 +1,42 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (MESH_LOCATION_INDEX_APP_H)
+#define MESH_LOCATION_INDEX_APP_H
+
+#include "opencmiss/zinc/types/regionid.h"
+
+/**
+ * Set of element bounding volume hierarchies kept between GFX FIND_MESH_LOCATIONS
+ * commands. Each index is cleared, releasing its elements, when the mesh or its
+ * mesh_field change and rebuilt when next used. Indexes are released when their
+ * region is removed from the tree of the root region.
+ */
+struct Mesh_location_index_cache;
+
+/** @return  New empty index cache for regions under <root_region>, or 0 on error. */
+struct Mesh_location_index_cache *Mesh_location_index_cache_create(
+	cmzn_region_id root_region);
+
+/**
+ * Destroys the cache and all its indexes. Must be called before the regions
+ * and field modules it references are destroyed.
+ */
+int Mesh_location_index_cache_destroy(
+	struct Mesh_location_index_cache **cache_address);
+
+/***************************************************************************//**
+ * Executes a GFX FIND_MESH_LOCATIONS command: finds the exact or nearest
+ * location in a mesh where the mesh_field equals the source_field at each point
+ * of a nodeset, using an element bounding volume hierarchy from
+ * <index_cache_void> and several threads, and optionally stores the locations
+ * in a stored mesh location field. A benchmark option repeats the search with
+ * an unindexed find_mesh_location field and reports timing and agreement.
+ */
+int gfx_find_mesh_locations(struct Parse_state *state,
+	void *dummy_to_be_modified, void *index_cache_void);
+
+#endif /* !defined (MESH_LOCATION_INDEX_APP_H) */
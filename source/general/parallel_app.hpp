@@ -0,0 +1,150 @@
+/**
+ * FILE : parallel_app.hpp
+ *
+ * Small helpers for spreading independent work over threads: a bounded
+ * producer/consumer queue and a deterministic range partitioner.
+ */
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#if !defined (GENERAL_PARALLEL_APP_HPP)
+#define GENERAL_PARALLEL_APP_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns the number of threads to use when a command is given threads 0,
+ * which is the number of hardware threads, or 1 if this is unknown.
+ */
+inline int cmgui_get_default_number_of_threads()
+{
+	const int number_of_threads = static_cast<int>(std::thread::hardware_concurrency());
+	return (number_of_threads > 0) ? number_of_threads : 1;
+}
+
+/**
+ * Returns the number of threads actually worth using for <number_of_items>
+ * independent items when <requested_threads> were asked for. A request of 0
+ * means use the default number of hardware threads.
+ */
+inline int cmgui_get_number_of_threads_for_items(int requested_threads,
+	int number_of_items)
+{
+	int number_of_threads = (requested_threads > 0) ? requested_threads :
+		cmgui_get_default_number_of_threads();
+	if (number_of_threads > number_of_items)
+		number_of_threads = number_of_items;
+	return (number_of_threads > 0) ? number_of_threads : 1;
+}
+
+/**
+ * Calls function(thread_index, begin, end) on <number_of_threads> threads,
+ * each receiving a contiguous half-open range of [0, number_of_items). The
+ * partition depends only on the item and thread counts, so a caller combining
+ * per-thread results in thread_index order gets the same order as a serial
+ * loop. With one thread the function is called on the calling thread.
+ */
+template <typename Range_function>
+void cmgui_parallel_for_ranges(int number_of_items, int number_of_threads,
+	Range_function function)
+{
+	if (number_of_items <= 0)
+		return;
+	if (number_of_threads > number_of_items)
+		number_of_threads = number_of_items;
+	if (number_of_threads <= 1)
+	{
+		function(0, 0, number_of_items);
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(number_of_threads - 1);
+	const int base_size = number_of_items / number_of_threads;
+	const int remainder = number_of_items % number_of_threads;
+	int begin = 0;
+	int first_end = 0;
+	for (int t = 0; t < number_of_threads; ++t)
+	{
+		const int end = begin + base_size + ((t < remainder) ? 1 : 0);
+		if (t == 0)
+			first_end = end;
+		else
+			threads.push_back(std::thread(function, t, begin, end));
+		begin = end;
+	}
+	function(0, 0, first_end);
+	for (size_t i = 0; i < threads.size(); ++i)
+		threads[i].join();
+}
+
+/**
+ * Fixed-capacity FIFO for handing work between a producer and one or more
+ * consumer threads. push() blocks while the queue is full; pop() blocks while
+ * it is empty and returns false once the queue is closed and drained.
+ */
+template <typename Item> class Cmgui_bounded_queue
+{
+	std::deque<Item> items;
+	size_t capacity;
+	bool closed;
+	std::mutex mutex;
+	std::condition_variable not_empty, not_full;
+
+public:
+
+	explicit Cmgui_bounded_queue(size_t capacityIn) :
+		capacity((capacityIn > 0) ? capacityIn : 1),
+		closed(false)
+	{
+	}
+
+	/** @return  true if item was queued, false if the queue has been closed. */
+	bool push(const Item& item)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		while ((!this->closed) && (this->items.size() >= this->capacity))
+			this->not_full.wait(lock);
+		if (this->closed)
+			return false;
+		this->items.push_back(item);
+		this->not_empty.notify_one();
+		return true;
+	}
+
+	/** @return  true if an item was taken, false if closed and empty. */
+	bool pop(Item& item)
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		while ((!this->closed) && this->items.empty())
+			this->not_empty.wait(lock);
+		if (this->items.empty())
+			return false;
+		item = this->items.front();
+		this->items.pop_front();
+		this->not_full.notify_one();
+		return true;
+	}
+
+	/** Stop accepting items; consumers finish what is already queued. */
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->closed = true;
+		this->not_empty.notify_all();
+		this->not_full.notify_all();
+	}
+
+	size_t size()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		return this->items.size();
+	}
+};
+
+#endif /* !defined (GENERAL_PARALLEL_APP_HPP) */
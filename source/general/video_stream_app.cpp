@@ -0,0 +1,289 @@
+/**
+ * FILE : video_stream_app.cpp
+ *
+ * Streams uncompressed RGB frames to a file or to the standard input of an
+ * external encoder process, as YUV4MPEG2 (Y4M) or headerless raw RGB.
+ */
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "configure/cmgui_configure.h"
+#include <errno.h>
+#include <string.h>
+#include <vector>
+#include "general/debug.h"
+#include "general/message.h"
+#include "general/video_stream_app.hpp"
+
+#if defined (WIN32_SYSTEM)
+#define video_stream_popen _popen
+#define video_stream_pclose _pclose
+#define VIDEO_STREAM_PIPE_MODE "wb"
+#else /* defined (WIN32_SYSTEM) */
+#include <signal.h>
+#include <sys/wait.h>
+#define video_stream_popen popen
+#define video_stream_pclose pclose
+#define VIDEO_STREAM_PIPE_MODE "w"
+#endif /* defined (WIN32_SYSTEM) */
+
+namespace {
+
+#if !defined (WIN32_SYSTEM)
+/* SIGPIPE is ignored while any stream to an encoder is open, so an encoder
+ * exiting early makes writes fail with EPIPE instead of killing cmgui. Streams
+ * are only created and destroyed on the main thread. */
+int Video_stream_number_of_pipes = 0;
+void (*Video_stream_previous_sigpipe_handler)(int) = SIG_DFL;
+#endif /* !defined (WIN32_SYSTEM) */
+
+void Video_stream_begin_pipe()
+{
+#if !defined (WIN32_SYSTEM)
+	if (0 == Video_stream_number_of_pipes)
+		Video_stream_previous_sigpipe_handler = signal(SIGPIPE, SIG_IGN);
+	++Video_stream_number_of_pipes;
+#endif /* !defined (WIN32_SYSTEM) */
+}
+
+void Video_stream_end_pipe()
+{
+#if !defined (WIN32_SYSTEM)
+	--Video_stream_number_of_pipes;
+	if ((0 == Video_stream_number_of_pipes) &&
+		(SIG_ERR != Video_stream_previous_sigpipe_handler))
+	{
+		signal(SIGPIPE, Video_stream_previous_sigpipe_handler);
+	}
+#endif /* !defined (WIN32_SYSTEM) */
+}
+
+/** Reports the encoder exit <status> returned by pclose if it failed. */
+void Video_stream_report_pipe_status(int status)
+{
+	if (-1 == status)
+	{
+		display_message(ERROR_MESSAGE,
+			"Video stream:  Could not get encoder command exit status: %s", strerror(errno));
+		return;
+	}
+#if defined (WIN32_SYSTEM)
+	if (0 != status)
+	{
+		display_message(ERROR_MESSAGE,
+			"Video stream:  Encoder command exited with status %d", status);
+	}
+#else /* defined (WIN32_SYSTEM) */
+	if (WIFEXITED(status))
+	{
+		const int exit_status = WEXITSTATUS(status);
+		if (127 == exit_status)
+		{
+			display_message(ERROR_MESSAGE,
+				"Video stream:  Encoder command exited with status 127; it may not have been found");
+		}
+		else if (0 != exit_status)
+		{
+			display_message(ERROR_MESSAGE,
+				"Video stream:  Encoder command exited with status %d", exit_status);
+		}
+	}
+	else if (WIFSIGNALED(status))
+	{
+		display_message(ERROR_MESSAGE,
+			"Video stream:  Encoder command terminated by signal %d", WTERMSIG(status));
+	}
+#endif /* defined (WIN32_SYSTEM) */
+}
+
+}
+
+const char *Video_stream_format_string(enum Video_stream_format format)
+{
+	switch (format)
+	{
+		case VIDEO_STREAM_FORMAT_Y4M:
+			return "y4m";
+		case VIDEO_STREAM_FORMAT_RAW_RGB:
+			return "raw_rgb";
+		case VIDEO_STREAM_FORMAT_INVALID:
+			break;
+	}
+	return 0;
+}
+
+Video_stream::Video_stream(FILE *outputIn, bool isPipeIn,
+	enum Video_stream_format formatIn, int widthIn, int heightIn,
+	int frameRateIn, int queueSize) :
+	output(outputIn),
+	is_pipe(isPipeIn),
+	format(formatIn),
+	width(widthIn),
+	height(heightIn),
+	frame_rate(frameRateIn),
+	frames_queued(0),
+	frame_queue(static_cast<size_t>(queueSize)),
+	frames_written(0),
+	write_failed(false),
+	write_error(0)
+{
+	this->writer = std::thread(&Video_stream::writer_main, this);
+}
+
+Video_stream *Video_stream::create(const char *file_name, const char *command,
+	enum Video_stream_format format, int width, int height, int frame_rate,
+	int queue_size)
+{
+	if (((0 != file_name) == (0 != command)) ||
+		(0 == Video_stream_format_string(format)) ||
+		(width <= 0) || (height <= 0) || (frame_rate <= 0) || (queue_size <= 0))
+	{
+		display_message(ERROR_MESSAGE, "Video_stream::create.  Invalid argument(s)");
+		return 0;
+	}
+	if (command)
+		Video_stream_begin_pipe();
+	FILE *output = (file_name) ? fopen(file_name, "wb") :
+		video_stream_popen(command, VIDEO_STREAM_PIPE_MODE);
+	if (!output)
+	{
+		display_message(ERROR_MESSAGE, "Video stream:  Could not open %s '%s'",
+			(file_name) ? "file" : "pipe to command", (file_name) ? file_name : command);
+		if (command)
+			Video_stream_end_pipe();
+		return 0;
+	}
+	Video_stream *stream = new Video_stream(output, (0 != command), format,
+		width, height, frame_rate, queue_size);
+	return stream;
+}
+
+Video_stream::~Video_stream()
+{
+	this->frame_queue.close();
+	this->writer.join();
+	if (this->write_failed)
+	{
+		if (EPIPE == this->write_error)
+		{
+			display_message(ERROR_MESSAGE,
+				"Video stream:  Encoder closed its input after %d frames",
+				static_cast<int>(this->frames_written));
+		}
+		else
+		{
+			display_message(ERROR_MESSAGE, "Video stream:  Writing failed after %d frames: %s",
+				static_cast<int>(this->frames_written), strerror(this->write_error));
+		}
+	}
+	if (this->is_pipe)
+	{
+		Video_stream_report_pipe_status(video_stream_pclose(this->output));
+		Video_stream_end_pipe();
+	}
+	else
+	{
+		fclose(this->output);
+	}
+}
+
+bool Video_stream::write_header()
+{
+	if (VIDEO_STREAM_FORMAT_Y4M == this->format)
+	{
+		return (0 < fprintf(this->output, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",
+			this->width, this->height, this->frame_rate));
+	}
+	return true;
+}
+
+/**
+ * Converts and writes one frame. The graphics buffer gives rows bottom first,
+ * and both output formats want the top row first. Y4M planes use the BT.601
+ * limited range conversion expected by video encoders.
+ */
+bool Video_stream::write_frame_data(const unsigned char *rgb_pixels)
+{
+	const size_t row_size = static_cast<size_t>(this->width)*3;
+	if (VIDEO_STREAM_FORMAT_RAW_RGB == this->format)
+	{
+		for (int j = this->height - 1; 0 <= j; --j)
+		{
+			if (1 != fwrite(rgb_pixels + j*row_size, row_size, 1, this->output))
+				return false;
+		}
+		return true;
+	}
+	const size_t plane_size = static_cast<size_t>(this->width)*this->height;
+	std::vector<unsigned char> planes(3*plane_size);
+	unsigned char *y_plane = &(planes[0]);
+	unsigned char *u_plane = y_plane + plane_size;
+	unsigned char *v_plane = u_plane + plane_size;
+	size_t index = 0;
+	for (int j = this->height - 1; 0 <= j; --j)
+	{
+		const unsigned char *pixel = rgb_pixels + j*row_size;
+		for (int i = 0; i < this->width; ++i, ++index, pixel += 3)
+		{
+			const int r = pixel[0], g = pixel[1], b = pixel[2];
+			y_plane[index] = static_cast<unsigned char>(( 66*r + 129*g +  25*b + 128)/256 + 16);
+			u_plane[index] = static_cast<unsigned char>((-38*r -  74*g + 112*b + 128)/256 + 128);
+			v_plane[index] = static_cast<unsigned char>((112*r -  94*g -  18*b + 128)/256 + 128);
+		}
+	}
+	return (6 == fwrite("FRAME\n", 1, 6, this->output)) &&
+		(1 == fwrite(&(planes[0]), planes.size(), 1, this->output));
+}
+
+void Video_stream::writer_main()
+{
+	errno = 0;
+	if (!this->write_header())
+	{
+		this->write_error = errno;
+		this->write_failed = true;
+	}
+	unsigned char *rgb_pixels;
+	while (this->frame_queue.pop(rgb_pixels))
+	{
+		if (!this->write_failed)
+		{
+			errno = 0;
+			if (this->write_frame_data(rgb_pixels))
+			{
+				++(this->frames_written);
+			}
+			else
+			{
+				this->write_error = errno;
+				this->write_failed = true;
+			}
+		}
+		DEALLOCATE(rgb_pixels);
+	}
+	if (!this->write_failed)
+	{
+		errno = 0;
+		if (0 != fflush(this->output))
+		{
+			this->write_error = errno;
+			this->write_failed = true;
+		}
+	}
+}
+
+int Video_stream::write_frame(unsigned char *rgb_pixels)
+{
+	if (!rgb_pixels)
+		return 0;
+	if (this->write_failed || !this->frame_queue.push(rgb_pixels))
+	{
+		DEALLOCATE(rgb_pixels);
+		return 0;
+	}
+	++(this->frames_queued);
+	return 1;
+}
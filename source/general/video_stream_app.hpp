@@ -0,0 +1,114 @@
+/**
+ * FILE : video_stream_app.hpp
+ *
+ * Streams uncompressed RGB frames to a file or to the standard input of an
+ * external encoder process, as YUV4MPEG2 (Y4M) or headerless raw RGB.
+ */
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#if !defined (GENERAL_VIDEO_STREAM_APP_HPP)
+#define GENERAL_VIDEO_STREAM_APP_HPP
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "general/parallel_app.hpp"
+
+enum Video_stream_format
+{
+	VIDEO_STREAM_FORMAT_INVALID = 0,
+	VIDEO_STREAM_FORMAT_Y4M = 1,    /* YUV4MPEG2 with 4:4:4 chroma */
+	VIDEO_STREAM_FORMAT_RAW_RGB = 2 /* rgb24 frames, top row first, no header */
+};
+
+/** @return  Static name of <format> as used in commands, or 0 if invalid. */
+const char *Video_stream_format_string(enum Video_stream_format format);
+
+/**
+ * Sink for a sequence of equally sized frames. Frames are handed over with
+ * write_frame and converted and written by a writer thread, with at most
+ * queue_size frames waiting so rendering only blocks when the consumer falls
+ * behind.
+ */
+class Video_stream
+{
+	FILE *output;
+	bool is_pipe;
+	enum Video_stream_format format;
+	int width, height, frame_rate;
+	int frames_queued; /* only accessed by the producer */
+	Cmgui_bounded_queue<unsigned char *> frame_queue;
+	std::thread writer;
+	std::atomic<int> frames_written;
+	std::atomic<bool> write_failed;
+	/* errno from the failed write, EPIPE if the encoder closed its input */
+	int write_error;
+
+	Video_stream(FILE *outputIn, bool isPipeIn, enum Video_stream_format formatIn,
+		int widthIn, int heightIn, int frameRateIn, int queueSize);
+
+	void writer_main();
+
+	bool write_header();
+
+	bool write_frame_data(const unsigned char *rgb_pixels);
+
+public:
+
+	/**
+	 * Opens a stream to <file_name>, or to the standard input of the shell
+	 * <command> if that is given instead. SIGPIPE is ignored while a stream to a
+	 * command is open so the encoder exiting early fails the stream instead of
+	 * terminating the process.
+	 * @return  New stream, or 0 with an error message on failure.
+	 */
+	static Video_stream *create(const char *file_name, const char *command,
+		enum Video_stream_format format, int width, int height, int frame_rate,
+		int queue_size);
+
+	/**
+	 * Writes any queued frames and closes the output, reporting any write error
+	 * and the exit status of the encoder command if it failed.
+	 */
+	~Video_stream();
+
+	int get_width() const
+	{
+		return this->width;
+	}
+
+	int get_height() const
+	{
+		return this->height;
+	}
+
+	enum Video_stream_format get_format() const
+	{
+		return this->format;
+	}
+
+	/**
+	 * Queues a frame of 3-component RGB pixels, bottom row first as read from
+	 * the graphics buffer, which must be width*height in size. Takes ownership
+	 * of <rgb_pixels>, allocated with ALLOCATE, in all cases.
+	 * @return  1 on success, 0 if the stream has failed.
+	 */
+	int write_frame(unsigned char *rgb_pixels);
+
+	/** @return  Number of frames accepted by write_frame. */
+	int get_number_of_frames_queued() const
+	{
+		return this->frames_queued;
+	}
+
+	/** @return  Number of frames written so far by the writer thread. */
+	int get_number_of_frames_written() const
+	{
+		return this->frames_written;
+	}
+};
+
+#endif /* !defined (GENERAL_VIDEO_STREAM_APP_HPP) */
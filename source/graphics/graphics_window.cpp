@@ -16,6 +16,7 @@ interest and set scene_viewer values directly.
 * This Source Code Form is subject to the terms of the Mozilla Public
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <chrono>
 #include <string>
 #if 1
 #include "configure/cmgui_configure.h"
@@ -113,6 +114,8 @@ Module constants
 
 
 #define TIME_STEP 0.1
+/* maximum number of offscreen buffers kept by a window for printing */
+#define GRAPHICS_WINDOW_OFFSCREEN_POOL_SIZE (4)
 static const char *axis_name[7]={"??","x","y","z","-x","-y","-z"};
 
 /*
@@ -123,6 +126,19 @@ Module types
 class wxGraphicsWindow;
 #endif /* defined (WX_USER_INTERFACE) */
 
+/**
+ * Offscreen buffer kept by a graphics window for printing.
+ */
+struct Graphics_window_offscreen_buffer
+{
+	struct Graphics_buffer_app *buffer;
+	int width, height;
+	/* set while the buffer is handed out by Graphics_window_get_offscreen_buffer */
+	int in_use;
+	/* value of the window's use counter when last handed out, for eviction */
+	unsigned int last_use;
+};
+
 struct Graphics_window
 /*******************************************************************************
 LAST MODIFIED : 8 September 2000
@@ -220,6 +236,27 @@ Contains information for a graphics window.
 	struct Time_keeper_app *time_keeper_app;
 	struct User_interface *user_interface;
 	cmzn_region_id root_region;
+	/* offscreen buffers kept for printing, reused by size across panes and
+		calls; released when the window is resized or its layout changes */
+	struct Graphics_window_offscreen_buffer
+		offscreen_pool[GRAPHICS_WINDOW_OFFSCREEN_POOL_SIZE];
+	unsigned int offscreen_pool_use_counter;
+	/* viewing area size the pooled buffers were made for */
+	int offscreen_pool_viewing_width, offscreen_pool_viewing_height;
+	/* statistics for the offscreen buffer pool, listed with the window */
+	int offscreen_buffers_created, offscreen_buffer_reuses;
+	double offscreen_buffer_create_time;
+	/* open stream receiving frames printed with the video_stream option, or NULL */
+	Video_stream *video_stream;
+	/* coordinates range of scene for view all, cached until the scene or any
+		scene filter changes; the range is for scene_range_filter */
+	int scene_range_valid;
+	double scene_range_minimum[3], scene_range_maximum[3];
+	cmzn_scenefilter_id scene_range_filter;
+	void *scenefilter_manager_callback_id;
+	/* statistics for scene range traversals, listed with the window */
+	int scene_range_traversals, scene_range_cache_hits;
+	double scene_range_traversal_time;
 	/* the number of objects accessing this window. The window cannot be removed
 		from manager unless it is 1 (ie. only the manager is accessing it) */
 	int access_count;
@@ -252,6 +289,169 @@ Prototype.
 
 
 
+/**
+ * Destroys the offscreen buffers kept by <window> for printing that are not in
+ * use. Called when the window is resized or destroyed.
+ */
+static void Graphics_window_release_offscreen_pool(struct Graphics_window *window)
+{
+	for (int i = 0; i < GRAPHICS_WINDOW_OFFSCREEN_POOL_SIZE; ++i)
+	{
+		struct Graphics_window_offscreen_buffer *entry = &(window->offscreen_pool[i]);
+		if (entry->buffer && !entry->in_use)
+		{
+			DESTROY(Graphics_buffer_app)(&(entry->buffer));
+			entry->width = 0;
+			entry->height = 0;
+		}
+	}
+}
+
+/**
+ * Returns an offscreen buffer of <width> x <height> for drawing <pane> of
+ * <window>. A free buffer of the same size from the window's pool is reused
+ * where possible, otherwise a new one compatible with the pane's buffer is
+ * created and pooled, evicting the least recently used free buffer if the
+ * pool is full. Pass it to Graphics_window_release_offscreen_buffer when
+ * finished with it.
+ */
+static struct Graphics_buffer_app *Graphics_window_get_offscreen_buffer(
+	struct Graphics_window *window, int pane, int width, int height)
+{
+	struct Graphics_window_offscreen_buffer *free_entry = 0;
+	for (int i = 0; i < GRAPHICS_WINDOW_OFFSCREEN_POOL_SIZE; ++i)
+	{
+		struct Graphics_window_offscreen_buffer *entry = &(window->offscreen_pool[i]);
+		if (!entry->in_use)
+		{
+			if (entry->buffer && (entry->width == width) && (entry->height == height))
+			{
+				entry->in_use = 1;
+				entry->last_use = ++(window->offscreen_pool_use_counter);
+				++(window->offscreen_buffer_reuses);
+				return entry->buffer;
+			}
+			/* prefer an empty slot, otherwise the least recently used buffer */
+			if (!entry->buffer)
+			{
+				if ((!free_entry) || free_entry->buffer)
+				{
+					free_entry = entry;
+				}
+			}
+			else if ((!free_entry) ||
+				(free_entry->buffer && (entry->last_use < free_entry->last_use)))
+			{
+				free_entry = entry;
+			}
+		}
+	}
+	const std::chrono::steady_clock::time_point start_time =
+		std::chrono::steady_clock::now();
+	struct Graphics_buffer_app *buffer = create_Graphics_buffer_offscreen_from_buffer(
+		width, height, /*buffer_to_match*/Scene_viewer_app_get_graphics_buffer(
+			Graphics_window_get_Scene_viewer(window, pane)));
+	window->offscreen_buffer_create_time += std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start_time).count();
+	if (buffer)
+	{
+		++(window->offscreen_buffers_created);
+		if (free_entry)
+		{
+			if (free_entry->buffer)
+			{
+				DESTROY(Graphics_buffer_app)(&(free_entry->buffer));
+			}
+			free_entry->buffer = buffer;
+			free_entry->width = width;
+			free_entry->height = height;
+			free_entry->in_use = 1;
+			free_entry->last_use = ++(window->offscreen_pool_use_counter);
+		}
+	}
+	return buffer;
+}
+
+/**
+ * Finishes with a buffer from Graphics_window_get_offscreen_buffer, returning
+ * it to the pool or destroying it if it was not pooled. Clears
+ * <buffer_address>.
+ */
+static void Graphics_window_release_offscreen_buffer(
+	struct Graphics_window *window, struct Graphics_buffer_app **buffer_address)
+{
+	if (*buffer_address)
+	{
+		for (int i = 0; i < GRAPHICS_WINDOW_OFFSCREEN_POOL_SIZE; ++i)
+		{
+			struct Graphics_window_offscreen_buffer *entry = &(window->offscreen_pool[i]);
+			if (entry->buffer == *buffer_address)
+			{
+				entry->in_use = 0;
+				*buffer_address = (struct Graphics_buffer_app *)NULL;
+				return;
+			}
+		}
+		DESTROY(Graphics_buffer_app)(buffer_address);
+	}
+}
+
+/**
+ * Scene callback marking the cached scene range of the graphics window out of
+ * date. Changes anywhere in the scene tree are reported to the top scene.
+ */
+static int Graphics_window_scene_change(struct cmzn_scene *scene,
+	void *window_void)
+{
+	USE_PARAMETER(scene);
+	struct Graphics_window *window = static_cast<struct Graphics_window *>(window_void);
+	if (window)
+	{
+		window->scene_range_valid = 0;
+	}
+	return 1;
+}
+
+/**
+ * Scene filter manager callback marking the cached scene range out of date,
+ * since changing a filter can change which graphics are visible.
+ */
+static void Graphics_window_scenefilter_manager_change(
+	struct MANAGER_MESSAGE(cmzn_scenefilter) *message, void *window_void)
+{
+	USE_PARAMETER(message);
+	struct Graphics_window *window = static_cast<struct Graphics_window *>(window_void);
+	if (window)
+	{
+		window->scene_range_valid = 0;
+	}
+}
+
+/**
+ * Changes the scene <window> refers to, moving the scene change callback used
+ * to invalidate the cached scene range.
+ */
+static void Graphics_window_set_scene_private(struct Graphics_window *window,
+	cmzn_scene *scene)
+{
+	if (scene != window->scene)
+	{
+		if (window->scene)
+		{
+			cmzn_scene_remove_callback(window->scene, Graphics_window_scene_change,
+				(void *)window);
+			cmzn_scene_destroy(&(window->scene));
+		}
+		if (scene)
+		{
+			window->scene = cmzn_scene_access(scene);
+			cmzn_scene_add_callback(window->scene, Graphics_window_scene_change,
+				(void *)window);
+		}
+		window->scene_range_valid = 0;
+	}
+}
+
 static int axis_name_to_axis_number(const char *axis_name)
 /*******************************************************************************
 LAST MODIFIED : 16 December 1997
@@ -1194,8 +1394,7 @@ Callback from wxChooser<Scene> when choice is made.
 			scene_viewer=graphics_window->scene_viewer_array[pane_no];
 			if (scene)
 			{
-				cmzn_scene_destroy(&(graphics_window->scene));
-				graphics_window->scene = cmzn_scene_access(scene);
+				Graphics_window_set_scene_private(graphics_window, scene);
 				cmzn_sceneviewer_set_scene(scene_viewer->core_scene_viewer,scene);
 				Graphics_window_update_now(graphics_window);
 			}
@@ -2089,8 +2288,7 @@ etc.) in all panes of the <window>.
 						if (scene)
 						{
 							/* maintain pointer to scene in graphics_window */
-							cmzn_scene_destroy(&(window->scene));
-							window->scene = cmzn_scene_access(scene);
+							Graphics_window_set_scene_private(window, scene);
 						}
 						if (view_all_flag)
 						{
@@ -2152,6 +2350,87 @@ etc.) in all panes of the <window>.
 	return (return_code);
 } /* modify_Graphics_window_image */
 
+/**
+ * Parser commands for recording input events received by a pane of the
+ * window to a file, and replaying them to measure interaction latency.
+ */
+static int modify_Graphics_window_input(struct Parse_state *state,
+	void *graphics_window_void, void *user_data_void)
+{
+	USE_PARAMETER(user_data_void);
+	if (!state)
+	{
+		display_message(ERROR_MESSAGE,
+			"modify_Graphics_window_input.  Invalid argument(s)");
+		return 0;
+	}
+	struct Graphics_window *graphics_window =
+		static_cast<struct Graphics_window *>(graphics_window_void);
+	char *record_file_name = 0;
+	char *replay_file_name = 0;
+	char stop_flag = 0;
+	int pane_no = (graphics_window) ? (graphics_window->current_pane + 1) : 1;
+	struct Option_table *option_table = CREATE(Option_table)();
+	Option_table_add_help(option_table,
+		"Records the mouse and key input received by a pane of the window to a "
+		"file with timestamps, together with the viewport size and view, or "
+		"stops recording. The replay option feeds a recording back through the "
+		"pane's input handling and current interactive tool as fast as possible, "
+		"performing each requested redraw immediately, then reports per-event "
+		"handler latency and frame time percentiles. Replay into a window of "
+		"the same size as the recording for picking to match.");
+	Option_table_add_int_positive_entry(option_table, "pane", &pane_no);
+	Option_table_add_entry(option_table, "record", &record_file_name,
+		(void *)1, set_name);
+	Option_table_add_entry(option_table, "replay", &replay_file_name,
+		(void *)1, set_name);
+	Option_table_add_char_flag_entry(option_table, "stop_recording", &stop_flag);
+	int return_code = Option_table_multi_parse(option_table, state);
+	DESTROY(Option_table)(&option_table);
+	if (return_code)
+	{
+		struct Scene_viewer_app *scene_viewer = 0;
+		if (!graphics_window)
+		{
+			display_message(ERROR_MESSAGE,
+				"modify_Graphics_window_input.  Missing graphics_window");
+			return_code = 0;
+		}
+		else if (!(scene_viewer = Graphics_window_get_Scene_viewer(
+			graphics_window, pane_no - 1)))
+		{
+			display_message(ERROR_MESSAGE,
+				"gfx modify window input:  Invalid pane %d", pane_no);
+			return_code = 0;
+		}
+		else
+		{
+			if (stop_flag)
+			{
+				return_code = Scene_viewer_app_stop_input_recording(scene_viewer);
+			}
+			if (return_code && replay_file_name)
+			{
+				return_code = Scene_viewer_app_replay_input(scene_viewer, replay_file_name);
+			}
+			if (return_code && record_file_name)
+			{
+				return_code = Scene_viewer_app_start_input_recording(scene_viewer,
+					record_file_name);
+			}
+		}
+	}
+	if (record_file_name)
+	{
+		DEALLOCATE(record_file_name);
+	}
+	if (replay_file_name)
+	{
+		DEALLOCATE(replay_file_name);
+	}
+	return (return_code);
+}
+
 static int modify_Graphics_window_layout(struct Parse_state *state,
 	void *graphics_window_void,void *user_data_void)
 /*******************************************************************************
@@ -3213,7 +3492,16 @@ it.
 			window->manager_change_status = MANAGER_CHANGE_NONE(Graphics_window);
 			window->graphics_buffer_package = graphics_buffer_package;
 			window->filter_module=cmzn_scenefiltermodule_access(filter_module);
-			window->scene=cmzn_scene_access(scene);
+			window->scene = (cmzn_scene *)NULL;
+			window->scene_range_valid = 0;
+			window->scene_range_filter = (cmzn_scenefilter_id)NULL;
+			window->scene_range_traversals = 0;
+			window->scene_range_cache_hits = 0;
+			window->scene_range_traversal_time = 0.0;
+			Graphics_window_set_scene_private(window, scene);
+			window->scenefilter_manager_callback_id = MANAGER_REGISTER(cmzn_scenefilter)(
+				Graphics_window_scenefilter_manager_change, (void *)window,
+				cmzn_scenefiltermodule_get_manager(filter_module));
 			window->time_keeper_app = ACCESS(Time_keeper_app)(default_time_keeper_app);
 			window->interactive_tool_manager=interactive_tool_manager;
 			window->interactive_tool=
@@ -3235,6 +3523,21 @@ it.
 			window->blending_mode = CMZN_SCENEVIEWER_BLENDING_MODE_NORMAL;
 			window->depth_of_field=0.0;
 			window->focal_depth=0.0;
+			for (int i=0;i<GRAPHICS_WINDOW_OFFSCREEN_POOL_SIZE;i++)
+			{
+				window->offscreen_pool[i].buffer=(struct Graphics_buffer_app *)NULL;
+				window->offscreen_pool[i].width=0;
+				window->offscreen_pool[i].height=0;
+				window->offscreen_pool[i].in_use=0;
+				window->offscreen_pool[i].last_use=0;
+			}
+			window->video_stream=(Video_stream *)NULL;
+			window->offscreen_pool_use_counter=0;
+			window->offscreen_pool_viewing_width=0;
+			window->offscreen_pool_viewing_height=0;
+			window->offscreen_buffers_created=0;
+			window->offscreen_buffer_reuses=0;
+			window->offscreen_buffer_create_time=0.0;
 			/* the input_mode set here is changed below */
 			window->input_mode=SCENE_VIEWER_NO_INPUT;
 			if (ALLOCATE(window_title,char,50+strlen(name)))
@@ -3929,6 +4232,18 @@ Graphics_window_destroy_CB.
 			DEALLOCATE(window->scene_viewer_array);
 		}
 #endif /* !defined (WX_USER_INTERFACE) */
+		Graphics_window_close_video_stream(window);
+		Graphics_window_release_offscreen_pool(window);
+		if (window->scenefilter_manager_callback_id)
+		{
+			MANAGER_DEREGISTER(cmzn_scenefilter)(window->scenefilter_manager_callback_id,
+				cmzn_scenefiltermodule_get_manager(window->filter_module));
+			window->scenefilter_manager_callback_id = NULL;
+		}
+		if (window->scene_range_filter)
+		{
+			cmzn_scenefilter_destroy(&window->scene_range_filter);
+		}
 		if (window->filter_module)
 		{
 			cmzn_scenefiltermodule_destroy(&window->filter_module);
@@ -3949,7 +4264,7 @@ Graphics_window_destroy_CB.
 		gtk_widget_destroy (window->shell_window);
 #endif /* switch (USER_INTERFACE) */
 		/* no longer accessing scene */
-		cmzn_scene_destroy(&(window->scene));
+		Graphics_window_set_scene_private(window, (cmzn_scene *)NULL);
 		/* Time keeper callback will be removed throught the destructor of
 			 the wx_graphics_window along with the scene viewer so that
 			 whenever user closes the window, the scene viewer and the
@@ -4408,6 +4723,8 @@ Sets the layout mode in effect on the <window>.
 	if (window&&window->scene_viewer_array)
 	{
 		return_code=1;
+		/* pane sizes change with the layout */
+		Graphics_window_release_offscreen_pool(window);
 		new_number_of_panes =
 			Graphics_window_layout_mode_get_number_of_panes(layout_mode);
 		if (new_number_of_panes > window->number_of_scene_viewers)
@@ -5441,6 +5758,15 @@ graphics window on screen.
 		double frame_split_ration = 1.0;
 		Graphics_window_get_viewing_area_size(window, &panel_width,
 			&panel_height);
+		/* tile sizes follow the window size, so pooled buffers made for another
+			size are released rather than left to age out */
+		if ((panel_width != window->offscreen_pool_viewing_width) ||
+			(panel_height != window->offscreen_pool_viewing_height))
+		{
+			Graphics_window_release_offscreen_pool(window);
+			window->offscreen_pool_viewing_width = panel_width;
+			window->offscreen_pool_viewing_height = panel_height;
+		}
 		antialias = preferred_antialias;
 		if (antialias == -1)
 		{
@@ -5531,9 +5857,8 @@ graphics window on screen.
 				tiles_down = (int)ceil(fraction_down);
 			}
 
-			if (!(offscreen_buffer = create_Graphics_buffer_offscreen_from_buffer(
-				  tile_width, tile_height, /*buffer_to_match*/Scene_viewer_app_get_graphics_buffer(
-				  Graphics_window_get_Scene_viewer(window, 0)))))
+			if (!(offscreen_buffer = Graphics_window_get_offscreen_buffer(
+				window, /*pane*/0, tile_width, tile_height)))
 			{
 				force_onscreen = 1;
 			}
@@ -5564,9 +5889,8 @@ graphics window on screen.
 					}
 					else
 					{
-						current_buffer = create_Graphics_buffer_offscreen_from_buffer(
-							tile_width, tile_height, /*buffer_to_match*/Scene_viewer_app_get_graphics_buffer(
-							 Graphics_window_get_Scene_viewer(window, pane)));
+						current_buffer = Graphics_window_get_offscreen_buffer(
+							window, pane, tile_width, tile_height);
 					}
 					if (current_buffer)
 					{
@@ -5735,7 +6059,7 @@ graphics window on screen.
 								original_viewport_left, original_viewport_top,
 								original_viewport_pixels_per_x, original_viewport_pixels_per_y);
 						}
-						DESTROY(Graphics_buffer_app)(&current_buffer);
+						Graphics_window_release_offscreen_buffer(window, &current_buffer);
 					}
 				}
 			}
@@ -5743,6 +6067,7 @@ graphics window on screen.
 			{
 				display_message(ERROR_MESSAGE,
 					"Graphics_window_get_frame_pixels.  Unable to allocate pixels");
+				Graphics_window_release_offscreen_buffer(window, &offscreen_buffer);
 				return_code=0;
 			}
 		}
@@ -5886,6 +6211,181 @@ Currently limited to 1 byte per component -- may want to improve for HPC.
 	return (cmgui_image);
 } /* Graphics_window_get_image */
 
+int Graphics_window_open_video_stream(struct Graphics_window *window,
+	const char *file_name, const char *command, enum Video_stream_format format,
+	int width, int height, int frame_rate, int queue_size)
+{
+	if (!window)
+	{
+		display_message(ERROR_MESSAGE,
+			"Graphics_window_open_video_stream.  Invalid argument(s)");
+		return 0;
+	}
+	if (window->video_stream)
+	{
+		display_message(ERROR_MESSAGE, "Graphics window %s already has an open "
+			"video stream. Close it first.", window->name);
+		return 0;
+	}
+	if ((0 == width) || (0 == height))
+	{
+		Graphics_window_get_viewing_area_size(window, &width, &height);
+	}
+	window->video_stream = Video_stream::create(file_name, command, format,
+		width, height, frame_rate, queue_size);
+	return (0 != window->video_stream);
+}
+
+int Graphics_window_close_video_stream(struct Graphics_window *window)
+{
+	if (window)
+	{
+		if (window->video_stream)
+		{
+			const int number_of_frames = window->video_stream->get_number_of_frames_queued();
+			/* waits for the writer to finish queued frames */
+			delete window->video_stream;
+			window->video_stream = (Video_stream *)NULL;
+			display_message(INFORMATION_MESSAGE,
+				"Graphics window %s video stream closed after %d frames\n",
+				window->name, number_of_frames);
+		}
+		return 1;
+	}
+	display_message(ERROR_MESSAGE,
+		"Graphics_window_close_video_stream.  Invalid argument(s)");
+	return 0;
+}
+
+int Graphics_window_has_video_stream(struct Graphics_window *window)
+{
+	return (window && window->video_stream) ? 1 : 0;
+}
+
+int Graphics_window_write_video_frame(struct Graphics_window *window,
+	int preferred_antialias, int preferred_transparency_layers)
+{
+	if (!(window && window->video_stream))
+	{
+		display_message(ERROR_MESSAGE,
+			"Graphics_window_write_video_frame.  No video stream open");
+		return 0;
+	}
+	int width = window->video_stream->get_width();
+	int height = window->video_stream->get_height();
+	unsigned char *frame_data = (unsigned char *)NULL;
+	if (!Graphics_window_get_frame_pixels(window, TEXTURE_RGB, &width, &height,
+		preferred_antialias, preferred_transparency_layers, &frame_data,
+		/*force_onscreen*/0))
+	{
+		display_message(ERROR_MESSAGE,
+			"Graphics_window_write_video_frame.  Could not get frame pixels");
+		return 0;
+	}
+	if ((width != window->video_stream->get_width()) ||
+		(height != window->video_stream->get_height()))
+	{
+		display_message(ERROR_MESSAGE, "Graphics_window_write_video_frame.  "
+			"Frame size %d x %d does not match video stream size %d x %d",
+			width, height, window->video_stream->get_width(),
+			window->video_stream->get_height());
+		DEALLOCATE(frame_data);
+		return 0;
+	}
+	/* stream takes ownership of frame_data */
+	return window->video_stream->write_frame(frame_data);
+}
+
+int Graphics_window_get_pane_view(struct Graphics_window *window, int pane_no,
+	double *eye, double *lookat, double *up, double *view_angle)
+{
+	struct Scene_viewer_app *scene_viewer;
+	if (window && eye && lookat && up && view_angle &&
+		(scene_viewer = Graphics_window_get_Scene_viewer(window, pane_no)) &&
+		(CMZN_OK == cmzn_sceneviewer_get_lookat_parameters(
+			scene_viewer->core_scene_viewer, eye, lookat, up)))
+	{
+		*view_angle = cmzn_sceneviewer_get_view_angle(scene_viewer->core_scene_viewer);
+		return 1;
+	}
+	display_message(ERROR_MESSAGE,
+		"Graphics_window_get_pane_view.  Invalid argument(s)");
+	return 0;
+}
+
+int Graphics_window_set_pane_view(struct Graphics_window *window, int pane_no,
+	const double *eye, const double *lookat, const double *up, double view_angle)
+{
+	struct Scene_viewer_app *scene_viewer;
+	if (window && eye && lookat && up &&
+		(scene_viewer = Graphics_window_get_Scene_viewer(window, pane_no)))
+	{
+		if (CMZN_OK != cmzn_sceneviewer_set_lookat_parameters_non_skew(
+			scene_viewer->core_scene_viewer, eye, lookat, up))
+		{
+			display_message(ERROR_MESSAGE,
+				"Graphics_window_set_pane_view.  Invalid eye, lookat or up vector");
+			return 0;
+		}
+		/* must set view angle after lookat parameters */
+		if ((0.0 < view_angle) && (view_angle < PI))
+		{
+			cmzn_sceneviewer_set_view_angle(scene_viewer->core_scene_viewer, view_angle);
+		}
+		Graphics_window_view_changed(window, pane_no);
+		return 1;
+	}
+	display_message(ERROR_MESSAGE,
+		"Graphics_window_set_pane_view.  Invalid argument(s)");
+	return 0;
+}
+
+int Graphics_window_get_scene_coordinates_range(struct Graphics_window *window,
+	cmzn_scenefilter_id filter, double *minimum, double *maximum)
+{
+	if (window && window->scene && minimum && maximum)
+	{
+		if (!(window->scene_range_valid && (filter == window->scene_range_filter)))
+		{
+			const std::chrono::steady_clock::time_point start_time =
+				std::chrono::steady_clock::now();
+			for (int i = 0; i < 3; ++i)
+			{
+				window->scene_range_minimum[i] = 0.0;
+				window->scene_range_maximum[i] = 0.0;
+			}
+			cmzn_scene_get_coordinates_range(window->scene, filter,
+				window->scene_range_minimum, window->scene_range_maximum);
+			window->scene_range_traversal_time += std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start_time).count();
+			++(window->scene_range_traversals);
+			if (filter != window->scene_range_filter)
+			{
+				if (window->scene_range_filter)
+				{
+					cmzn_scenefilter_destroy(&window->scene_range_filter);
+				}
+				window->scene_range_filter = (filter) ? cmzn_scenefilter_access(filter) :
+					(cmzn_scenefilter_id)NULL;
+			}
+			window->scene_range_valid = 1;
+		}
+		else
+		{
+			++(window->scene_range_cache_hits);
+		}
+		for (int i = 0; i < 3; ++i)
+		{
+			minimum[i] = window->scene_range_minimum[i];
+			maximum[i] = window->scene_range_maximum[i];
+		}
+		return 1;
+	}
+	display_message(ERROR_MESSAGE,
+		"Graphics_window_get_scene_coordinates_range.  Invalid argument(s)");
+	return 0;
+}
+
 int Graphics_window_view_all(struct Graphics_window *window)
 /*******************************************************************************
 LAST MODIFIED : 16 October 2001
@@ -5905,7 +6405,7 @@ with commands for setting these.
 		cmzn_scenefilter_id filter = cmzn_sceneviewer_get_scenefilter((window->scene_viewer_array[0]->core_scene_viewer));
 		double min[3] = { 0.0, 0.0, 0.0 };
 		double max[3] = { 0.0, 0.0, 0.0 };
-		cmzn_scene_get_coordinates_range(window->scene, filter, min, max);
+		Graphics_window_get_scene_coordinates_range(window, filter, min, max);
 		const double centre_x = 0.5*(min[0] + max[0]);
 		const double centre_y = 0.5*(min[1] + max[1]);
 		const double centre_z = 0.5*(min[2] + max[2]);
@@ -6440,6 +6940,14 @@ Writes the properties of the <window> to the command window.
 		Graphics_window_get_viewing_area_size(window,&width,&height);
 		display_message(INFORMATION_MESSAGE,"  viewing width x height: %d x %d\n",
 			width,height);
+		display_message(INFORMATION_MESSAGE,
+			"  offscreen buffers: %d created (%g s), %d reused\n",
+			window->offscreen_buffers_created, window->offscreen_buffer_create_time,
+			window->offscreen_buffer_reuses);
+		display_message(INFORMATION_MESSAGE,
+			"  scene range: %d traversals (%g s), %d cached\n",
+			window->scene_range_traversals, window->scene_range_traversal_time,
+			window->scene_range_cache_hits);
 		/* background and view in each active pane */
 		for (int pane_no = 0; pane_no < window->number_of_panes; ++pane_no)
 		{
@@ -7093,6 +7601,9 @@ Parameter <help_mode> should be NULL when calling this function.
 				Option_table_add_entry(valid_window_option_table, "image",
 						(void *)window, modify_graphics_window_data_void,
 						modify_Graphics_window_image);
+				Option_table_add_entry(valid_window_option_table, "input",
+						(void *)window, modify_graphics_window_data_void,
+						modify_Graphics_window_input);
 				Option_table_add_entry(valid_window_option_table, "layout",
 						(void *)window, modify_graphics_window_data_void,
 						modify_Graphics_window_layout);
@@ -26,6 +26,7 @@ interest and set scene_viewer values directly.
 #include "general/list.h"
 #include "general/manager.h"
 #include "general/object.h"
+#include "general/video_stream_app.hpp"
 #include "graphics/scene_viewer.h"
 #include "interaction/interactive_tool.h"
 #include "user_interface/user_interface.h"
@@ -455,6 +456,58 @@ display and the <preferred_width> and <preferred_height> are ignored.
 Currently limited to 1 byte per component -- may want to improve for HPC.
 ==============================================================================*/
 
+/**
+ * Opens a video stream for <window> writing frames of <width> x <height>, or
+ * the current viewing area size if either is 0, in <format> to <file_name> or
+ * to the standard input of the shell <command>. Frames are added with
+ * Graphics_window_write_video_frame and written on a separate thread, with up
+ * to <queue_size> frames buffered. Only one stream may be open per window.
+ */
+int Graphics_window_open_video_stream(struct Graphics_window *window,
+	const char *file_name, const char *command, enum Video_stream_format format,
+	int width, int height, int frame_rate, int queue_size);
+
+/**
+ * Finishes writing queued frames and closes the video stream of <window>, if
+ * any, reporting the number of frames written.
+ */
+int Graphics_window_close_video_stream(struct Graphics_window *window);
+
+/** @return  1 if <window> has an open video stream, otherwise 0. */
+int Graphics_window_has_video_stream(struct Graphics_window *window);
+
+/**
+ * Renders <window> offscreen at the size of its video stream and queues the
+ * RGB frame on the stream, without compressing or writing an image file.
+ */
+int Graphics_window_write_video_frame(struct Graphics_window *window,
+	int preferred_antialias, int preferred_transparency_layers);
+
+/**
+ * Gets the eye, lookat point, up vector and view angle in radians of pane
+ * <pane_no> of <window>. Vectors must have space for 3 values.
+ */
+int Graphics_window_get_pane_view(struct Graphics_window *window, int pane_no,
+	double *eye, double *lookat, double *up, double *view_angle);
+
+/**
+ * Sets the view of pane <pane_no> of <window> from the <eye>, <lookat> point
+ * and <up> vector, which is made orthogonal to the view direction. The
+ * <view_angle> in radians is only set if it is between 0 and PI. Other panes
+ * tied to the pane by the layout are updated to match.
+ */
+int Graphics_window_set_pane_view(struct Graphics_window *window, int pane_no,
+	const double *eye, const double *lookat, const double *up, double view_angle);
+
+/**
+ * Gets the coordinates range of the graphics in the scene of <window> visible
+ * with <filter>. The range is cached by the window and only traversed again
+ * after the scene tree or a scene filter has changed; the number and time of
+ * traversals are listed with the window.
+ */
+int Graphics_window_get_scene_coordinates_range(struct Graphics_window *window,
+	cmzn_scenefilter_id filter, double *minimum, double *maximum);
+
 int Graphics_window_view_all(struct Graphics_window *window);
 /*******************************************************************************
 LAST MODIFIED : 6 October 1998
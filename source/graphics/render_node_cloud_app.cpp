@@ -0,0 +1,503 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldcoordinatetransformation.h"
+#include "opencmiss/zinc/fieldfiniteelement.h"
+#include "opencmiss/zinc/fieldgroup.h"
+#include "opencmiss/zinc/fieldlogicaloperators.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/fieldsubobjectgroup.h"
+#include "opencmiss/zinc/graphics.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/node.h"
+#include "opencmiss/zinc/nodeset.h"
+#include "opencmiss/zinc/region.h"
+#include "opencmiss/zinc/scene.h"
+#include "opencmiss/zinc/scenefilter.h"
+#include "opencmiss/zinc/status.h"
+#include "opencmiss/zinc/tessellation.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "graphics/render_node_cloud_app.hpp"
+#include "graphics/scene.hpp"
+
+namespace {
+
+/**
+ * Samples points from the elements drawn by one lines or surfaces graphics.
+ */
+class Node_cloud_graphics_sampler
+{
+	cmzn_fieldmodule_id field_module;
+	cmzn_field_id coordinate_field; // rectangular cartesian
+	cmzn_field_id data_field;
+	cmzn_field_id conditional_field; // combined subgroup, exterior and face
+	int dimension;
+	int divisions[2];
+	double density, density_scale_factor;
+	unsigned int seed, graphics_index;
+
+	Node_cloud_graphics_sampler(const Node_cloud_graphics_sampler&);
+	Node_cloud_graphics_sampler& operator=(const Node_cloud_graphics_sampler&);
+
+	/**
+	 * Evaluates rectangular cartesian coordinates, padded to 3 components, and
+	 * data density at xi.
+	 */
+	bool evaluate_vertex(cmzn_fieldcache_id field_cache, cmzn_element_id element,
+		const double *xi, double *position, double *vertex_density) const
+	{
+		cmzn_fieldcache_set_mesh_location(field_cache, element, this->dimension, xi);
+		const int number_of_components = cmzn_field_get_number_of_components(this->coordinate_field);
+		position[0] = position[1] = position[2] = 0.0;
+		if (CMZN_OK != cmzn_field_evaluate_real(this->coordinate_field, field_cache,
+				number_of_components, position))
+			return false;
+		*vertex_density = this->density;
+		if (this->data_field)
+		{
+			double data_values[16];
+			const int number_of_data_components = cmzn_field_get_number_of_components(this->data_field);
+			if ((number_of_data_components <= 16) &&
+				(CMZN_OK == cmzn_field_evaluate_real(this->data_field, field_cache,
+					number_of_data_components, data_values)))
+			{
+				*vertex_density += this->density_scale_factor*data_values[0];
+			}
+		}
+		return true;
+	}
+
+	static void add_random_point(std::mt19937 &generator, const double *a, const double *b,
+		const double *c, std::vector<double>& points)
+	{
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		double r1 = uniform(generator);
+		double r2 = (c) ? uniform(generator) : 0.0;
+		if (r1 + r2 > 1.0)
+		{
+			r1 = 1.0 - r1;
+			r2 = 1.0 - r2;
+		}
+		for (int i = 0; i < 3; ++i)
+			points.push_back(a[i] + r1*(b[i] - a[i]) + ((c) ? r2*(c[i] - a[i]) : 0.0));
+	}
+
+	/** Samples a line segment <a>-<b> or triangle <a>-<b>-<c>. */
+	void sample_primitive(std::mt19937 &generator, const double *a, const double *b,
+		const double *c, double primitive_density, std::vector<double>& points) const
+	{
+		double size = 0.0;
+		if (c)
+		{
+			const double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const double n[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+			size = 0.5*sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+		}
+		else
+		{
+			size = sqrt((b[0] - a[0])*(b[0] - a[0]) + (b[1] - a[1])*(b[1] - a[1]) +
+				(b[2] - a[2])*(b[2] - a[2]));
+		}
+		const double expected_number = size*primitive_density;
+		if (!(expected_number > 0.0))
+			return;
+		std::poisson_distribution<int> poisson(expected_number);
+		const int number_of_points = poisson(generator);
+		for (int p = 0; p < number_of_points; ++p)
+			add_random_point(generator, a, b, c, points);
+	}
+
+public:
+
+	/** Takes over references to fields. */
+	Node_cloud_graphics_sampler(cmzn_fieldmodule_id field_moduleIn,
+			cmzn_field_id coordinate_fieldIn, cmzn_field_id data_fieldIn,
+			cmzn_field_id conditional_fieldIn, int dimensionIn, const int *divisionsIn,
+			double densityIn, double density_scale_factorIn, unsigned int seedIn,
+			unsigned int graphics_indexIn) :
+		field_module(cmzn_fieldmodule_access(field_moduleIn)),
+		coordinate_field(coordinate_fieldIn),
+		data_field(data_fieldIn),
+		conditional_field(conditional_fieldIn),
+		dimension(dimensionIn),
+		density(densityIn),
+		density_scale_factor(density_scale_factorIn),
+		seed(seedIn),
+		graphics_index(graphics_indexIn)
+	{
+		this->divisions[0] = divisionsIn[0];
+		this->divisions[1] = divisionsIn[1];
+	}
+
+	~Node_cloud_graphics_sampler()
+	{
+		cmzn_field_destroy(&this->conditional_field);
+		cmzn_field_destroy(&this->data_field);
+		cmzn_field_destroy(&this->coordinate_field);
+		cmzn_fieldmodule_destroy(&this->field_module);
+	}
+
+	/** Appends sampled points for all elements in element order to <points>. */
+	void sample(std::vector<double>& points) const;
+};
+
+/* elements are sampled on one thread as element field evaluation is not safe
+ * on several */
+void Node_cloud_graphics_sampler::sample(std::vector<double>& points) const
+{
+	cmzn_mesh_id mesh = cmzn_fieldmodule_find_mesh_by_dimension(this->field_module, this->dimension);
+	std::vector<cmzn_element_id> elements;
+	cmzn_elementiterator_id iter = cmzn_mesh_create_elementiterator(mesh);
+	cmzn_element_id element;
+	while (0 != (element = cmzn_elementiterator_next(iter)))
+		elements.push_back(element);
+	cmzn_elementiterator_destroy(&iter);
+	cmzn_mesh_destroy(&mesh);
+	const int number_of_elements = static_cast<int>(elements.size());
+	cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(this->field_module);
+	std::vector<double> grid_positions, grid_densities;
+	std::vector<char> grid_valid;
+	for (int e = 0; e < number_of_elements; ++e)
+	{
+		cmzn_element_id element = elements[e];
+		const bool triangle = (CMZN_ELEMENT_SHAPE_TYPE_TRIANGLE == cmzn_element_get_shape_type(element));
+		if (this->conditional_field)
+		{
+			const double centre_xi[2] = { triangle ? 1.0/3.0 : 0.5, triangle ? 1.0/3.0 : 0.5 };
+			double value = 0.0;
+			cmzn_fieldcache_set_mesh_location(field_cache, element, this->dimension, centre_xi);
+			if ((CMZN_OK != cmzn_field_evaluate_real(this->conditional_field, field_cache, 1, &value)) ||
+					(0.0 == value))
+				continue;
+		}
+		/* random stream depends only on seed, graphics and element */
+		std::seed_seq seed_sequence = { this->seed, this->graphics_index,
+			static_cast<unsigned int>(cmzn_element_get_identifier(element)) };
+		std::mt19937 generator(seed_sequence);
+		int n1 = this->divisions[0];
+		int n2 = (2 == this->dimension) ? this->divisions[1] : 0;
+		if (triangle && (n1 != n2))
+		{
+			/* the simplex grid is only covered by whole triangles with equal
+			 * divisions; use the larger, as triangles are drawn */
+			n1 = n2 = (n1 > n2) ? n1 : n2;
+		}
+		const int grid_size = (n1 + 1)*(n2 + 1);
+		grid_positions.resize(3*grid_size);
+		grid_densities.resize(grid_size);
+		grid_valid.resize(grid_size);
+		for (int j = 0; j <= n2; ++j)
+			for (int i = 0; i <= n1; ++i)
+			{
+				const int g = j*(n1 + 1) + i;
+				const double xi[2] = { static_cast<double>(i)/n1, (n2) ? static_cast<double>(j)/n2 : 0.0 };
+				grid_valid[g] = ((!triangle) || (i*n2 + j*n1 <= n1*n2)) &&
+					this->evaluate_vertex(field_cache, element, xi, &grid_positions[3*g], &grid_densities[g]);
+			}
+		if (1 == this->dimension)
+		{
+			for (int i = 0; i < n1; ++i)
+			{
+				if (grid_valid[i] && grid_valid[i + 1])
+					this->sample_primitive(generator, &grid_positions[3*i], &grid_positions[3*(i + 1)], 0,
+						0.5*(grid_densities[i] + grid_densities[i + 1]), points);
+			}
+			continue;
+		}
+		for (int j = 0; j < n2; ++j)
+			for (int i = 0; i < n1; ++i)
+			{
+				const int g00 = j*(n1 + 1) + i, g10 = g00 + 1, g01 = g00 + n1 + 1, g11 = g01 + 1;
+				const int triangles[2][3] = { { g00, g10, g01 }, { g10, g11, g01 } };
+				for (int t = 0; t < 2; ++t)
+				{
+					const int *v = triangles[t];
+					if (grid_valid[v[0]] && grid_valid[v[1]] && grid_valid[v[2]])
+						this->sample_primitive(generator, &grid_positions[3*v[0]], &grid_positions[3*v[1]],
+							&grid_positions[3*v[2]], (grid_densities[v[0]] + grid_densities[v[1]] +
+								grid_densities[v[2]])/3.0, points);
+				}
+			}
+	}
+	cmzn_fieldcache_destroy(&field_cache);
+	for (int e = 0; e < number_of_elements; ++e)
+		cmzn_element_destroy(&elements[e]);
+}
+
+/**
+ * Makes a sampler for <graphics> if it is a lines or surfaces graphics.
+ * @return  New sampler or 0 if graphics is not sampled.
+ */
+Node_cloud_graphics_sampler *Node_cloud_graphics_sampler_create(cmzn_region_id region,
+	cmzn_graphics_id graphics, const Render_node_cloud_options &options,
+	unsigned int graphics_index)
+{
+	const cmzn_graphics_type graphics_type = cmzn_graphics_get_type(graphics);
+	const int dimension = (CMZN_GRAPHICS_TYPE_LINES == graphics_type) ? 1 :
+		((CMZN_GRAPHICS_TYPE_SURFACES == graphics_type) ? 2 : 0);
+	cmzn_field_id coordinate_field = cmzn_graphics_get_coordinate_field(graphics);
+	if ((0 == dimension) || (!coordinate_field) ||
+		(3 < cmzn_field_get_number_of_components(coordinate_field)))
+	{
+		cmzn_field_destroy(&coordinate_field);
+		return 0;
+	}
+	cmzn_fieldmodule_id field_module = cmzn_region_get_fieldmodule(region);
+	cmzn_fieldmodule_begin_change(field_module);
+	if (CMZN_FIELD_COORDINATE_SYSTEM_TYPE_RECTANGULAR_CARTESIAN !=
+		cmzn_field_get_coordinate_system_type(coordinate_field))
+	{
+		/* sample where drawn, in rectangular cartesian coordinates */
+		cmzn_field_id rc_coordinate_field =
+			cmzn_fieldmodule_create_field_coordinate_transformation(field_module, coordinate_field);
+		cmzn_field_set_coordinate_system_type(rc_coordinate_field,
+			CMZN_FIELD_COORDINATE_SYSTEM_TYPE_RECTANGULAR_CARTESIAN);
+		cmzn_field_destroy(&coordinate_field);
+		coordinate_field = rc_coordinate_field;
+	}
+	int divisions[2] = { 1, 1 };
+	cmzn_tessellation_id tessellation = cmzn_graphics_get_tessellation(graphics);
+	if (tessellation)
+	{
+		if (1 == cmzn_tessellation_get_minimum_divisions(tessellation, 2, divisions))
+			divisions[1] = divisions[0];
+		/* sample the refined tessellation drawn for non-linear coordinates; for
+		 * linear elements it covers the same lines and surfaces */
+		int refinement_factors[2] = { 1, 1 };
+		if (1 == cmzn_tessellation_get_refinement_factors(tessellation, 2, refinement_factors))
+			refinement_factors[1] = refinement_factors[0];
+		for (int d = 0; d < 2; ++d)
+			if (1 < refinement_factors[d])
+				divisions[d] *= refinement_factors[d];
+		cmzn_tessellation_destroy(&tessellation);
+	}
+	for (int d = 0; d < 2; ++d)
+		if (divisions[d] < 1)
+			divisions[d] = 1;
+	cmzn_field_id conditional_field = cmzn_graphics_get_subgroup_field(graphics);
+	if (cmzn_graphics_is_exterior(graphics))
+	{
+		cmzn_field_id is_exterior_field = cmzn_fieldmodule_create_field_is_exterior(field_module);
+		if (conditional_field)
+		{
+			cmzn_field_id and_field = cmzn_fieldmodule_create_field_and(field_module,
+				conditional_field, is_exterior_field);
+			cmzn_field_destroy(&is_exterior_field);
+			cmzn_field_destroy(&conditional_field);
+			conditional_field = and_field;
+		}
+		else
+			conditional_field = is_exterior_field;
+	}
+	const cmzn_element_face_type face_type = cmzn_graphics_get_element_face_type(graphics);
+	if (CMZN_ELEMENT_FACE_TYPE_ALL != face_type)
+	{
+		cmzn_field_id is_on_face_field = cmzn_fieldmodule_create_field_is_on_face(field_module, face_type);
+		if (conditional_field)
+		{
+			cmzn_field_id and_field = cmzn_fieldmodule_create_field_and(field_module,
+				conditional_field, is_on_face_field);
+			cmzn_field_destroy(&is_on_face_field);
+			cmzn_field_destroy(&conditional_field);
+			conditional_field = and_field;
+		}
+		else
+			conditional_field = is_on_face_field;
+	}
+	cmzn_fieldmodule_end_change(field_module);
+	Node_cloud_graphics_sampler *sampler = new Node_cloud_graphics_sampler(field_module,
+		coordinate_field, cmzn_graphics_get_data_field(graphics), conditional_field, dimension,
+		divisions, (1 == dimension) ? options.line_density : options.surface_density,
+		(1 == dimension) ? options.line_density_scale_factor : options.surface_density_scale_factor,
+		static_cast<unsigned int>(options.seed), graphics_index);
+	cmzn_fieldmodule_destroy(&field_module);
+	return sampler;
+}
+
+/**
+ * Transforms <points> from <begin> by the 4x4 row-major homogeneous <matrix>,
+ * as a projection field does.
+ */
+void Render_node_cloud_transform_points(const double *matrix, size_t begin,
+	std::vector<double>& points)
+{
+	for (size_t i = begin; i + 2 < points.size(); i += 3)
+	{
+		double *x = &points[i];
+		double result[4];
+		for (int r = 0; r < 4; ++r)
+			result[r] = matrix[r*4]*x[0] + matrix[r*4 + 1]*x[1] + matrix[r*4 + 2]*x[2] + matrix[r*4 + 3];
+		if (0.0 != result[3])
+		{
+			for (int c = 0; c < 3; ++c)
+				x[c] = result[c]/result[3];
+		}
+	}
+}
+
+/**
+ * Samples graphics in the scene of <region> and its subregions, in tree order.
+ * Points are transformed by the scene transformations of <region> and its
+ * ancestors up to the input region, composed into <parent_matrix>, a 4x4
+ * row-major matrix or 0 for identity, so they are where the graphics are drawn.
+ */
+void Render_node_cloud_sample_region(cmzn_region_id region, const char *graphics_name,
+	cmzn_scenefilter_id filter, const Render_node_cloud_options &options,
+	const double *parent_matrix, unsigned int &graphics_index, std::vector<double>& points)
+{
+	cmzn_scene_id scene = cmzn_region_get_scene(region);
+	double matrix[16];
+	const double *scene_matrix = parent_matrix;
+	double transformation[16];
+	if (cmzn_scene_has_transformation(scene) &&
+		(CMZN_OK == scene->getTransformationMatrixRowMajor(transformation)))
+	{
+		if (parent_matrix)
+		{
+			for (int r = 0; r < 4; ++r)
+				for (int c = 0; c < 4; ++c)
+					matrix[r*4 + c] = parent_matrix[r*4]*transformation[c] +
+						parent_matrix[r*4 + 1]*transformation[4 + c] +
+						parent_matrix[r*4 + 2]*transformation[8 + c] +
+						parent_matrix[r*4 + 3]*transformation[12 + c];
+		}
+		else
+		{
+			for (int i = 0; i < 16; ++i)
+				matrix[i] = transformation[i];
+		}
+		scene_matrix = matrix;
+	}
+	cmzn_graphics_id graphics = cmzn_scene_get_first_graphics(scene);
+	while (graphics)
+	{
+		char *name = cmzn_graphics_get_name(graphics);
+		if (((!graphics_name) || (name && (0 == strcmp(name, graphics_name)))) &&
+			((!filter) || cmzn_scenefilter_evaluate_graphics(filter, graphics)))
+		{
+			Node_cloud_graphics_sampler *sampler =
+				Node_cloud_graphics_sampler_create(region, graphics, options, graphics_index);
+			if (sampler)
+			{
+				const size_t begin = points.size();
+				sampler->sample(points);
+				delete sampler;
+				if (scene_matrix)
+					Render_node_cloud_transform_points(scene_matrix, begin, points);
+			}
+			++graphics_index;
+		}
+		cmzn_deallocate(name);
+		cmzn_graphics_id next_graphics = cmzn_scene_get_next_graphics(scene, graphics);
+		cmzn_graphics_destroy(&graphics);
+		graphics = next_graphics;
+	}
+	cmzn_scene_destroy(&scene);
+	cmzn_region_id child = cmzn_region_get_first_child(region);
+	while (child)
+	{
+		Render_node_cloud_sample_region(child, graphics_name, filter, options, scene_matrix,
+			graphics_index, points);
+		cmzn_region_reaccess_next_sibling(&child);
+	}
+}
+
+} // anonymous namespace
+
+int Render_node_cloud_seeded(cmzn_region_id input_region,
+	const char *graphics_name, cmzn_scenefilter_id filter, cmzn_region_id region,
+	cmzn_field_group_id group, cmzn_field_id coordinate_field,
+	const Render_node_cloud_options &options)
+{
+	if (!(input_region && region && coordinate_field &&
+		(3 >= cmzn_field_get_number_of_components(coordinate_field)) &&
+		(0 <= options.maximum_number_of_points)))
+	{
+		display_message(ERROR_MESSAGE, "Render_node_cloud_seeded.  Invalid argument(s)");
+		return 0;
+	}
+	if (CMZN_FIELD_COORDINATE_SYSTEM_TYPE_RECTANGULAR_CARTESIAN !=
+		cmzn_field_get_coordinate_system_type(coordinate_field))
+	{
+		display_message(ERROR_MESSAGE, "gfx convert graphics.  "
+			"Node cloud coordinate field must be rectangular cartesian");
+		return 0;
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<double> points;
+	unsigned int graphics_index = 0;
+	Render_node_cloud_sample_region(input_region, graphics_name, filter, options,
+		/*parent_matrix*/0, graphics_index, points);
+	const int number_of_sampled_points = static_cast<int>(points.size()/3);
+	const double sample_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	/* stratified thinning: one point from the middle of each stratum */
+	int number_of_points = number_of_sampled_points;
+	const bool thin = (0 < options.maximum_number_of_points) &&
+		(options.maximum_number_of_points < number_of_sampled_points);
+	if (thin)
+		number_of_points = options.maximum_number_of_points;
+
+	start = std::chrono::steady_clock::now();
+	int return_code = 1;
+	cmzn_fieldmodule_id field_module = cmzn_region_get_fieldmodule(region);
+	cmzn_fieldmodule_begin_change(field_module);
+	cmzn_nodeset_id nodeset = cmzn_fieldmodule_find_nodeset_by_field_domain_type(field_module,
+		CMZN_FIELD_DOMAIN_TYPE_NODES);
+	cmzn_nodeset_group_id nodeset_group = 0;
+	if (group)
+	{
+		cmzn_field_node_group_id node_group = cmzn_field_group_get_field_node_group(group, nodeset);
+		if (!node_group)
+			node_group = cmzn_field_group_create_field_node_group(group, nodeset);
+		nodeset_group = cmzn_field_node_group_get_nodeset_group(node_group);
+		cmzn_field_node_group_destroy(&node_group);
+	}
+	cmzn_nodetemplate_id nodetemplate = cmzn_nodeset_create_nodetemplate(nodeset);
+	cmzn_nodetemplate_define_field(nodetemplate, coordinate_field);
+	cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(field_module);
+	const int number_of_components = cmzn_field_get_number_of_components(coordinate_field);
+	for (int p = 0; (p < number_of_points) && return_code; ++p)
+	{
+		const size_t point_index = (thin) ? static_cast<size_t>((static_cast<double>(p) + 0.5)*
+			static_cast<double>(number_of_sampled_points)/static_cast<double>(number_of_points)) :
+			static_cast<size_t>(p);
+		cmzn_node_id node = cmzn_nodeset_create_node(nodeset, /*identifier*/-1, nodetemplate);
+		cmzn_fieldcache_set_node(field_cache, node);
+		if ((!node) || (CMZN_OK != cmzn_field_assign_real(coordinate_field, field_cache,
+				number_of_components, &points[3*point_index])) ||
+			(nodeset_group && (CMZN_OK != cmzn_nodeset_group_add_node(nodeset_group, node))))
+		{
+			display_message(ERROR_MESSAGE, "gfx convert graphics.  Failed to create node cloud");
+			return_code = 0;
+		}
+		cmzn_node_destroy(&node);
+	}
+	cmzn_fieldcache_destroy(&field_cache);
+	cmzn_nodetemplate_destroy(&nodetemplate);
+	cmzn_nodeset_group_destroy(&nodeset_group);
+	cmzn_nodeset_destroy(&nodeset);
+	cmzn_fieldmodule_end_change(field_module);
+	cmzn_fieldmodule_destroy(&field_module);
+	const double create_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (return_code)
+	{
+		display_message(INFORMATION_MESSAGE, "Created %d nodes from %d points sampled in %g s "
+			"(%d graphics), nodes created in %g s\n", number_of_points, number_of_sampled_points,
+			sample_seconds, graphics_index, create_seconds);
+	}
+	return (return_code);
+}
@@ -0,0 +1,52 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (RENDER_NODE_CLOUD_APP_HPP)
+#define RENDER_NODE_CLOUD_APP_HPP
+
+#include "opencmiss/zinc/types/fieldid.h"
+#include "opencmiss/zinc/types/fieldgroupid.h"
+#include "opencmiss/zinc/types/regionid.h"
+#include "opencmiss/zinc/types/scenefilterid.h"
+
+/** Sampling parameters for Render_node_cloud_seeded. */
+struct Render_node_cloud_options
+{
+	double line_density, line_density_scale_factor;
+	double surface_density, surface_density_scale_factor;
+	/** Seed combined with each graphics and element to give its random stream. */
+	int seed;
+	/** Maximum number of nodes to create, or 0 for no limit. */
+	int maximum_number_of_points;
+};
+
+/**
+ * Creates nodes in <region>, adding them to <group> if given, at points sampled
+ * from the lines and surfaces graphics in the scenes of <input_region> and its
+ * subregions which pass <filter> and, if given, are named <graphics_name>.
+ * Each element drawn by a graphics is tessellated with its tessellation's
+ * minimum divisions times refinement factors, with the larger division count
+ * in both directions on triangles, and its coordinate field is converted to
+ * rectangular cartesian. Points are transformed by the scene transformations
+ * from the input region down, so they are where the graphics are drawn. The
+ * number of points in each line segment or triangle is Poisson distributed
+ * with expected number the length or area times the density, plus the scaled
+ * first component of the graphics data field if any. Each element has its own
+ * random stream seeded from the options seed, the graphics and the element
+ * identifier, so the same points are made each time. Elements are sampled on
+ * the calling thread as element field evaluation is not safe on several.
+ * If more than the maximum number of points are
+ * sampled, they are thinned by keeping one point in each of that many equal
+ * strata of the points in graphics and element order. All nodes are created
+ * with <coordinate_field>, which must be rectangular cartesian, in one change.
+ * @return  1 on success, 0 on failure.
+ */
+int Render_node_cloud_seeded(cmzn_region_id input_region,
+	const char *graphics_name, cmzn_scenefilter_id filter, cmzn_region_id region,
+	cmzn_field_group_id group, cmzn_field_id coordinate_field,
+	const Render_node_cloud_options &options);
+
+#endif /* !defined (RENDER_NODE_CLOUD_APP_HPP) */
@@ -4,6 +4,10 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
 #include "general/debug.h"
 #include "general/message.h"
 #include "graphics/graphics_module.hpp"
@@ -20,6 +24,13 @@
 int Scene_viewer_app_input_select(struct Scene_viewer_app *scene_viewer,
 	struct Graphics_buffer_input *input);
 
+/** @return  Steady clock time in seconds, for timing input events. */
+static double Scene_viewer_app_get_clock_time()
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 int Scene_viewer_app_default_input_callback(struct Scene_viewer_app *scene_viewer,
 	struct Graphics_buffer_input *input, void *dummy_void);
 
@@ -177,6 +188,8 @@ struct Scene_viewer_app *CREATE(Scene_viewer_app)(struct Graphics_buffer_app *gr
 				scene_viewer->core_scene_viewer);
 			cmzn_sceneviewernotifier_set_callback(scene_viewer->notifier,
 				My_cmzn_sceneviewer_callback, (void *)scene_viewer);
+			scene_viewer->input_record_file = 0;
+			scene_viewer->input_record_start_time = 0.0;
 			Graphics_buffer_app_add_initialise_callback(graphics_buffer,
 				Scene_viewer_app_initialise_callback, scene_viewer);
 			Graphics_buffer_app_add_resize_callback(graphics_buffer,
@@ -227,6 +240,8 @@ struct Scene_viewer_app *Scene_viewer_app_for_spectrum_create(struct Graphics_bu
 				scene_viewer->core_scene_viewer);
 			cmzn_sceneviewernotifier_set_callback(scene_viewer->notifier,
 				My_cmzn_sceneviewer_callback, (void *)scene_viewer);
+			scene_viewer->input_record_file = 0;
+			scene_viewer->input_record_start_time = 0.0;
 			Graphics_buffer_app_add_initialise_callback(graphics_buffer,
 				Scene_viewer_app_initialise_callback, scene_viewer);
 			Graphics_buffer_app_add_resize_callback(graphics_buffer,
@@ -248,6 +263,7 @@ int DESTROY(Scene_viewer_app)(struct Scene_viewer_app **scene_viewer_app_address
 	if (scene_viewer_app_address && (scene_viewer = *scene_viewer_app_address))
 	{
 		return_code = 1;
+		Scene_viewer_app_stop_input_recording(scene_viewer);
 		if (scene_viewer->idle_update_callback_id)
 		{
 			Event_dispatcher_remove_idle_callback(
@@ -1378,6 +1394,14 @@ returned to the scene.
 	USE_PARAMETER(graphics_buffer);
 	if (scene_viewer != 0)
 	{
+		if (scene_viewer->input_record_file && input)
+		{
+			fprintf(scene_viewer->input_record_file, "event %.6f %d %d %d %d %d %d\n",
+				Scene_viewer_app_get_clock_time() - scene_viewer->input_record_start_time,
+				static_cast<int>(input->type), input->button_number,
+				static_cast<int>(input->modifiers), input->position_x,
+				input->position_y, input->key_code);
+		}
 		CMZN_CALLBACK_LIST_CALL(Scene_viewer_app_input_callback)(
 			scene_viewer->input_callback_list,scene_viewer,input);
 	}
@@ -1526,3 +1550,211 @@ scene_viewer.
 	return (return_code);
 } /* Scene_viewer_input_select */
 
+
+int Scene_viewer_app_start_input_recording(struct Scene_viewer_app *scene_viewer,
+	const char *file_name)
+{
+	if (!(scene_viewer && file_name))
+	{
+		display_message(ERROR_MESSAGE,
+			"Scene_viewer_app_start_input_recording.  Invalid argument(s)");
+		return 0;
+	}
+	Scene_viewer_app_stop_input_recording(scene_viewer);
+	FILE *record_file = fopen(file_name, "w");
+	if (!record_file)
+	{
+		display_message(ERROR_MESSAGE,
+			"Could not open input recording file %s", file_name);
+		return 0;
+	}
+	double eye[3], lookat[3], up[3];
+	cmzn_sceneviewer_get_lookat_parameters(scene_viewer->core_scene_viewer,
+		eye, lookat, up);
+	const double view_angle = cmzn_sceneviewer_get_view_angle(
+		scene_viewer->core_scene_viewer);
+	GLint viewport[4];
+	Graphics_buffer_app_make_current(scene_viewer->graphics_buffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	fprintf(record_file, "# cmgui scene viewer input recording\n");
+	fprintf(record_file, "viewport %d %d\n",
+		static_cast<int>(viewport[2]), static_cast<int>(viewport[3]));
+	fprintf(record_file, "view %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n",
+		eye[0], eye[1], eye[2], lookat[0], lookat[1], lookat[2],
+		up[0], up[1], up[2], view_angle);
+	fprintf(record_file, "# event TIME TYPE BUTTON MODIFIERS X Y KEY_CODE\n");
+	scene_viewer->input_record_file = record_file;
+	scene_viewer->input_record_start_time = Scene_viewer_app_get_clock_time();
+	return 1;
+}
+
+int Scene_viewer_app_stop_input_recording(struct Scene_viewer_app *scene_viewer)
+{
+	if (!scene_viewer)
+	{
+		display_message(ERROR_MESSAGE,
+			"Scene_viewer_app_stop_input_recording.  Invalid argument(s)");
+		return 0;
+	}
+	if (scene_viewer->input_record_file)
+	{
+		fclose(scene_viewer->input_record_file);
+		scene_viewer->input_record_file = 0;
+	}
+	return 1;
+}
+
+namespace {
+
+struct Scene_viewer_app_recorded_input
+{
+	double time;
+	int type, button_number, modifiers, position_x, position_y, key_code;
+};
+
+/** Writes the median, 90th, 99th percentile and maximum of <times> in ms. */
+void Scene_viewer_app_report_percentiles(const char *title,
+	std::vector<double>& times)
+{
+	if (times.empty())
+	{
+		display_message(INFORMATION_MESSAGE, "  %s: none\n", title);
+		return;
+	}
+	std::sort(times.begin(), times.end());
+	const size_t count = times.size();
+	const double percentiles[3] = { 0.5, 0.9, 0.99 };
+	double values[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		/* nearest rank */
+		size_t rank = static_cast<size_t>(ceil(percentiles[i]*count));
+		if (rank < 1)
+			rank = 1;
+		values[i] = times[rank - 1];
+	}
+	display_message(INFORMATION_MESSAGE,
+		"  %s (%d): median %g ms, 90%% %g ms, 99%% %g ms, max %g ms\n",
+		title, static_cast<int>(count), 1000.0*values[0], 1000.0*values[1],
+		1000.0*values[2], 1000.0*times[count - 1]);
+}
+
+}
+
+int Scene_viewer_app_replay_input(struct Scene_viewer_app *scene_viewer,
+	const char *file_name)
+{
+	if (!(scene_viewer && file_name))
+	{
+		display_message(ERROR_MESSAGE,
+			"Scene_viewer_app_replay_input.  Invalid argument(s)");
+		return 0;
+	}
+	if (scene_viewer->input_record_file)
+	{
+		display_message(ERROR_MESSAGE,
+			"Scene_viewer_app_replay_input.  Cannot replay while recording input");
+		return 0;
+	}
+	FILE *replay_file = fopen(file_name, "r");
+	if (!replay_file)
+	{
+		display_message(ERROR_MESSAGE,
+			"Could not open input recording file %s", file_name);
+		return 0;
+	}
+	int return_code = 1;
+	int recorded_width = 0, recorded_height = 0;
+	int have_view = 0;
+	double eye[3], lookat[3], up[3], view_angle = 0.0;
+	std::vector<Scene_viewer_app_recorded_input> events;
+	char line[1024];
+	int line_number = 0;
+	while (return_code && fgets(line, sizeof(line), replay_file))
+	{
+		++line_number;
+		Scene_viewer_app_recorded_input event;
+		if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r'))
+		{
+			continue;
+		}
+		else if (7 == sscanf(line, "event %lf %d %d %d %d %d %d", &event.time,
+			&event.type, &event.button_number, &event.modifiers,
+			&event.position_x, &event.position_y, &event.key_code))
+		{
+			events.push_back(event);
+		}
+		else if (2 == sscanf(line, "viewport %d %d", &recorded_width, &recorded_height))
+		{
+		}
+		else if (10 == sscanf(line, "view %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+			&eye[0], &eye[1], &eye[2], &lookat[0], &lookat[1], &lookat[2],
+			&up[0], &up[1], &up[2], &view_angle))
+		{
+			have_view = 1;
+		}
+		else
+		{
+			display_message(ERROR_MESSAGE,
+				"Invalid input recording in %s at line %d", file_name, line_number);
+			return_code = 0;
+		}
+	}
+	fclose(replay_file);
+	if (!return_code)
+		return 0;
+
+	Graphics_buffer_app_make_current(scene_viewer->graphics_buffer);
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((0 < recorded_width) && ((recorded_width != viewport[2]) ||
+		(recorded_height != viewport[3])))
+	{
+		display_message(WARNING_MESSAGE, "Replaying input recorded in a %d x %d "
+			"viewport into %d x %d; picking will not match the recording",
+			recorded_width, recorded_height,
+			static_cast<int>(viewport[2]), static_cast<int>(viewport[3]));
+	}
+	if (have_view)
+	{
+		cmzn_sceneviewer_set_lookat_parameters_non_skew(
+			scene_viewer->core_scene_viewer, eye, lookat, up);
+		if (0.0 < view_angle)
+			cmzn_sceneviewer_set_view_angle(scene_viewer->core_scene_viewer, view_angle);
+		Scene_viewer_app_redraw_now(scene_viewer);
+	}
+
+	std::vector<double> handler_times, frame_times;
+	handler_times.reserve(events.size());
+	const double replay_start = Scene_viewer_app_get_clock_time();
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const Scene_viewer_app_recorded_input& event = events[i];
+		struct Graphics_buffer_input input;
+		input.type = static_cast<enum cmzn_sceneviewerinput_event_type>(event.type);
+		input.button_number = event.button_number;
+		input.key_code = event.key_code;
+		input.position_x = event.position_x;
+		input.position_y = event.position_y;
+		input.modifiers = static_cast<enum Graphics_buffer_input_modifier>(event.modifiers);
+		const double handler_start = Scene_viewer_app_get_clock_time();
+		CMZN_CALLBACK_LIST_CALL(Scene_viewer_app_input_callback)(
+			scene_viewer->input_callback_list, scene_viewer, &input);
+		const double handler_end = Scene_viewer_app_get_clock_time();
+		handler_times.push_back(handler_end - handler_start);
+		/* do the redraw the event requested in idle time now so it is timed */
+		if (scene_viewer->idle_update_callback_id)
+		{
+			Scene_viewer_app_redraw_now(scene_viewer);
+			frame_times.push_back(Scene_viewer_app_get_clock_time() - handler_end);
+		}
+	}
+	const double replay_time = Scene_viewer_app_get_clock_time() - replay_start;
+	display_message(INFORMATION_MESSAGE,
+		"Replayed %d input events from %s (%g s recorded) in %g s\n",
+		static_cast<int>(events.size()), file_name,
+		events.empty() ? 0.0 : events.back().time, replay_time);
+	Scene_viewer_app_report_percentiles("handler latency", handler_times);
+	Scene_viewer_app_report_percentiles("idle redraw frame time", frame_times);
+	return 1;
+}
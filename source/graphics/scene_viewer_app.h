@@ -8,6 +8,7 @@
 #if !defined (SCENE_VIEWER_APP_H_)
 #define SCENE_VIEWER_APP_H_
 
+#include <stdio.h>
 #include "computed_field/computed_field.h"
 
 #include "interaction/interactive_tool.h"
@@ -62,6 +63,10 @@ struct Scene_viewer_app
 	/* list of callbacks requested by other objects when view changes */
 	struct LIST(CMZN_CALLBACK_ITEM(Scene_viewer_app_callback)) *sync_callback_list;
 	cmzn_sceneviewernotifier_id notifier;
+	/* file input events are recorded to, or NULL if not recording, and the
+		steady clock time in seconds that recording started */
+	FILE *input_record_file;
+	double input_record_start_time;
 };
 
 DECLARE_LIST_TYPES(Scene_viewer_app);
@@ -163,5 +168,31 @@ int Scene_viewer_app_remove_input_callback(struct Scene_viewer_app *scene_viewer
 	CMZN_CALLBACK_FUNCTION(Scene_viewer_app_input_callback) *function,
 	void *user_data);
 
+/**
+ * Starts recording every input event received by <scene_viewer> to
+ * <file_name>, with its time since recording started, button, modifiers,
+ * position and key code. The viewport size and view at the start are written
+ * first so replay can rebuild the same interaction volumes. Replaces any
+ * recording in progress.
+ */
+int Scene_viewer_app_start_input_recording(struct Scene_viewer_app *scene_viewer,
+	const char *file_name);
+
+/**
+ * Stops and closes any input recording for <scene_viewer>.
+ */
+int Scene_viewer_app_stop_input_recording(struct Scene_viewer_app *scene_viewer);
+
+/**
+ * Replays input events recorded with Scene_viewer_app_start_input_recording
+ * through the input callbacks of <scene_viewer>, and so through the default
+ * input callback and the current interactive tool, as fast as they can be
+ * handled. Restores the recorded view first. Any redraw requested by an event
+ * is performed immediately so it can be timed. Reports the handler latency
+ * and frame time percentiles.
+ */
+int Scene_viewer_app_replay_input(struct Scene_viewer_app *scene_viewer,
+	const char *file_name);
+
 #endif
 
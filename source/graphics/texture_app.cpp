@@ -11,13 +11,17 @@
 #if 1
 #include "configure/cmgui_configure.h"
 #endif /* defined (BUILD_WITH_CMAKE) */
+#include <stdlib.h>
 #include "command/parser.h"
 
 #include "three_d_drawing/graphics_buffer.h"
+#include "general/debug.h"
 #include "general/message.h"
 #include "general/enumerator_private.hpp"
 
 #include "graphics/render_gl.h"
+#include "graphics/texture.h"
+#include "graphics/texture_app.h"
 
 int set_Texture_storage(struct Parse_state *state,void *enum_storage_void_ptr,
 	void *dummy_user_data)
@@ -110,3 +114,63 @@ A modifier function to set the texture storage type.
 } /* set_Texture_storage */
 
 
+
+int Texture_list_storage(struct Texture *texture)
+{
+	int return_code = 0;
+
+	ENTER(Texture_list_storage);
+	if (texture)
+	{
+		int width = 0, height = 0, depth = 0;
+		Texture_get_original_size(texture, &width, &height, &depth);
+		const int number_of_components = Texture_get_number_of_components(texture);
+		const int number_of_bytes_per_component =
+			Texture_get_number_of_bytes_per_component(texture);
+		const double texture_bytes = static_cast<double>(width)*height*depth*
+			number_of_components*number_of_bytes_per_component;
+		display_message(INFORMATION_MESSAGE,
+			"  storage: %d x %d x %d texels x %d components x %d bytes = %g MB, %s\n",
+			width, height, depth, number_of_components, number_of_bytes_per_component,
+			texture_bytes/1048576.0, ENUMERATOR_STRING(Texture_compression_mode)(
+				Texture_get_compression_mode(texture)));
+		char *value = Texture_get_property(texture, TEXTURE_PROPERTY_SOURCE_BYTES);
+		if (value)
+		{
+			const double source_bytes = atof(value);
+			if (0.0 < source_bytes)
+			{
+				display_message(INFORMATION_MESSAGE,
+					"  source data: %g MB, %g MB saved (%.0f%%)\n", source_bytes/1048576.0,
+					(source_bytes - texture_bytes)/1048576.0,
+					100.0*(source_bytes - texture_bytes)/source_bytes);
+			}
+			DEALLOCATE(value);
+		}
+		char *offset = Texture_get_property(texture, TEXTURE_PROPERTY_VALUE_OFFSET);
+		char *scale = Texture_get_property(texture, TEXTURE_PROPERTY_VALUE_SCALE);
+		if (offset && scale)
+		{
+			display_message(INFORMATION_MESSAGE,
+				"  data value = %s + %s*texel\n", offset, scale);
+		}
+		if (offset)
+			DEALLOCATE(offset);
+		if (scale)
+			DEALLOCATE(scale);
+		value = Texture_get_property(texture, TEXTURE_PROPERTY_LOAD_TIME);
+		if (value)
+		{
+			display_message(INFORMATION_MESSAGE, "  loaded in %s s\n", value);
+			DEALLOCATE(value);
+		}
+		return_code = 1;
+	}
+	else
+	{
+		display_message(ERROR_MESSAGE, "Texture_list_storage.  Missing texture");
+	}
+	LEAVE;
+
+	return (return_code);
+}
@@ -28,3 +28,16 @@ int Texture_get_physical_size(struct Texture *texture,ZnReal *width,
 int Texture_get_physical_size(struct Texture *texture,float *width,
 	float *height, float *depth);
 
+/* Texture properties recording the data a texture image was loaded from */
+#define TEXTURE_PROPERTY_SOURCE_BYTES "cmgui_source_bytes"
+#define TEXTURE_PROPERTY_VALUE_OFFSET "cmgui_value_offset"
+#define TEXTURE_PROPERTY_VALUE_SCALE "cmgui_value_scale"
+#define TEXTURE_PROPERTY_LOAD_TIME "cmgui_load_time"
+
+/**
+ * Writes the size, storage and memory use of the image in <texture>, and if
+ * recorded the size of the data it was loaded from, the memory saved, the
+ * mapping from stored texels back to data values and the load time.
+ * @return  1 on success, 0 on failure.
+ */
+int Texture_list_storage(struct Texture *texture);
@@ -0,0 +1,352 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "opencmiss/zinc/element.h"
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
+#include "opencmiss/zinc/fieldfiniteelement.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/material.h"
+#include "opencmiss/zinc/mesh.h"
+#include "opencmiss/zinc/status.h"
+#include "computed_field/computed_field_app.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "general/parallel_app.hpp"
+#include "graphics/spectrum.h"
+#include "graphics/texture.h"
+#include "graphics/texture_evaluate_app.h"
+
+namespace {
+
+/** Writes <value> in [0,1] rounded to an unsigned integer of <number_of_bytes>. */
+inline unsigned char *Texture_evaluate_put_component(unsigned char *pixel,
+	double value, int number_of_bytes)
+{
+	if (value < 0.0)
+		value = 0.0;
+	else if (value > 1.0)
+		value = 1.0;
+	if (2 == number_of_bytes)
+	{
+		const unsigned short short_value = static_cast<unsigned short>(value*65535.0 + 0.5);
+		memcpy(pixel, &short_value, sizeof(unsigned short));
+		return pixel + sizeof(unsigned short);
+	}
+	*pixel = static_cast<unsigned char>(value*255.0 + 0.5);
+	return pixel + 1;
+}
+
+/**
+ * Packs <colour> RGBA into <pixel> in the component order of <storage>.
+ * @return  1 on success, 0 if storage type is not supported.
+ */
+int Texture_evaluate_put_pixel(unsigned char *pixel, const double *colour,
+	enum Texture_storage_type storage, int number_of_bytes_per_component)
+{
+	switch (storage)
+	{
+		case TEXTURE_LUMINANCE:
+		{
+			Texture_evaluate_put_component(pixel,
+				(colour[0] + colour[1] + colour[2])/3.0, number_of_bytes_per_component);
+		} break;
+		case TEXTURE_LUMINANCE_ALPHA:
+		{
+			pixel = Texture_evaluate_put_component(pixel,
+				(colour[0] + colour[1] + colour[2])/3.0, number_of_bytes_per_component);
+			Texture_evaluate_put_component(pixel, colour[3], number_of_bytes_per_component);
+		} break;
+		case TEXTURE_RGB:
+		case TEXTURE_RGBA:
+		{
+			const int number_of_components = (TEXTURE_RGB == storage) ? 3 : 4;
+			for (int c = 0; c < number_of_components; ++c)
+				pixel = Texture_evaluate_put_component(pixel, colour[c], number_of_bytes_per_component);
+		} break;
+		case TEXTURE_BGR:
+		case TEXTURE_ABGR:
+		{
+			const int first_component = (TEXTURE_BGR == storage) ? 2 : 3;
+			for (int c = first_component; c >= 0; --c)
+				pixel = Texture_evaluate_put_component(pixel, colour[c], number_of_bytes_per_component);
+		} break;
+		default:
+		{
+			return 0;
+		} break;
+	}
+	return 1;
+}
+
+/**
+ * Evaluates <field> into <values> for the pixels at <pixel_order> positions
+ * <begin> to <end> using <field_cache>, setting <evaluated> for each pixel.
+ * The location of each pixel is its texture coordinates in <targets> if
+ * <elements> is 0, otherwise its element and xi; pixels with no element are
+ * not evaluated. This is the one per-pixel routine for any number of threads.
+ */
+void Texture_evaluate_pixels(cmzn_fieldcache_id field_cache, cmzn_field_id field,
+	int number_of_components, cmzn_field_id texture_coordinate_field,
+	int number_of_texture_coordinates, const double *targets,
+	const cmzn_element_id *elements, const double *xi, int mesh_dimension,
+	const int *pixel_order, int begin, int end, double *values, char *evaluated)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		const int p = (pixel_order) ? pixel_order[i] : i;
+		if (elements)
+		{
+			if (!elements[p])
+			{
+				evaluated[p] = 0;
+				continue;
+			}
+			cmzn_fieldcache_set_mesh_location(field_cache, elements[p], mesh_dimension,
+				xi + static_cast<size_t>(p)*3);
+		}
+		else
+		{
+			cmzn_fieldcache_set_field_real(field_cache, texture_coordinate_field,
+				number_of_texture_coordinates, targets + static_cast<size_t>(p)*number_of_texture_coordinates);
+		}
+		evaluated[p] = (CMZN_OK == cmzn_field_evaluate_real(field, field_cache,
+			number_of_components, values + static_cast<size_t>(p)*number_of_components));
+	}
+}
+
+} // anonymous namespace
+
+int Texture_evaluate_image_from_field_threaded(struct Texture *texture,
+	cmzn_field_id field, cmzn_field_id texture_coordinate_field,
+	int use_pixel_location, struct cmzn_spectrum *spectrum,
+	cmzn_material_id fail_material, cmzn_mesh_id search_mesh,
+	enum Texture_storage_type storage, int image_width, int image_height,
+	int image_depth, int number_of_bytes_per_component, double texture_width,
+	double texture_height, double texture_depth, int number_of_threads)
+{
+	const int number_of_components = (field) ? cmzn_field_get_number_of_components(field) : 0;
+	const int number_of_texture_coordinates = (texture_coordinate_field) ?
+		cmzn_field_get_number_of_components(texture_coordinate_field) : 0;
+	if (!(texture && (0 < number_of_components) && (0 < number_of_texture_coordinates) &&
+		(3 >= number_of_texture_coordinates) && spectrum &&
+		(use_pixel_location || search_mesh) &&
+		(0 < image_width) && (0 < image_height) && (0 < image_depth) &&
+		((1 == number_of_bytes_per_component) || (2 == number_of_bytes_per_component))))
+	{
+		display_message(ERROR_MESSAGE,
+			"Texture_evaluate_image_from_field_threaded.  Invalid argument(s)");
+		return 0;
+	}
+	double fail_colour[4] = { 0.0, 0.0, 0.0, 0.0 };
+	if (fail_material)
+	{
+		cmzn_material_get_attribute_real3(fail_material,
+			CMZN_MATERIAL_ATTRIBUTE_DIFFUSE, fail_colour);
+		fail_colour[3] = cmzn_material_get_attribute_real(fail_material,
+			CMZN_MATERIAL_ATTRIBUTE_ALPHA);
+	}
+	const int bytes_per_pixel = number_of_bytes_per_component*
+		Texture_storage_type_get_number_of_components(storage);
+	const int number_of_pixels = image_width*image_height;
+	/* element field evaluation is not safe on several threads, so only pixel
+	 * locations with node-local fields are evaluated in parallel */
+	if (!(use_pixel_location && cmzn_field_is_node_local(field)))
+		number_of_threads = 1;
+	number_of_threads = cmgui_get_number_of_threads_for_items(number_of_threads, image_height);
+	cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(field);
+	/* caches are created here as field module objects are not thread safe */
+	std::vector<cmzn_fieldcache_id> field_caches(number_of_threads);
+	for (int t = 0; t < number_of_threads; ++t)
+		field_caches[t] = cmzn_fieldmodule_create_fieldcache(field_module);
+	const int mesh_dimension = (search_mesh) ? cmzn_mesh_get_dimension(search_mesh) : 0;
+	/* locations are found by Zinc on the main thread as in the serial path */
+	cmzn_field_id find_mesh_location_field = (use_pixel_location) ? 0 :
+		cmzn_fieldmodule_create_field_find_mesh_location(field_module,
+			texture_coordinate_field, texture_coordinate_field, search_mesh);
+	std::vector<double> targets(static_cast<size_t>(number_of_pixels)*number_of_texture_coordinates);
+	std::vector<double> values(static_cast<size_t>(number_of_pixels)*number_of_components);
+	std::vector<char> evaluated(number_of_pixels);
+	std::vector<unsigned char> plane(static_cast<size_t>(number_of_pixels)*bytes_per_pixel);
+	std::vector<cmzn_element_id> elements((use_pixel_location) ? 0 : number_of_pixels,
+		static_cast<cmzn_element_id>(0));
+	std::vector<double> xi((use_pixel_location) ? 0 : static_cast<size_t>(number_of_pixels)*3, 0.0);
+	std::vector<int> pixel_order;
+	std::vector<int> range_starts;
+	const double texture_sizes[3] = { texture_width, texture_height, texture_depth };
+	const int image_sizes[3] = { image_width, image_height, image_depth };
+	int return_code = (use_pixel_location || find_mesh_location_field) ? 1 : 0;
+	for (int k = 0; (k < image_depth) && return_code; ++k)
+	{
+		/* pixel centres in texture coordinates */
+		for (int j = 0; j < image_height; ++j)
+		{
+			for (int i = 0; i < image_width; ++i)
+			{
+				const int pixel_indexes[3] = { i, j, k };
+				double *target = targets.data() +
+					(static_cast<size_t>(j)*image_width + i)*number_of_texture_coordinates;
+				for (int c = 0; c < number_of_texture_coordinates; ++c)
+					target[c] = texture_sizes[c]*(static_cast<double>(pixel_indexes[c]) + 0.5)/
+						static_cast<double>(image_sizes[c]);
+			}
+		}
+		range_starts.clear();
+		if (use_pixel_location)
+		{
+			/* split by rows */
+			for (int j = 0; j < image_height; ++j)
+				range_starts.push_back(j*image_width);
+		}
+		else
+		{
+			cmzn_fieldcache_id field_cache = field_caches[0];
+			for (int p = 0; p < number_of_pixels; ++p)
+			{
+				cmzn_fieldcache_set_field_real(field_cache, texture_coordinate_field,
+					number_of_texture_coordinates, targets.data() + static_cast<size_t>(p)*number_of_texture_coordinates);
+				elements[p] = cmzn_field_evaluate_mesh_location(find_mesh_location_field,
+					field_cache, mesh_dimension, xi.data() + static_cast<size_t>(p)*3);
+			}
+			/* evaluate pixels grouped by element so element values are reused */
+			pixel_order.resize(number_of_pixels);
+			for (int p = 0; p < number_of_pixels; ++p)
+				pixel_order[p] = p;
+			std::stable_sort(pixel_order.begin(), pixel_order.end(), [&elements](int a, int b)
+				{
+					return elements[a] < elements[b];
+				});
+			for (int i = 0; i < number_of_pixels; ++i)
+			{
+				if ((0 == i) || (elements[pixel_order[i]] != elements[pixel_order[i - 1]]))
+					range_starts.push_back(i);
+			}
+		}
+		const int number_of_ranges = static_cast<int>(range_starts.size());
+		range_starts.push_back(number_of_pixels);
+		cmgui_parallel_for_ranges(number_of_ranges, number_of_threads,
+			[&](int thread_index, int begin, int end)
+		{
+			Texture_evaluate_pixels(field_caches[thread_index], field, number_of_components,
+				texture_coordinate_field, number_of_texture_coordinates, targets.data(),
+				(use_pixel_location) ? 0 : elements.data(), xi.data(), mesh_dimension,
+				(use_pixel_location) ? 0 : pixel_order.data(),
+				range_starts[begin], range_starts[end], values.data(), evaluated.data());
+		});
+		if (!use_pixel_location)
+		{
+			for (int p = 0; p < number_of_pixels; ++p)
+				cmzn_element_destroy(&elements[p]);
+		}
+		/* spectrum is applied serially as its render state is shared */
+		double colour[4];
+		ZnReal rgba[4];
+		for (int p = 0; (p < number_of_pixels) && return_code; ++p)
+		{
+			if (evaluated[p] && Spectrum_value_to_rgba(spectrum, number_of_components,
+				values.data() + static_cast<size_t>(p)*number_of_components, rgba))
+			{
+				for (int c = 0; c < 4; ++c)
+					colour[c] = static_cast<double>(rgba[c]);
+			}
+			else
+			{
+				for (int c = 0; c < 4; ++c)
+					colour[c] = fail_colour[c];
+			}
+			if (!Texture_evaluate_put_pixel(plane.data() + static_cast<size_t>(p)*bytes_per_pixel,
+				colour, storage, number_of_bytes_per_component))
+			{
+				display_message(ERROR_MESSAGE, "Texture_evaluate_image_from_field_threaded.  "
+					"Unsupported texture storage type");
+				return_code = 0;
+			}
+		}
+		if (return_code && !Texture_set_image_block(texture, /*left*/0, /*bottom*/0,
+			image_width, image_height, /*depth_plane*/k, image_width*bytes_per_pixel, plane.data()))
+		{
+			display_message(ERROR_MESSAGE, "Texture_evaluate_image_from_field_threaded.  "
+				"Could not set image plane %d", k);
+			return_code = 0;
+		}
+	}
+	cmzn_field_destroy(&find_mesh_location_field);
+	for (int t = 0; t < number_of_threads; ++t)
+		cmzn_fieldcache_destroy(&field_caches[t]);
+	cmzn_fieldmodule_destroy(&field_module);
+	return (return_code);
+}
+
+int Texture_evaluate_compare_images(struct Texture *texture,
+	struct Texture *reference_texture)
+{
+	int width = 0, height = 0, depth = 0;
+	int reference_width = 0, reference_height = 0, reference_depth = 0;
+	if (texture && reference_texture)
+	{
+		Texture_get_original_size(texture, &width, &height, &depth);
+		Texture_get_original_size(reference_texture, &reference_width, &reference_height, &reference_depth);
+	}
+	const int bytes_per_pixel = (texture) ? Texture_get_number_of_components(texture)*
+		Texture_get_number_of_bytes_per_component(texture) : 0;
+	if (!(texture && reference_texture && (width == reference_width) &&
+		(height == reference_height) && (depth == reference_depth) && (0 < bytes_per_pixel) &&
+		(bytes_per_pixel == Texture_get_number_of_components(reference_texture)*
+			Texture_get_number_of_bytes_per_component(reference_texture))))
+	{
+		display_message(ERROR_MESSAGE,
+			"Texture_evaluate_compare_images.  Invalid argument(s)");
+		return 0;
+	}
+	/* up to 4 components of 2 bytes */
+	unsigned char pixel[8], reference_pixel[8];
+	double number_of_different_pixels = 0.0;
+	int maximum_byte_difference = 0;
+	int first_difference[3] = { -1, -1, -1 };
+	for (int k = 0; k < depth; ++k)
+	{
+		for (int j = 0; j < height; ++j)
+		{
+			for (int i = 0; i < width; ++i)
+			{
+				Texture_get_raw_pixel_values(texture, i, j, k, pixel);
+				Texture_get_raw_pixel_values(reference_texture, i, j, k, reference_pixel);
+				if (0 != memcmp(pixel, reference_pixel, bytes_per_pixel))
+				{
+					if (0.0 == number_of_different_pixels)
+					{
+						first_difference[0] = i;
+						first_difference[1] = j;
+						first_difference[2] = k;
+					}
+					number_of_different_pixels += 1.0;
+					for (int b = 0; b < bytes_per_pixel; ++b)
+					{
+						const int byte_difference = abs(static_cast<int>(pixel[b]) - static_cast<int>(reference_pixel[b]));
+						if (byte_difference > maximum_byte_difference)
+							maximum_byte_difference = byte_difference;
+					}
+				}
+			}
+		}
+	}
+	if (0.0 == number_of_different_pixels)
+	{
+		display_message(INFORMATION_MESSAGE,
+			"Texture image is identical to the serial image\n");
+		return 1;
+	}
+	display_message(WARNING_MESSAGE,
+		"Texture image differs from the serial image in %g of %g pixels, "
+		"first at %d %d %d, by up to %d in a byte",
+		number_of_different_pixels, static_cast<double>(width)*height*depth,
+		first_difference[0], first_difference[1], first_difference[2], maximum_byte_difference);
+	return 0;
+}
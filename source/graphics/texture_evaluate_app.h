@@ -0,0 +1,49 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#if !defined (TEXTURE_EVALUATE_APP_H)
+#define TEXTURE_EVALUATE_APP_H
+
+#include "opencmiss/zinc/types/fieldid.h"
+#include "opencmiss/zinc/types/materialid.h"
+#include "opencmiss/zinc/types/meshid.h"
+#include "graphics/texture.h"
+
+struct cmzn_spectrum;
+
+/**
+ * Fills the already allocated image of <texture> by evaluating <field> at each
+ * pixel and converting the values to colours with <spectrum>. With
+ * <use_pixel_location> and a node-local <field> each depth plane is split by
+ * rows between <number_of_threads> (0 = hardware threads) with their own field
+ * caches; with a <search_mesh> or fields which may evaluate in elements,
+ * pixels are evaluated on the calling thread, grouped by element. Every pixel
+ * is evaluated by the same routine. With <use_pixel_location> the pixel
+ * coordinates are set directly for <texture_coordinate_field>, otherwise the
+ * location in <search_mesh> with those texture coordinates is found with a
+ * Zinc find_mesh_location field on the calling thread. Pixels not found or not
+ * evaluated take the diffuse colour and alpha of <fail_material>. Colours are
+ * rounded to the nearest stored value.
+ * @return  1 on success, 0 on failure.
+ */
+int Texture_evaluate_image_from_field_threaded(struct Texture *texture,
+	cmzn_field_id field, cmzn_field_id texture_coordinate_field,
+	int use_pixel_location, struct cmzn_spectrum *spectrum,
+	cmzn_material_id fail_material, cmzn_mesh_id search_mesh,
+	enum Texture_storage_type storage, int image_width, int image_height,
+	int image_depth, int number_of_bytes_per_component, double texture_width,
+	double texture_height, double texture_depth, int number_of_threads);
+
+/**
+ * Compares the image in <texture> byte by byte with that in
+ * <reference_texture>, which must have the same size and pixel format, and
+ * reports whether they are identical or how many pixels differ.
+ * @return  1 if identical, 0 if they differ or on error.
+ */
+int Texture_evaluate_compare_images(struct Texture *texture,
+	struct Texture *reference_texture);
+
+#endif /* !defined (TEXTURE_EVALUATE_APP_H) */
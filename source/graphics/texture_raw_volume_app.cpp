@@ -0,0 +1,496 @@
+/**
+ * FILE : texture_raw_volume_app.cpp
+ *
+ * Loads headerless binary volumes into textures through a read-only memory
+ * map of the file, one slice at a time.
+ */
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "configure/cmgui_configure.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#if defined (WIN32_SYSTEM)
+#  include <windows.h>
+#else /* defined (WIN32_SYSTEM) */
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif /* defined (WIN32_SYSTEM) */
+#include "general/debug.h"
+#include "general/message.h"
+#include "graphics/texture.h"
+#include "graphics/texture_app.h"
+#include "graphics/texture_raw_volume_app.hpp"
+
+const char *Raw_volume_component_type_string(enum Raw_volume_component_type component_type)
+{
+	switch (component_type)
+	{
+		case RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR:
+			return "unsigned_char";
+		case RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_SHORT:
+			return "unsigned_short";
+		case RAW_VOLUME_COMPONENT_TYPE_SHORT:
+			return "short";
+		case RAW_VOLUME_COMPONENT_TYPE_FLOAT:
+			return "float";
+		case RAW_VOLUME_COMPONENT_TYPE_INVALID:
+			break;
+	}
+	return 0;
+}
+
+int Raw_volume_component_type_get_size(enum Raw_volume_component_type component_type)
+{
+	switch (component_type)
+	{
+		case RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR:
+			return 1;
+		case RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_SHORT:
+		case RAW_VOLUME_COMPONENT_TYPE_SHORT:
+			return 2;
+		case RAW_VOLUME_COMPONENT_TYPE_FLOAT:
+			return 4;
+		case RAW_VOLUME_COMPONENT_TYPE_INVALID:
+			break;
+	}
+	return 0;
+}
+
+Raw_volume_file_map::Raw_volume_file_map() :
+	data(0),
+	size(0),
+#if defined (WIN32_SYSTEM)
+	file_handle(INVALID_HANDLE_VALUE),
+	mapping_handle(0)
+#else /* defined (WIN32_SYSTEM) */
+	file_descriptor(-1)
+#endif /* defined (WIN32_SYSTEM) */
+{
+}
+
+Raw_volume_file_map *Raw_volume_file_map::create(const char *file_name)
+{
+	if (!file_name)
+	{
+		display_message(ERROR_MESSAGE, "Raw_volume_file_map::create.  Missing file name");
+		return 0;
+	}
+	Raw_volume_file_map *map = new Raw_volume_file_map();
+#if defined (WIN32_SYSTEM)
+	map->file_handle = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER file_size;
+	if ((INVALID_HANDLE_VALUE != map->file_handle) &&
+		GetFileSizeEx(map->file_handle, &file_size) && (0 < file_size.QuadPart))
+	{
+		map->size = static_cast<size_t>(file_size.QuadPart);
+		map->mapping_handle = CreateFileMappingA(map->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (map->mapping_handle)
+		{
+			map->data = static_cast<const unsigned char *>(
+				MapViewOfFile(map->mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+#else /* defined (WIN32_SYSTEM) */
+	map->file_descriptor = open(file_name, O_RDONLY);
+	struct stat file_status;
+	if ((0 <= map->file_descriptor) && (0 == fstat(map->file_descriptor, &file_status)) &&
+		(0 < file_status.st_size))
+	{
+		map->size = static_cast<size_t>(file_status.st_size);
+		void *address = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, map->file_descriptor, 0);
+		if (MAP_FAILED != address)
+		{
+			map->data = static_cast<const unsigned char *>(address);
+			posix_madvise(address, map->size, POSIX_MADV_SEQUENTIAL);
+		}
+	}
+#endif /* defined (WIN32_SYSTEM) */
+	if (!map->data)
+	{
+		display_message(ERROR_MESSAGE,
+			"Raw_volume_file_map::create.  Could not map file '%s'", file_name);
+		delete map;
+		return 0;
+	}
+	return map;
+}
+
+Raw_volume_file_map::~Raw_volume_file_map()
+{
+#if defined (WIN32_SYSTEM)
+	if (this->data)
+		UnmapViewOfFile(this->data);
+	if (this->mapping_handle)
+		CloseHandle(this->mapping_handle);
+	if (INVALID_HANDLE_VALUE != this->file_handle)
+		CloseHandle(this->file_handle);
+#else /* defined (WIN32_SYSTEM) */
+	if (this->data)
+		munmap(const_cast<unsigned char *>(this->data), this->size);
+	if (0 <= this->file_descriptor)
+		close(this->file_descriptor);
+#endif /* defined (WIN32_SYSTEM) */
+}
+
+void Raw_volume_file_map::release(size_t offset, size_t length) const
+{
+#if defined (WIN32_SYSTEM)
+	USE_PARAMETER(offset);
+	USE_PARAMETER(length);
+#else /* defined (WIN32_SYSTEM) */
+	if ((!this->data) || (offset >= this->size))
+		return;
+	if (length > this->size - offset)
+		length = this->size - offset;
+	/* only whole pages inside the range may be released */
+	const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t begin = ((offset + page_size - 1)/page_size)*page_size;
+	const size_t end = ((offset + length)/page_size)*page_size;
+	if (begin < end)
+	{
+		posix_madvise(const_cast<unsigned char *>(this->data) + begin, end - begin,
+			POSIX_MADV_DONTNEED);
+	}
+#endif /* defined (WIN32_SYSTEM) */
+}
+
+namespace {
+
+/** @return  Component <index> of <source> converted to double. */
+inline double Raw_volume_get_component(const unsigned char *source, size_t index,
+	enum Raw_volume_component_type component_type, bool swap_bytes)
+{
+	const int size = Raw_volume_component_type_get_size(component_type);
+	unsigned char bytes[4];
+	for (int b = 0; b < size; ++b)
+		bytes[b] = source[index*size + (swap_bytes ? (size - 1 - b) : b)];
+	switch (component_type)
+	{
+		case RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR:
+			return static_cast<double>(bytes[0]);
+		case RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			unsigned short value;
+			memcpy(&value, bytes, sizeof(value));
+			return static_cast<double>(value);
+		}
+		case RAW_VOLUME_COMPONENT_TYPE_SHORT:
+		{
+			short value;
+			memcpy(&value, bytes, sizeof(value));
+			return static_cast<double>(value);
+		}
+		case RAW_VOLUME_COMPONENT_TYPE_FLOAT:
+		{
+			float value;
+			memcpy(&value, bytes, sizeof(value));
+			return static_cast<double>(value);
+		}
+		case RAW_VOLUME_COMPONENT_TYPE_INVALID:
+			break;
+	}
+	return 0.0;
+}
+
+inline bool Raw_volume_is_host_big_endian()
+{
+	const unsigned short one = 1;
+	return (0 == *reinterpret_cast<const unsigned char *>(&one));
+}
+
+}
+
+int Raw_volume_subvolume_get_level_size(const struct Raw_volume_subvolume &subvolume,
+	int level, int size[3])
+{
+	if ((level < 0) || (30 < level))
+		return 0;
+	const int factor = 1 << level;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (subvolume.size[i] <= 0)
+			return 0;
+		size[i] = (subvolume.size[i] + factor - 1)/factor;
+	}
+	return 1;
+}
+
+int Texture_set_image_from_raw_volume(struct Texture *texture,
+	const char *file_name, const struct Raw_volume_format &format,
+	const struct Raw_volume_subvolume *subvolume_in)
+{
+	const int component_size = Raw_volume_component_type_get_size(format.component_type);
+	if (!(texture && file_name && (0 < format.width) && (0 < format.height) &&
+		(0 < format.depth) && (1 <= format.number_of_components) &&
+		(format.number_of_components <= 4) && (0 < component_size)))
+	{
+		display_message(ERROR_MESSAGE,
+			"Texture_set_image_from_raw_volume.  Invalid argument(s)");
+		return 0;
+	}
+	const int volume_size[3] = { format.width, format.height, format.depth };
+	struct Raw_volume_subvolume subvolume = { { 0, 0, 0 }, { 0, 0, 0 }, 0, 0 };
+	if (subvolume_in)
+		subvolume = *subvolume_in;
+	for (int i = 0; i < 3; ++i)
+	{
+		if (subvolume.size[i] <= 0)
+			subvolume.size[i] = volume_size[i] - subvolume.origin[i];
+		if ((subvolume.origin[i] < 0) || (subvolume.size[i] <= 0) ||
+			(subvolume.origin[i] + subvolume.size[i] > volume_size[i]))
+		{
+			display_message(ERROR_MESSAGE, "Texture_set_image_from_raw_volume.  "
+				"Subvolume is outside the %d x %d x %d volume", format.width,
+				format.height, format.depth);
+			return 0;
+		}
+	}
+	const int texture_bytes_per_component = (0 < format.texture_bytes_per_component) ?
+		format.texture_bytes_per_component :
+		((RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR == format.component_type) ? 1 : 2);
+	if (2 < texture_bytes_per_component)
+	{
+		display_message(ERROR_MESSAGE, "Texture_set_image_from_raw_volume.  "
+			"Texture must have 1 or 2 bytes per component");
+		return 0;
+	}
+	int level = subvolume.level;
+	int texture_size[3];
+	if (level < 0)
+	{
+		/* coarsest level needed to fit the budget, stopping at a single voxel */
+		level = 0;
+		while (Raw_volume_subvolume_get_level_size(subvolume, level, texture_size) &&
+			(subvolume.memory_budget < static_cast<size_t>(texture_size[0])*texture_size[1]*
+				texture_size[2]*format.number_of_components*texture_bytes_per_component) &&
+			((1 < texture_size[0]) || (1 < texture_size[1]) || (1 < texture_size[2])))
+		{
+			++level;
+		}
+	}
+	if (!Raw_volume_subvolume_get_level_size(subvolume, level, texture_size))
+	{
+		display_message(ERROR_MESSAGE,
+			"Texture_set_image_from_raw_volume.  Invalid level %d", level);
+		return 0;
+	}
+	const int factor = 1 << level;
+	const auto start_time = std::chrono::steady_clock::now();
+	Raw_volume_file_map *map = Raw_volume_file_map::create(file_name);
+	if (!map)
+		return 0;
+	const size_t number_of_components = static_cast<size_t>(format.number_of_components);
+	const size_t row_components = static_cast<size_t>(format.width)*number_of_components;
+	const size_t slice_components = row_components*format.height;
+	const size_t slice_bytes = slice_components*component_size;
+	const size_t volume_bytes = slice_bytes*format.depth;
+	if ((format.header_offset > map->get_size()) ||
+		(volume_bytes > map->get_size() - format.header_offset))
+	{
+		display_message(ERROR_MESSAGE, "Texture_set_image_from_raw_volume.  "
+			"File '%s' has %.0f bytes, too few for a %d x %d x %d volume of %d %s "
+			"components per voxel after %.0f header bytes", file_name,
+			static_cast<double>(map->get_size()), format.width, format.height,
+			format.depth, format.number_of_components,
+			Raw_volume_component_type_string(format.component_type),
+			static_cast<double>(format.header_offset));
+		delete map;
+		return 0;
+	}
+	const unsigned char *volume = map->get_data() + format.header_offset;
+	const bool swap_bytes = (1 < component_size) &&
+		(format.big_endian != Raw_volume_is_host_big_endian());
+	/* offset in components of the first subvolume voxel in each slice, and
+	 * the number of components in one row of the subvolume */
+	const size_t origin_components =
+		(static_cast<size_t>(subvolume.origin[1])*format.width + subvolume.origin[0])*number_of_components;
+	const size_t subvolume_row_components =
+		static_cast<size_t>(subvolume.size[0])*number_of_components;
+	double minimum = format.minimum;
+	double maximum = format.maximum;
+	/* values are mapped from the range unless they fit the texture components */
+	const bool scaled = (RAW_VOLUME_COMPONENT_TYPE_SHORT == format.component_type) ||
+		(RAW_VOLUME_COMPONENT_TYPE_FLOAT == format.component_type) ||
+		(component_size > texture_bytes_per_component);
+	if (scaled && (minimum == maximum))
+	{
+		/* extra pass over the mapped subvolume to find the data range */
+		minimum = maximum = Raw_volume_get_component(volume + subvolume.origin[2]*slice_bytes,
+			origin_components, format.component_type, swap_bytes);
+		for (int k = subvolume.origin[2]; k < subvolume.origin[2] + subvolume.size[2]; ++k)
+		{
+			const unsigned char *slice = volume + k*slice_bytes;
+			for (int j = 0; j < subvolume.size[1]; ++j)
+			{
+				const size_t row_start = origin_components + j*row_components;
+				for (size_t i = 0; i < subvolume_row_components; ++i)
+				{
+					const double value = Raw_volume_get_component(slice, row_start + i,
+						format.component_type, swap_bytes);
+					if (value < minimum)
+						minimum = value;
+					else if (value > maximum)
+						maximum = value;
+				}
+			}
+			map->release(format.header_offset + k*slice_bytes, slice_bytes);
+		}
+		if (minimum == maximum)
+			maximum = minimum + 1.0;
+	}
+	enum Texture_storage_type storage = TEXTURE_LUMINANCE;
+	switch (format.number_of_components)
+	{
+		case 2:
+			storage = TEXTURE_LUMINANCE_ALPHA;
+			break;
+		case 3:
+			storage = TEXTURE_RGB;
+			break;
+		case 4:
+			storage = TEXTURE_RGBA;
+			break;
+	}
+	/* properties of any previous image no longer describe the texture */
+	Texture_clear_all_properties(texture);
+	int return_code = Texture_allocate_image(texture, texture_size[0], texture_size[1],
+		texture_size[2], storage, texture_bytes_per_component, file_name);
+	if (!return_code)
+	{
+		display_message(ERROR_MESSAGE, "Texture_set_image_from_raw_volume.  "
+			"Could not allocate %d x %d x %d texture image", texture_size[0],
+			texture_size[1], texture_size[2]);
+	}
+	const size_t texture_row_components = static_cast<size_t>(texture_size[0])*number_of_components;
+	const size_t texture_slice_components = texture_row_components*texture_size[1];
+	const int texture_row_bytes = static_cast<int>(texture_row_components*texture_bytes_per_component);
+	const double maximum_value = (1 == texture_bytes_per_component) ? 255.0 : 65535.0;
+	/* unsigned char widened to 2 bytes is scaled by 65535/255 */
+	const double scale = scaled ? maximum_value/(maximum - minimum) :
+		((component_size < texture_bytes_per_component) ? 257.0 : 1.0);
+	/* 1-byte and native unsigned short full resolution slices are passed
+	 * straight from the map, using the file row length as the source stride */
+	if ((0 == level) && (!scaled) && (!swap_bytes) &&
+		(component_size == texture_bytes_per_component))
+	{
+		for (int k = 0; return_code && (k < texture_size[2]); ++k)
+		{
+			const int file_slice = subvolume.origin[2] + k;
+			const unsigned char *source = volume + file_slice*slice_bytes +
+				origin_components*component_size;
+			if (!Texture_set_image_block(texture, /*left*/0, /*bottom*/0, texture_size[0],
+				texture_size[1], /*depth_plane*/k, static_cast<int>(row_components*component_size),
+				const_cast<unsigned char *>(source)))
+			{
+				display_message(ERROR_MESSAGE,
+					"Texture_set_image_from_raw_volume.  Could not set image slice %d", k);
+				return_code = 0;
+			}
+			map->release(format.header_offset + file_slice*slice_bytes, slice_bytes);
+		}
+	}
+	else
+	{
+		/* each texture slice is the average over bricks of factor^3 voxels, or
+		 * fewer at the far edges, accumulated from one file slice at a time */
+		std::vector<double> sums(return_code ? texture_slice_components : 0);
+		std::vector<unsigned char> slice_bytes_out(return_code ?
+			texture_slice_components*texture_bytes_per_component : 0);
+		for (int k = 0; return_code && (k < texture_size[2]); ++k)
+		{
+			std::fill(sums.begin(), sums.end(), 0.0);
+			const int z_begin = subvolume.origin[2] + k*factor;
+			int z_end = z_begin + factor;
+			if (z_end > subvolume.origin[2] + subvolume.size[2])
+				z_end = subvolume.origin[2] + subvolume.size[2];
+			for (int z = z_begin; z < z_end; ++z)
+			{
+				const unsigned char *slice = volume + z*slice_bytes;
+				for (int j = 0; j < subvolume.size[1]; ++j)
+				{
+					const size_t row_start = origin_components + j*row_components;
+					double *sum_row = sums.data() + (j/factor)*texture_row_components;
+					for (int i = 0; i < subvolume.size[0]; ++i)
+					{
+						double *sum = sum_row + (i/factor)*number_of_components;
+						for (size_t c = 0; c < number_of_components; ++c)
+						{
+							sum[c] += Raw_volume_get_component(slice,
+								row_start + i*number_of_components + c, format.component_type, swap_bytes);
+						}
+					}
+				}
+				map->release(format.header_offset + z*slice_bytes, slice_bytes);
+			}
+			for (int j = 0; j < texture_size[1]; ++j)
+			{
+				const int count_y = ((j + 1)*factor <= subvolume.size[1]) ? factor : (subvolume.size[1] - j*factor);
+				for (int i = 0; i < texture_size[0]; ++i)
+				{
+					const int count_x = ((i + 1)*factor <= subvolume.size[0]) ? factor : (subvolume.size[0] - i*factor);
+					const double count = static_cast<double>(count_x*count_y*(z_end - z_begin));
+					const size_t index = j*texture_row_components + i*number_of_components;
+					for (size_t c = 0; c < number_of_components; ++c)
+					{
+						double value = sums[index + c]/count;
+						value = scaled ? (value - minimum)*scale : value*scale;
+						value = (value < 0.0) ? 0.0 : ((value > maximum_value) ? maximum_value : value + 0.5);
+						if (1 == texture_bytes_per_component)
+						{
+							slice_bytes_out[index + c] = static_cast<unsigned char>(value);
+						}
+						else
+						{
+							const unsigned short short_value = static_cast<unsigned short>(value);
+							memcpy(slice_bytes_out.data() + 2*(index + c), &short_value, 2);
+						}
+					}
+				}
+			}
+			if (!Texture_set_image_block(texture, /*left*/0, /*bottom*/0, texture_size[0],
+				texture_size[1], /*depth_plane*/k, texture_row_bytes, slice_bytes_out.data()))
+			{
+				display_message(ERROR_MESSAGE,
+					"Texture_set_image_from_raw_volume.  Could not set image slice %d", k);
+				return_code = 0;
+			}
+		}
+	}
+	delete map;
+	if (return_code)
+	{
+		const double load_time =
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		const double source_bytes = static_cast<double>(subvolume.size[0])*subvolume.size[1]*
+			subvolume.size[2]*number_of_components*component_size;
+		const double texture_bytes = static_cast<double>(texture_slice_components)*
+			texture_size[2]*texture_bytes_per_component;
+		/* record how stored values map back to the source for gfx list texture */
+		char value_string[50];
+		sprintf(value_string, "%.17g", source_bytes);
+		Texture_set_property(texture, TEXTURE_PROPERTY_SOURCE_BYTES, value_string);
+		sprintf(value_string, "%.17g", scaled ? minimum : 0.0);
+		Texture_set_property(texture, TEXTURE_PROPERTY_VALUE_OFFSET, value_string);
+		sprintf(value_string, "%.17g", 1.0/scale);
+		Texture_set_property(texture, TEXTURE_PROPERTY_VALUE_SCALE, value_string);
+		sprintf(value_string, "%g", load_time);
+		Texture_set_property(texture, TEXTURE_PROPERTY_LOAD_TIME, value_string);
+		display_message(INFORMATION_MESSAGE,
+			"Loaded %d x %d x %d texture at level %d from %d x %d x %d voxels of %s "
+			"in %g s; %g MB stored for %g MB of source data\n",
+			texture_size[0], texture_size[1], texture_size[2], level,
+			subvolume.size[0], subvolume.size[1], subvolume.size[2], file_name,
+			load_time, texture_bytes/1048576.0, source_bytes/1048576.0);
+	}
+	return return_code;
+}
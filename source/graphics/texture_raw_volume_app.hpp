@@ -0,0 +1,136 @@
+/**
+ * FILE : texture_raw_volume_app.hpp
+ *
+ * Loads headerless binary volumes into textures through a read-only memory
+ * map of the file, one slice at a time.
+ */
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#if !defined (GRAPHICS_TEXTURE_RAW_VOLUME_APP_HPP)
+#define GRAPHICS_TEXTURE_RAW_VOLUME_APP_HPP
+
+#include <stddef.h>
+#include "configure/cmgui_configure.h"
+
+struct Texture;
+
+enum Raw_volume_component_type
+{
+	RAW_VOLUME_COMPONENT_TYPE_INVALID = 0,
+	RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_CHAR = 1,
+	RAW_VOLUME_COMPONENT_TYPE_UNSIGNED_SHORT = 2,
+	RAW_VOLUME_COMPONENT_TYPE_SHORT = 3,
+	RAW_VOLUME_COMPONENT_TYPE_FLOAT = 4
+};
+
+/** @return  Static name of <component_type> as used in commands, or 0 if invalid. */
+const char *Raw_volume_component_type_string(enum Raw_volume_component_type component_type);
+
+/** @return  Number of bytes in one component of <component_type>, or 0 if invalid. */
+int Raw_volume_component_type_get_size(enum Raw_volume_component_type component_type);
+
+/** Layout of a raw volume file: voxels x fastest, then y, then z. */
+struct Raw_volume_format
+{
+	int width, height, depth;
+	/* interleaved components per voxel, 1 to 4 */
+	int number_of_components;
+	enum Raw_volume_component_type component_type;
+	bool big_endian;
+	/* bytes to skip at the start of the file */
+	size_t header_offset;
+	/* bytes per texture component, 1 or 2, or 0 for 1 for unsigned char and 2
+	 * for other types */
+	int texture_bytes_per_component;
+	/* values mapped to the full texture component range for short and float
+	 * components, or for unsigned short in 1 byte; if equal the range of the
+	 * data is used */
+	double minimum, maximum;
+};
+
+/**
+ * Read-only memory map of a whole file. Pages are read from the file when first
+ * accessed and may be released again once no longer needed.
+ */
+class Raw_volume_file_map
+{
+	const unsigned char *data;
+	size_t size;
+#if defined (WIN32_SYSTEM)
+	void *file_handle, *mapping_handle;
+#else /* defined (WIN32_SYSTEM) */
+	int file_descriptor;
+#endif /* defined (WIN32_SYSTEM) */
+
+	Raw_volume_file_map();
+
+public:
+
+	/** @return  New map of <file_name>, or 0 with an error message on failure. */
+	static Raw_volume_file_map *create(const char *file_name);
+
+	~Raw_volume_file_map();
+
+	const unsigned char *get_data() const
+	{
+		return this->data;
+	}
+
+	size_t get_size() const
+	{
+		return this->size;
+	}
+
+	/**
+	 * Hints that the <length> bytes from <offset> are no longer needed so their
+	 * pages need not stay resident. Has no effect where unsupported.
+	 */
+	void release(size_t offset, size_t length) const;
+};
+
+/**
+ * Brick of a raw volume to load into a texture and the pyramid level to load it
+ * at. Each level halves the resolution in every direction, each texture voxel
+ * being the average of a brick of 2^level voxels on a side.
+ */
+struct Raw_volume_subvolume
+{
+	/* first voxel in x, y and z */
+	int origin[3];
+	/* voxels in x, y and z, 0 for the rest of the volume */
+	int size[3];
+	/* pyramid level, or -1 for the finest level fitting memory_budget */
+	int level;
+	/* maximum bytes in the texture image when choosing the level */
+	size_t memory_budget;
+};
+
+/**
+ * Gets the texture <size> of <subvolume>, which must have all sizes set, at
+ * pyramid <level>.
+ * @return  1 on success, 0 if invalid.
+ */
+int Raw_volume_subvolume_get_level_size(const struct Raw_volume_subvolume &subvolume,
+	int level, int size[3]);
+
+/**
+ * Allocates the image of <texture> to the size of <subvolume>, or the whole of
+ * the raw volume in <file_name> described by <format> if 0, at its pyramid level
+ * and copies it in slice by slice from a memory map of the file, so the volume
+ * is never decoded into a separate image. Only the file slices being read are
+ * kept in memory besides the texture and one texture slice. Components are
+ * stored in the format texture bytes per component, with short and float values,
+ * and unsigned short values stored in 1 byte, scaled from the format range.
+ * The source size, load time and the offset and scale giving source values from
+ * stored texels are recorded as texture properties. Rows and slices are stored
+ * in the texture in file order, the first row at the bottom.
+ * @return  1 on success, 0 on failure.
+ */
+int Texture_set_image_from_raw_volume(struct Texture *texture,
+	const char *file_name, const struct Raw_volume_format &format,
+	const struct Raw_volume_subvolume *subvolume);
+
+#endif /* !defined (GRAPHICS_TEXTURE_RAW_VOLUME_APP_HPP) */
@@ -4,8 +4,11 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+class Image_filter_package;
+
 int Computed_field_register_types_binary_erode_image_filter(
-	struct Computed_field_package *computed_field_package);
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package);
 /*******************************************************************************
 LAST MODIFIED : 13 July 2007
 
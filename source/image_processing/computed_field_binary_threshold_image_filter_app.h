@@ -5,6 +5,9 @@
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 
+class Image_filter_package;
+
 int Computed_field_register_types_binary_threshold_image_filter(
-	struct Computed_field_package *computed_field_package);
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package);
 
@@ -7,7 +7,10 @@
 #if !defined (COMPUTED_FIELD_CANNYEDGEDETECTIONFILTER_APP_H)
 #define COMPUTED_FIELD_CANNYEDGEDETECTIONFILTER_APP_H
 
+class Image_filter_package;
+
 int Computed_field_register_types_canny_edge_detection_image_filter(
-	struct Computed_field_package *computed_field_package);
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package);
 
 #endif /* !defined (COMPUTED_FIELD_CANNYEDGEDETECTIONFILTER_APP_H) */
@@ -14,6 +14,7 @@
 #include "computed_field/computed_field_set.h"
 #include "computed_field/computed_field_set_app.h"
 #include "image_processing/computed_field_curvature_anisotropic_diffusion_image_filter.h"
+#include "image_processing/image_filter_cache_app.hpp"
 
 const char computed_field_curvature_anisotropic_diffusion_image_filter_type_string[] = "curvature_anisotropic_diffusion_filter";
 
@@ -21,7 +22,7 @@ int cmzn_field_get_type_curvature_anisotropic_diffusion_image_filter(struct Comp
 	struct Computed_field **source_field, double *timeStep, double *conductance, int *numIterations);
 
 int define_Computed_field_type_curvature_anisotropic_diffusion_image_filter(struct Parse_state *state,
-	void *field_modify_void, void *)
+	void *field_modify_void, void *image_filter_package_void)
 /*******************************************************************************
 LAST MODIFIED : 18 October 2006
 
@@ -36,11 +37,15 @@ already) and allows its contents to be modified.
 	int numIterations;
 	struct Computed_field *source_field;
 	Computed_field_modify_data *field_modify = static_cast<Computed_field_modify_data *>(field_modify_void);
+	Image_filter_package *image_filter_package =
+		static_cast<Image_filter_package *>(image_filter_package_void);
+	Image_filter_options filter_options = { /*cache_flag*/0 };
+	cmzn_field_id existing_filter_field;
 	struct Option_table *option_table;
 	struct Set_Computed_field_conditional_data set_source_field_data;
 
 	ENTER(define_Computed_field_type_curvature_anisotropic_diffusion_image_filter);
-	if ((state) && (field_modify))
+	if ((state) && (field_modify) && (image_filter_package))
 	{
 		return_code = 1;
 		/* get valid parameters for projection field */
@@ -48,12 +53,14 @@ already) and allows its contents to be modified.
 		timeStep = 0.125;
 		conductance=3.0;
 		numIterations = 5;
-		if ((NULL != field_modify->get_field()) &&
+		existing_filter_field = image_filter_package->get_filter_field(
+			field_modify->get_field(), filter_options);
+		if ((NULL != existing_filter_field) &&
 			(computed_field_curvature_anisotropic_diffusion_image_filter_type_string ==
-				Computed_field_get_type_string(field_modify->get_field())))
+				Computed_field_get_type_string(existing_filter_field)))
 		{
 			return_code =
-				cmzn_field_get_type_curvature_anisotropic_diffusion_image_filter(field_modify->get_field(), &source_field,
+				cmzn_field_get_type_curvature_anisotropic_diffusion_image_filter(existing_filter_field, &source_field,
 					&timeStep, &conductance, &numIterations);
 		}
 		if (return_code)
@@ -85,6 +92,7 @@ already) and allows its contents to be modified.
 			Option_table_add_int_non_negative_entry(option_table, "num_iterations",
 																							(int*) &numIterations);
 
+			Option_table_add_image_filter_entries(option_table, &filter_options);
 			return_code = Option_table_multi_parse(option_table, state);
 			DESTROY(Option_table)(&option_table);
 
@@ -101,10 +109,10 @@ already) and allows its contents to be modified.
 			}
 			if (return_code)
 			{
-				return_code = field_modify->define_field(
+				return_code = image_filter_package->define_field(field_modify,
 					cmzn_fieldmodule_create_field_imagefilter_curvature_anisotropic_diffusion(
 						field_modify->get_field_module(),
-						source_field, timeStep, conductance, numIterations));
+						source_field, timeStep, conductance, numIterations), filter_options);
 			}
 
 			if (!return_code)
@@ -136,7 +144,8 @@ already) and allows its contents to be modified.
 } /* define_Computed_field_type_curvature_anisotropic_diffusion_image_filter */
 
 int Computed_field_register_types_curvature_anisotropic_diffusion_image_filter(
-	struct Computed_field_package *computed_field_package)
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package)
 /*******************************************************************************
 LAST MODIFIED : 18 October 2006
 
@@ -146,12 +155,12 @@ DESCRIPTION :
 	int return_code;
 
 	ENTER(Computed_field_register_types_curvature_anisotropic_diffusion_image_filter);
-	if (computed_field_package)
+	if ((computed_field_package) && (image_filter_package))
 	{
 		return_code = Computed_field_package_add_type(computed_field_package,
 			computed_field_curvature_anisotropic_diffusion_image_filter_type_string,
 			define_Computed_field_type_curvature_anisotropic_diffusion_image_filter,
-			Computed_field_package_get_simple_package(computed_field_package));
+			image_filter_package);
 	}
 	else
 	{
@@ -14,6 +14,7 @@
 #include "computed_field/computed_field_set.h"
 #include "computed_field/computed_field_set_app.h"
 #include "image_processing/computed_field_fast_marching_image_filter.h"
+#include "image_processing/image_filter_cache_app.hpp"
 
 const char computed_field_fast_marching_image_filter_type_string[] = "fast_marching_filter";
 
@@ -23,7 +24,7 @@ int cmzn_field_get_type_fast_marching_image_filter(struct Computed_field *field,
 		double **seed_values, int **output_size);
 
 int define_Computed_field_type_fast_marching_image_filter(struct Parse_state *state,
-	void *field_modify_void, void *)
+	void *field_modify_void, void *image_filter_package_void)
 /*******************************************************************************
 LAST MODIFIED : 30 August 2006
 
@@ -45,11 +46,15 @@ already) and allows its contents to be modified.
 
 	struct Computed_field *source_field;
 	Computed_field_modify_data *field_modify = static_cast<Computed_field_modify_data *>(field_modify_void);
+	Image_filter_package *image_filter_package =
+		static_cast<Image_filter_package *>(image_filter_package_void);
+	Image_filter_options filter_options = { /*cache_flag*/0 };
+	cmzn_field_id existing_filter_field;
 	struct Option_table *option_table;
 	struct Set_Computed_field_conditional_data set_source_field_data;
 
 	ENTER(define_Computed_field_type_fast_marching_image_filter);
-	if ((state) && (field_modify))
+	if ((state) && (field_modify) && (image_filter_package))
 	{
 		return_code = 1;
 
@@ -75,12 +80,14 @@ already) and allows its contents to be modified.
 		output_size[1] = 128;
 
 		/* get valid parameters for projection field */
-		if ((NULL != field_modify->get_field()) &&
+		existing_filter_field = image_filter_package->get_filter_field(
+			field_modify->get_field(), filter_options);
+		if ((NULL != existing_filter_field) &&
 			(computed_field_fast_marching_image_filter_type_string ==
-				Computed_field_get_type_string(field_modify->get_field())))
+				Computed_field_get_type_string(existing_filter_field)))
 		{
 			return_code =
-				cmzn_field_get_type_fast_marching_image_filter(field_modify->get_field(), &source_field,
+				cmzn_field_get_type_fast_marching_image_filter(existing_filter_field, &source_field,
 				  &stopping_value, &num_seed_points, &dimension, &seed_points, &seed_values, &output_size);
 		}
 		if (return_code)
@@ -126,6 +133,7 @@ already) and allows its contents to be modified.
 				Option_table_add_int_vector_entry(option_table, "output_size",
 																						 output_size, &dimension);
 
+				Option_table_add_image_filter_entries(option_table, &filter_options);
 				return_code = Option_table_multi_parse(option_table, state);
 				DESTROY(Option_table)(&option_table);
 			}
@@ -202,6 +210,7 @@ already) and allows its contents to be modified.
 				Option_table_add_int_vector_entry(option_table, "output_size",
 					output_size, &dimension);
 
+				Option_table_add_image_filter_entries(option_table, &filter_options);
 				return_code=Option_table_multi_parse(option_table,state);
 				DESTROY(Option_table)(&option_table);
 
@@ -220,11 +229,11 @@ already) and allows its contents to be modified.
 			}
 			if (return_code)
 			{
-				return_code = field_modify->define_field(
+				return_code = image_filter_package->define_field(field_modify,
 					cmzn_fieldmodule_create_field_imagefilter_fast_marching(
 						field_modify->get_field_module(),
 						source_field, stopping_value, num_seed_points, dimension,
-						seed_points, seed_values, output_size));
+						seed_points, seed_values, output_size), filter_options);
 			}
 
 			if (!return_code)
@@ -270,7 +279,8 @@ already) and allows its contents to be modified.
 } /* define_Computed_field_type_fast_marching_image_filter */
 
 int Computed_field_register_types_fast_marching_image_filter(
-	struct Computed_field_package *computed_field_package)
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package)
 /*******************************************************************************
 LAST MODIFIED : 30 August 2006
 
@@ -280,12 +290,12 @@ DESCRIPTION :
 	int return_code;
 
 	ENTER(Computed_field_register_types_fast_marching_image_filter);
-	if (computed_field_package)
+	if ((computed_field_package) && (image_filter_package))
 	{
 		return_code = Computed_field_package_add_type(computed_field_package,
 			computed_field_fast_marching_image_filter_type_string,
 			define_Computed_field_type_fast_marching_image_filter,
-			Computed_field_package_get_simple_package(computed_field_package));
+			image_filter_package);
 	}
 	else
 	{
@@ -8,8 +8,11 @@
 #if !defined (COMPUTED_FIELD_RESCALEINTENSITYIMAGEFILTER_APP_H)
 #define COMPUTED_FIELD_RESCALEINTENSITYIMAGEFILTER_APP_H
 
+class Image_filter_package;
+
 int Computed_field_register_types_rescale_intensity_image_filter(
-	struct Computed_field_package *computed_field_package);
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package);
 /*******************************************************************************
 LAST MODIFIED : 18 Nov 2006
 
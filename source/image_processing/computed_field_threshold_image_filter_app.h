@@ -13,7 +13,10 @@
 
 PROTOTYPE_OPTION_TABLE_ADD_ENUMERATOR_FUNCTION(cmzn_field_imagefilter_threshold_condition);
 
+class Image_filter_package;
+
 int Computed_field_register_types_threshold_image_filter(
-	struct Computed_field_package *computed_field_package);
+	struct Computed_field_package *computed_field_package,
+	Image_filter_package *image_filter_package);
 
 #endif
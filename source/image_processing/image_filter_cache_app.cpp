@@ -0,0 +1,308 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#include <cstdio>
+#include <cstring>
+#include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldmodule.h"
+#include "opencmiss/zinc/region.h"
+#include "general/debug.h"
+#include "general/message.h"
+#include "general/mystring.h"
+#include "command/parser.h"
+#include "computed_field/computed_field.h"
+#include "computed_field/computed_field_private.hpp"
+#include "image_processing/image_filter_cache_app.hpp"
+
+/** Options and cache statistics for one image filter field. */
+class Image_filter_cache_entry
+{
+	cmzn_field_id field;
+	Image_filter_options options;
+	char *key; // command string of field parameters when cached
+	cmzn_fieldmodulenotifier_id notifier;
+	int invalidated_count; // changes to filter sources, output recomputed when next evaluated
+	int unrelated_change_count; // other changes in region, output kept
+	int redefinition_count; // redefined with identical parameters, output kept
+
+	Image_filter_cache_entry(const Image_filter_cache_entry&);
+	Image_filter_cache_entry& operator=(const Image_filter_cache_entry&);
+
+	static void field_module_callback(cmzn_fieldmoduleevent_id event,
+		void *entry_void);
+
+public:
+
+	/** Takes over reference to <keyIn>. */
+	Image_filter_cache_entry(cmzn_field_id fieldIn,
+			const Image_filter_options &optionsIn, char *keyIn) :
+		field(cmzn_field_access(fieldIn)),
+		options(optionsIn),
+		key(keyIn),
+		notifier(0),
+		invalidated_count(0),
+		unrelated_change_count(0),
+		redefinition_count(0)
+	{
+		if (this->options.cache_flag)
+		{
+			cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(this->field);
+			this->notifier = cmzn_fieldmodule_create_fieldmodulenotifier(field_module);
+			cmzn_fieldmodulenotifier_set_callback(this->notifier,
+				Image_filter_cache_entry::field_module_callback, static_cast<void *>(this));
+			cmzn_fieldmodule_destroy(&field_module);
+		}
+	}
+
+	~Image_filter_cache_entry()
+	{
+		if (this->notifier)
+		{
+			cmzn_fieldmodulenotifier_clear_callback(this->notifier);
+			cmzn_fieldmodulenotifier_destroy(&this->notifier);
+		}
+		if (this->key)
+		{
+			DEALLOCATE(this->key);
+		}
+		cmzn_field_destroy(&this->field);
+	}
+
+	cmzn_field_id get_field() const
+	{
+		return this->field;
+	}
+
+	const Image_filter_options &get_options() const
+	{
+		return this->options;
+	}
+
+	/** @return  True if cached with the parameters in <keyIn>. */
+	bool has_cached_output(const char *keyIn) const
+	{
+		return this->options.cache_flag && this->key && keyIn &&
+			(0 == strcmp(this->key, keyIn));
+	}
+
+	/** Records a redefinition which kept the field and its output. */
+	void keep_output(const Image_filter_options &optionsIn)
+	{
+		this->options = optionsIn;
+		++this->redefinition_count;
+	}
+
+	void list() const;
+};
+
+void Image_filter_cache_entry::field_module_callback(cmzn_fieldmoduleevent_id event,
+	void *entry_void)
+{
+	Image_filter_cache_entry *entry = static_cast<Image_filter_cache_entry *>(entry_void);
+	const cmzn_field_change_flags change_flags =
+		cmzn_fieldmoduleevent_get_field_change_flags(event, entry->field);
+	/* the first output is computed after the change adding the filter */
+	if (change_flags & CMZN_FIELD_CHANGE_FLAG_ADD)
+		return;
+	if (change_flags & CMZN_FIELD_CHANGE_FLAG_RESULT)
+		++entry->invalidated_count;
+	else
+		++entry->unrelated_change_count;
+}
+
+void Image_filter_cache_entry::list() const
+{
+	cmzn_fieldmodule_id field_module = cmzn_field_get_fieldmodule(this->field);
+	cmzn_region_id region = cmzn_fieldmodule_get_region(field_module);
+	char *region_path = cmzn_region_get_path(region);
+	int error = 0;
+	append_string(&region_path, CMZN_REGION_PATH_SEPARATOR_STRING, &error, /*prefix*/true);
+	char *field_name = cmzn_field_get_name(this->field);
+	display_message(INFORMATION_MESSAGE, "  %s%s%s : %s",
+		region_path, (strlen(region_path) > 1) ? CMZN_REGION_PATH_SEPARATOR_STRING : "",
+		field_name, Computed_field_get_type_string(this->field));
+	if (this->options.cache_flag)
+	{
+		/* the output has the native resolution of the filter, one double per value */
+		int dimension = 0, *sizes = 0;
+		double number_of_values = cmzn_field_get_number_of_components(this->field);
+		struct Computed_field *texture_coordinate_field = 0;
+		char size_string[80] = "of unknown size";
+		if (Computed_field_get_native_resolution(this->field, &dimension, &sizes,
+			&texture_coordinate_field) && (0 < dimension) && (dimension <= 3))
+		{
+			int length = 0;
+			for (int i = 0; i < dimension; ++i)
+			{
+				number_of_values *= static_cast<double>(sizes[i]);
+				length += sprintf(size_string + length, (0 == i) ? "%d" : "x%d", sizes[i]);
+			}
+			sprintf(size_string + length, " (%g kB)", number_of_values*sizeof(double)/1024.0);
+		}
+		if (sizes)
+		{
+			DEALLOCATE(sizes);
+		}
+		display_message(INFORMATION_MESSAGE,
+			" cache %s kept %d (%d unrelated changes, %d identical redefinitions)"
+			" invalidated %d\n", size_string,
+			this->unrelated_change_count + this->redefinition_count,
+			this->unrelated_change_count, this->redefinition_count, this->invalidated_count);
+	}
+	else
+	{
+		display_message(INFORMATION_MESSAGE, " no cache\n");
+	}
+	DEALLOCATE(field_name);
+	DEALLOCATE(region_path);
+	cmzn_region_destroy(&region);
+	cmzn_fieldmodule_destroy(&field_module);
+}
+
+Image_filter_package::~Image_filter_package()
+{
+	for (std::list<Image_filter_cache_entry *>::iterator iter = this->entries.begin();
+		iter != this->entries.end(); ++iter)
+	{
+		delete *iter;
+	}
+}
+
+Image_filter_cache_entry *Image_filter_package::find_entry(cmzn_field_id field)
+{
+	this->remove_entry(0);
+	for (std::list<Image_filter_cache_entry *>::iterator iter = this->entries.begin();
+		iter != this->entries.end(); ++iter)
+	{
+		if ((*iter)->get_field() == field)
+			return *iter;
+	}
+	return 0;
+}
+
+/**
+ * Removes the entry for <field> if any, and entries for fields no longer
+ * managed so fields marked for destruction are released.
+ */
+void Image_filter_package::remove_entry(cmzn_field_id field)
+{
+	std::list<Image_filter_cache_entry *>::iterator iter = this->entries.begin();
+	while (iter != this->entries.end())
+	{
+		if (((*iter)->get_field() == field) || (!cmzn_field_is_managed((*iter)->get_field())))
+		{
+			delete *iter;
+			iter = this->entries.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+cmzn_field_id Image_filter_package::get_filter_field(cmzn_field_id field,
+	Image_filter_options &options)
+{
+	if (!field)
+		return 0;
+	Image_filter_cache_entry *entry = this->find_entry(field);
+	if (entry)
+		options = entry->get_options();
+	return field;
+}
+
+int Image_filter_package::define_field(Computed_field_modify_data *field_modify,
+	cmzn_field_id filter_field, const Image_filter_options &options)
+{
+	if (!(field_modify && filter_field))
+	{
+		cmzn_field_destroy(&filter_field);
+		return 0;
+	}
+	char *key = 0;
+	if (options.cache_flag)
+	{
+		key = filter_field->core->get_command_string();
+		Image_filter_cache_entry *entry = this->find_entry(field_modify->get_field());
+		if (entry && entry->has_cached_output(key))
+		{
+			entry->keep_output(options);
+			cmzn_field_destroy(&filter_field);
+			DEALLOCATE(key);
+			return 1;
+		}
+	}
+	this->remove_entry(field_modify->get_field());
+	if (!field_modify->define_field(filter_field))
+	{
+		if (key)
+		{
+			DEALLOCATE(key);
+		}
+		return 0;
+	}
+	this->entries.push_back(new Image_filter_cache_entry(field_modify->get_field(),
+		options, key));
+	return 1;
+}
+
+void Image_filter_package::list()
+{
+	this->remove_entry(0);
+	if (this->entries.empty())
+	{
+		display_message(INFORMATION_MESSAGE, "No image filter fields\n");
+		return;
+	}
+	display_message(INFORMATION_MESSAGE, "Image filter fields:\n");
+	for (std::list<Image_filter_cache_entry *>::iterator iter = this->entries.begin();
+		iter != this->entries.end(); ++iter)
+	{
+		(*iter)->list();
+	}
+}
+
+void Option_table_add_image_filter_entries(struct Option_table *option_table,
+	Image_filter_options *options)
+{
+	/* cache/no_cache */
+	Option_table_add_switch(option_table, "cache", "no_cache", &options->cache_flag);
+}
+
+int gfx_list_image_filters(struct Parse_state *state,
+	void *dummy_to_be_modified, void *image_filter_package_void)
+{
+	int return_code;
+	USE_PARAMETER(dummy_to_be_modified);
+	Image_filter_package *image_filter_package =
+		static_cast<Image_filter_package *>(image_filter_package_void);
+	if (state && image_filter_package)
+	{
+		struct Option_table *option_table = CREATE(Option_table)();
+		Option_table_add_help(option_table,
+			"Lists the cache setting of each image filter field. Each filter "
+			"field holds its output image, in the filter's own precision, until "
+			"its source fields change. For filters defined with the cache option, "
+			"the size of the output is listed with the number of times it was "
+			"kept, for changes not affecting the filter's source fields and for "
+			"redefinitions with identical parameters, and the number of times it "
+			"was invalidated by a change to the sources, to be recomputed when "
+			"the filter is next evaluated. Filters are run by Zinc with ITK's "
+			"default number of threads; there is no per-filter thread setting.");
+		return_code = Option_table_multi_parse(option_table, state);
+		DESTROY(Option_table)(&option_table);
+		if (return_code)
+		{
+			image_filter_package->list();
+		}
+	}
+	else
+	{
+		display_message(ERROR_MESSAGE, "gfx_list_image_filters.  Invalid argument(s)");
+		return_code = 0;
+	}
+	return (return_code);
+}
@@ -0,0 +1,84 @@
+/* OpenCMISS-Cmgui Application
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+#if !defined (IMAGE_FILTER_CACHE_APP_HPP)
+#define IMAGE_FILTER_CACHE_APP_HPP
+
+#include <list>
+#include "opencmiss/zinc/types/fieldid.h"
+#include "computed_field/computed_field_app.h"
+
+struct Option_table;
+struct Parse_state;
+class Image_filter_cache_entry;
+
+/** Options common to all image filter field definition commands. */
+struct Image_filter_options
+{
+	/** If set, redefining the filter with identical parameters keeps the filter
+	 * and the output it holds. */
+	int cache_flag;
+};
+
+/**
+ * Type package shared by the ITK image filter field types. Records the options
+ * each filter field was defined with and counts changes seen by filters
+ * defined with the cache option. A filter field holds its output image in the
+ * filter's own precision until its source fields change; with the cache option
+ * redefining it with the same parameters keeps the field unchanged so the
+ * output is not recomputed.
+ */
+class Image_filter_package : public Computed_field_type_package
+{
+	std::list<Image_filter_cache_entry *> entries;
+
+	Image_filter_cache_entry *find_entry(cmzn_field_id field);
+
+	void remove_entry(cmzn_field_id field);
+
+public:
+
+	/**
+	 * Gets the options <field> was defined with. Options are left unchanged if
+	 * the field was not defined here.
+	 * @return  <field>, not accessed.
+	 */
+	cmzn_field_id get_filter_field(cmzn_field_id field, Image_filter_options &options);
+
+	/**
+	 * Defines the field being modified as <filter_field>, unless the cache
+	 * option is set and it is already a filter with identical parameters. Takes
+	 * over the reference to <filter_field>, which may be 0 on failure to create
+	 * it.
+	 * @return  1 on success, 0 on failure.
+	 */
+	int define_field(Computed_field_modify_data *field_modify,
+		cmzn_field_id filter_field, const Image_filter_options &options);
+
+	/** Lists the options and cache statistics of each image filter field. */
+	void list();
+
+protected:
+
+	~Image_filter_package();
+};
+
+/**
+ * Adds the cache option common to all image filter definition commands to
+ * <option_table>, setting values in <options>.
+ */
+void Option_table_add_image_filter_entries(struct Option_table *option_table,
+	Image_filter_options *options);
+
+/**
+ * Executes a GFX LIST IMAGE_FILTERS command, listing the cache setting of each
+ * image filter field with the size of its output and how often the output was
+ * kept or invalidated.
+ * @param image_filter_package_void  The Image_filter_package.
+ */
+int gfx_list_image_filters(struct Parse_state *state,
+	void *dummy_to_be_modified, void *image_filter_package_void);
+
+#endif /* !defined (IMAGE_FILTER_CACHE_APP_HPP) */
@@ -4,20 +4,385 @@
 * License, v. 2.0. If a copy of the MPL was not distributed with this
 * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
 #include "opencmiss/zinc/field.h"
+#include "opencmiss/zinc/fieldcache.h"
 #include "opencmiss/zinc/fieldmodule.h"
 #include "opencmiss/zinc/fieldgroup.h"
 #include "opencmiss/zinc/optimisation.h"
 #include "opencmiss/zinc/region.h"
 #include "opencmiss/zinc/status.h"
+#include "computed_field/computed_field_private.hpp"
 #include "general/debug.h"
 #include "general/message.h"
+#include "general/mystring.h"
 #include "command/parser.h"
 #include "general/enumerator.h"
 #include "general/enumerator_private.hpp"
 #include "region/cmiss_region_app.h"
 #include "minimise/minimise.h"
 
+namespace {
+
+const char computed_field_minimise_objective_type_string[] = "minimise_objective";
+
+/** Time and value of one evaluation of an objective field. */
+struct Minimise_evaluation
+{
+	int objective_index;
+	double seconds; // since the optimisation started
+	double evaluation_seconds;
+	double value;
+};
+
+/**
+ * Evaluations of the objective fields of one optimisation, in order. Shared by
+ * the cores of the fields wrapping the objectives and their copies so it
+ * outlives them.
+ */
+class Minimise_evaluation_log
+{
+	std::chrono::steady_clock::time_point start_time;
+	std::vector<Minimise_evaluation> evaluations;
+
+public:
+
+	Minimise_evaluation_log() :
+		start_time(std::chrono::steady_clock::now())
+	{
+	}
+
+	void start()
+	{
+		this->evaluations.clear();
+		this->start_time = std::chrono::steady_clock::now();
+	}
+
+	double get_seconds(std::chrono::steady_clock::time_point time) const
+	{
+		return std::chrono::duration<double>(time - this->start_time).count();
+	}
+
+	void add(int objective_index, std::chrono::steady_clock::time_point begin, double value)
+	{
+		const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		Minimise_evaluation evaluation = { objective_index, this->get_seconds(end),
+			std::chrono::duration<double>(end - begin).count(), value };
+		this->evaluations.push_back(evaluation);
+	}
+
+	const std::vector<Minimise_evaluation>& get_evaluations() const
+	{
+		return this->evaluations;
+	}
+};
+
+/**
+ * Core of a field wrapping an objective field of gfx minimise. Its values and
+ * least squares terms are those of the objective, and each evaluation is
+ * timed and logged with the sum of the values or of the squared terms. Field
+ * caches only re-evaluate it after the optimiser changes parameters, so each
+ * log entry is one objective function evaluation.
+ */
+class Computed_field_minimise_objective : public Computed_field_core
+{
+	std::shared_ptr<Minimise_evaluation_log> log;
+	int objective_index;
+
+public:
+
+	Computed_field_minimise_objective(
+		const std::shared_ptr<Minimise_evaluation_log> &logIn, int objective_indexIn) :
+		Computed_field_core(),
+		log(logIn),
+		objective_index(objective_indexIn)
+	{
+	}
+
+	Computed_field_core *copy()
+	{
+		return new Computed_field_minimise_objective(this->log, this->objective_index);
+	}
+
+	const char *get_type_string()
+	{
+		return (computed_field_minimise_objective_type_string);
+	}
+
+	int compare(Computed_field_core *other_core)
+	{
+		Computed_field_minimise_objective *other =
+			dynamic_cast<Computed_field_minimise_objective *>(other_core);
+		return (other && (other->log == this->log) &&
+			(other->objective_index == this->objective_index)) ? 1 : 0;
+	}
+
+	int evaluate(cmzn_fieldcache& cache, FieldValueCache& inValueCache)
+	{
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		RealFieldValueCache& valueCache = RealFieldValueCache::cast(inValueCache);
+		const RealFieldValueCache *sourceCache = RealFieldValueCache::cast(getSourceField(0)->evaluate(cache));
+		if (!sourceCache)
+			return 0;
+		valueCache.copyValues(*sourceCache);
+		double value = 0.0;
+		for (int c = 0; c < this->field->number_of_components; ++c)
+			value += valueCache.values[c];
+		this->log->add(this->objective_index, begin, value);
+		return 1;
+	}
+
+	bool supports_sum_square_terms() const
+	{
+		return getSourceField(0)->core->supports_sum_square_terms();
+	}
+
+	int get_number_of_sum_square_terms(cmzn_fieldcache& cache) const
+	{
+		return getSourceField(0)->core->get_number_of_sum_square_terms(cache);
+	}
+
+	int evaluate_sum_square_terms(cmzn_fieldcache& cache, RealFieldValueCache& valueCache,
+		int number_of_values, FE_value *values)
+	{
+		USE_PARAMETER(valueCache);
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		cmzn_field *source_field = getSourceField(0);
+		RealFieldValueCache *sourceCache = RealFieldValueCache::cast(source_field->getValueCache(cache));
+		if (!(sourceCache && source_field->core->evaluate_sum_square_terms(
+			cache, *sourceCache, number_of_values, values)))
+			return 0;
+		double value = 0.0;
+		for (int i = 0; i < number_of_values; ++i)
+			value += values[i]*values[i];
+		this->log->add(this->objective_index, begin, value);
+		return 1;
+	}
+
+	int list()
+	{
+		char *source_name = cmzn_field_get_name(getSourceField(0));
+		display_message(INFORMATION_MESSAGE, "    objective field : %s\n", source_name);
+		cmzn_deallocate(source_name);
+		return 1;
+	}
+
+	char *get_command_string()
+	{
+		char *command_string = 0;
+		int error = 0;
+		append_string(&command_string, get_type_string(), &error);
+		append_string(&command_string, " field ", &error);
+		char *source_name = cmzn_field_get_name(getSourceField(0));
+		make_valid_token(&source_name);
+		append_string(&command_string, source_name, &error);
+		cmzn_deallocate(source_name);
+		return command_string;
+	}
+};
+
+/**
+ * Records the objective values before and after an optimisation, the time it
+ * takes, and the value and time of each objective evaluation. Zinc's
+ * optimiser runs its iterations internally with no progress callback, so the
+ * objective fields are wrapped in fields logging each evaluation.
+ */
+class Minimise_history
+{
+	cmzn_fieldmodule_id field_module;
+	std::vector<cmzn_field_id> objective_fields;
+	int number_of_objective_values;
+	std::shared_ptr<Minimise_evaluation_log> log;
+	double total_seconds;
+	std::vector<double> initial_values; // per objective field then total; empty if undefined
+	std::vector<double> final_values; // as for initial_values
+
+	Minimise_history(const Minimise_history&);
+	Minimise_history& operator=(const Minimise_history&);
+
+public:
+
+	Minimise_history(cmzn_fieldmodule_id field_moduleIn);
+
+	~Minimise_history();
+
+	/**
+	 * Adds an objective field; objective values are the sum of its components.
+	 * @param record_evaluations  If true, return a field wrapping <field> which
+	 * logs each evaluation, otherwise return <field>.
+	 * @return  Accessed field to give the optimiser as objective.
+	 */
+	cmzn_field_id add_objective_field(cmzn_field_id field, bool record_evaluations);
+
+	/**
+	 * Evaluates each objective field into <values>, followed by their total.
+	 * @return  true on success, false if any is not defined.
+	 */
+	bool evaluate_objectives(std::vector<double>& values);
+
+	/** Records the objectives before the optimisation and starts timing. */
+	void start();
+
+	/** Stops timing and records the objectives after the optimisation. */
+	void finish();
+
+	/**
+	 * Writes CSV file <file_name> with a header and a row for the initial
+	 * value of each objective field followed by a row for each evaluation
+	 * logged, with its number, the time since the start, the time it took and
+	 * the objective value.
+	 */
+	bool write_csv(const char *file_name) const;
+
+	/** Displays the time taken, the evaluations logged and the change in objective. */
+	void list_summary() const;
+};
+
+Minimise_history::Minimise_history(cmzn_fieldmodule_id field_moduleIn) :
+	field_module(cmzn_fieldmodule_access(field_moduleIn)),
+	number_of_objective_values(0),
+	log(std::make_shared<Minimise_evaluation_log>()),
+	total_seconds(0.0)
+{
+}
+
+Minimise_history::~Minimise_history()
+{
+	for (size_t i = 0; i < this->objective_fields.size(); ++i)
+		cmzn_field_destroy(&this->objective_fields[i]);
+	cmzn_fieldmodule_destroy(&this->field_module);
+}
+
+cmzn_field_id Minimise_history::add_objective_field(cmzn_field_id field,
+	bool record_evaluations)
+{
+	const int objective_index = this->number_of_objective_values;
+	this->objective_fields.push_back(cmzn_field_access(field));
+	this->number_of_objective_values = static_cast<int>(this->objective_fields.size());
+	if (!record_evaluations)
+		return cmzn_field_access(field);
+	return Computed_field_create_generic(this->field_module,
+		/*check_source_field_existence*/true,
+		cmzn_field_get_number_of_components(field),
+		/*number_of_source_fields*/1, &field,
+		/*number_of_source_values*/0, NULL,
+		new Computed_field_minimise_objective(this->log, objective_index));
+}
+
+bool Minimise_history::evaluate_objectives(std::vector<double>& values)
+{
+	values.assign(this->number_of_objective_values + 1, 0.0);
+	double total = 0.0;
+	std::vector<double> field_values;
+	/* a new cache so no values from before the optimisation are reused */
+	cmzn_fieldcache_id field_cache = cmzn_fieldmodule_create_fieldcache(this->field_module);
+	bool result = true;
+	for (int i = 0; i < this->number_of_objective_values; ++i)
+	{
+		cmzn_field_id field = this->objective_fields[i];
+		const int number_of_components = cmzn_field_get_number_of_components(field);
+		field_values.resize(number_of_components);
+		if (CMZN_OK != cmzn_field_evaluate_real(field, field_cache,
+			number_of_components, field_values.data()))
+		{
+			result = false;
+			break;
+		}
+		for (int c = 0; c < number_of_components; ++c)
+			values[i] += field_values[c];
+		total += values[i];
+	}
+	cmzn_fieldcache_destroy(&field_cache);
+	if (result)
+		values[this->number_of_objective_values] = total;
+	else
+		values.clear();
+	return result;
+}
+
+void Minimise_history::start()
+{
+	this->final_values.clear();
+	this->evaluate_objectives(this->initial_values);
+	this->log->start();
+}
+
+void Minimise_history::finish()
+{
+	this->total_seconds = this->log->get_seconds(std::chrono::steady_clock::now());
+	this->evaluate_objectives(this->final_values);
+}
+
+bool Minimise_history::write_csv(const char *file_name) const
+{
+	FILE *file = fopen(file_name, "w");
+	if (!file)
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx minimise:  Could not open history file %s", file_name);
+		return false;
+	}
+	fprintf(file, "evaluation,objective_field,seconds,evaluation_seconds,value\n");
+	std::vector<char *> names(this->number_of_objective_values);
+	for (int i = 0; i < this->number_of_objective_values; ++i)
+	{
+		names[i] = cmzn_field_get_name(this->objective_fields[i]);
+		/* undefined objectives are written as nan to keep the columns aligned */
+		fprintf(file, "0,%s,0,0,%.17g\n", names[i],
+			this->initial_values.empty() ? NAN : this->initial_values[i]);
+	}
+	std::vector<int> counts(this->number_of_objective_values, 0);
+	const std::vector<Minimise_evaluation>& evaluations = this->log->get_evaluations();
+	for (size_t e = 0; e < evaluations.size(); ++e)
+	{
+		const Minimise_evaluation& evaluation = evaluations[e];
+		fprintf(file, "%d,%s,%.9g,%.9g,%.17g\n", ++counts[evaluation.objective_index],
+			names[evaluation.objective_index], evaluation.seconds,
+			evaluation.evaluation_seconds, evaluation.value);
+	}
+	for (int i = 0; i < this->number_of_objective_values; ++i)
+		cmzn_deallocate(names[i]);
+	const bool result = (0 == ferror(file));
+	if (0 != fclose(file) || !result)
+	{
+		display_message(ERROR_MESSAGE,
+			"gfx minimise:  Error writing history file %s", file_name);
+		return false;
+	}
+	return true;
+}
+
+void Minimise_history::list_summary() const
+{
+	display_message(INFORMATION_MESSAGE, "Optimisation time %g s\n", this->total_seconds);
+	const std::vector<Minimise_evaluation>& evaluations = this->log->get_evaluations();
+	if (!evaluations.empty())
+	{
+		double evaluation_seconds = 0.0;
+		for (size_t e = 0; e < evaluations.size(); ++e)
+			evaluation_seconds += evaluations[e].evaluation_seconds;
+		display_message(INFORMATION_MESSAGE, "%d objective evaluations taking %g s\n",
+			static_cast<int>(evaluations.size()), evaluation_seconds);
+	}
+	if (!this->initial_values.empty())
+	{
+		display_message(INFORMATION_MESSAGE, "Initial objective %.12g",
+			this->initial_values[this->number_of_objective_values]);
+		if (!this->final_values.empty())
+		{
+			display_message(INFORMATION_MESSAGE, ", final objective %.12g",
+				this->final_values[this->number_of_objective_values]);
+		}
+		display_message(INFORMATION_MESSAGE, "\n");
+	}
+}
+
+} // anonymous namespace
+
 int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 	void *root_region_void)
 {
@@ -30,6 +395,7 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 		int maxIters = 100; // default value
 		int showReport = 1; // output solution report by default
 		const char *optimisation_method_string = 0;
+		char *history_file_name = 0;
 		Multiple_strings conditionalFieldNames;
 		Multiple_strings dependentFieldNames;
 		Multiple_strings objectiveFieldNames;
@@ -49,13 +415,23 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 			"special behaviour with the LEAST_SQUARES_QUASI_NEWTON solution method, "
 			"supplying individual terms for the least squares solution, useful for "
 			"least squares fitting problems. NEWTON method only works with a finite "
-			"element dependent field and no conditional fields.");
+			"element dependent field and no conditional fields. "
+			"The time taken, the number and time of objective evaluations and the "
+			"initial and final objective are listed with the output. history_file "
+			"writes a CSV file with a row for the initial value of each objective "
+			"field then a row for each evaluation the optimiser makes, with its "
+			"number, the time since the start, the time it took and the value "
+			"(the sum of squares of the terms for LEAST_SQUARES_QUASI_NEWTON). "
+			"Evaluations are not recorded with the NEWTON method.");
 		/* conditional_fields */
 		Option_table_add_multiple_strings_entry(option_table, "conditional_fields",
 			&conditionalFieldNames, "FIELD_NAME|none [& FIELD_NAME|none [& ...]]");
 		/* dependent field(s) */
 		Option_table_add_multiple_strings_entry(option_table, "dependent_fields",
 			&dependentFieldNames, "FIELD_NAME [& FIELD_NAME [& ...]]");
+		/* history_file */
+		Option_table_add_string_entry(option_table, "history_file",
+			&history_file_name, " FILE_NAME");
 		/* independent field(s) */
 		Option_table_add_multiple_strings_entry(option_table, "independent_fields",
 			&dependentFieldNames, "FIELD_NAME [& FIELD_NAME [& ...]] (DEPRECATED: use dependent_fields)");
@@ -87,6 +463,7 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 		{
 			cmzn_fieldmodule_id fieldModule = cmzn_region_get_fieldmodule(region);
 			cmzn_optimisation_id optimisation = cmzn_fieldmodule_create_optimisation(fieldModule);
+			Minimise_history history(fieldModule);
 			STRING_TO_ENUMERATOR(cmzn_optimisation_method)(
 				optimisation_method_string, &optimisation_method);
 			if (CMZN_OK != cmzn_optimisation_set_method(optimisation, optimisation_method))
@@ -134,12 +511,16 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 			{
 				cmzn_field_id objectiveField = cmzn_fieldmodule_find_field_by_name(
 					fieldModule, objectiveFieldNames.strings[i]);
-				if (CMZN_OK != cmzn_optimisation_add_objective_field(optimisation, objectiveField))
+				/* NEWTON evaluates derivatives of the objective, which are not logged */
+				cmzn_field_id optimisationField = (objectiveField) ? history.add_objective_field(
+					objectiveField, CMZN_OPTIMISATION_METHOD_NEWTON != optimisation_method) : 0;
+				if (CMZN_OK != cmzn_optimisation_add_objective_field(optimisation, optimisationField))
 				{
 					display_message(ERROR_MESSAGE, "gfx minimise:  Invalid or unrecognised objective field '%s'",
 						objectiveFieldNames.strings[i]);
 					return_code = 0;
 				}
+				cmzn_field_destroy(&optimisationField);
 				cmzn_field_destroy(&objectiveField);
 			}
 			if (CMZN_OK != cmzn_optimisation_set_attribute_integer(optimisation,
@@ -150,7 +531,9 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 			}
 			if (return_code)
 			{
+				history.start();
 				return_code = cmzn_optimisation_optimise(optimisation);
+				history.finish();
 				if (showReport)
 				{
 					char *report = cmzn_optimisation_get_solution_report(optimisation);
@@ -159,7 +542,10 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 						display_message_string(INFORMATION_MESSAGE, report);
 						DEALLOCATE(report);
 					}
+					history.list_summary();
 				}
+				if (history_file_name && !history.write_csv(history_file_name))
+					return_code = 0;
 				if (!return_code)
 				{
 					display_message(ERROR_MESSAGE, "gfx minimise.  Optimisation failed.");
@@ -169,6 +555,8 @@ int gfx_minimise(struct Parse_state *state, void *dummy_to_be_modified,
 			cmzn_fieldmodule_destroy(&fieldModule);
 		}
 		DESTROY(Option_table)(&option_table);
+		if (history_file_name)
+			DEALLOCATE(history_file_name);
 		cmzn_region_destroy(&region);
 	}
 	else